@@ -30,15 +30,8 @@ const int pwdn_pin = 27;
 const int start_pin = 14;
 const int chip_select = 17;
 
-unsigned long uecgtemp = 0;
 unsigned long resultTemp = 0;
 
-signed long secgtemp = 0;
-
-long status_byte=0;
-
-uint8_t LeadStatus=0;
-
 int j,i;
 
 void IRAM_ATTR ads1292r_interrupt_handler(void)
@@ -54,24 +47,7 @@ boolean ads1292r::getAds1292r_Data_if_Available(const int data_ready,const int c
      ads1292r_intr_flag = false;
      SPI_RX_Buff_Ptr = ads1292_Read_Data(chip_select); // Read the data,point the data to a pointer
      ads1292dataReceived = true;
-     
-     // Ignore ECG as source of resp calculation 
-     //uecgtemp = (unsigned long) (  ((unsigned long)SPI_RX_Buff_Ptr[3] << 16) | ( (unsigned long) SPI_RX_Buff_Ptr[4] << 8) |  (unsigned long) SPI_RX_Buff_Ptr[5]);
-     //uecgtemp = (unsigned long) (uecgtemp << 8);
-     //secgtemp = (signed long) (uecgtemp);
-     data_struct->raw_resp = 0; //secgtemp;
-     
-     // Raw ECG data 32 bits 
-     uecgtemp = (unsigned long) (  ((unsigned long)SPI_RX_Buff_Ptr[6] << 16) | ( (unsigned long) SPI_RX_Buff_Ptr[7] << 8) |  (unsigned long) SPI_RX_Buff_Ptr[8]);
-     uecgtemp = (unsigned long) (uecgtemp << 8);
-     secgtemp = (signed long) (uecgtemp);
-     secgtemp = (signed long) (secgtemp >> 8);
-     data_struct->raw_ecg = secgtemp;
-
-     status_byte = (long)((long)SPI_RX_Buff_Ptr[2] | ((long) SPI_RX_Buff_Ptr[1]) <<8 | ((long) SPI_RX_Buff_Ptr[0])<<16); // First 3 bytes represents the status
-     status_byte  = (status_byte & 0x0f8000) >> 15;  // bit15 gives the lead status
-     LeadStatus = (unsigned char ) status_byte ;
-     data_struct->status_reg = LeadStatus;
+     decode_frame((const uint8_t *)SPI_RX_Buff_Ptr, data_struct);
      ads1292dataReceived = false;
      SPI_RX_Buff_Count = 0;
      return true;
@@ -84,6 +60,22 @@ boolean ads1292r::getAds1292r_Data_if_Available(const int data_ready,const int c
 
 }
 
+// Unpack a 9 byte RDATAC frame - 24 bit status, channel 1 (resp), channel 2 (ECG)
+void ads1292r::decode_frame(const uint8_t *frame, ads1292r_data *data_struct)
+{
+     // Ignore ECG as source of resp calculation 
+     data_struct->raw_resp = 0;
+     
+     // Raw ECG data - sign extend 24 bits through a 32 bit int,
+     // as a long is wider than 32 bits off the ESP32
+     uint32_t uecg = ((uint32_t)frame[6] << 16) | ((uint32_t)frame[7] << 8) | (uint32_t)frame[8];
+     data_struct->raw_ecg = (signed long)((int32_t)(uecg << 8) >> 8);
+
+     uint32_t status = ((uint32_t)frame[0] << 16) | ((uint32_t)frame[1] << 8) | (uint32_t)frame[2]; // First 3 bytes represents the status
+     status = (status & 0x0f8000) >> 15;  // bit15 gives the lead status
+     data_struct->status_reg = (unsigned char)status;
+}
+
 char* ads1292r::ads1292_Read_Data(const int chip_select)
 {
   static char SPI_Dummy_Buff[10];
@@ -112,99 +104,97 @@ char* ads1292r::ads1292_Read_Data()
   return SPI_Dummy_Buff;
 }
 
+// Start up configuration - CONFIG1 to RESP2 in register order, for one WREG
+static const uint8_t ads1292_config[] = {
+  0x00,         //CONFIG1: Set sampling rate to 125 SPS
+  0b10100000,   //CONFIG2: Lead-off comp off, test signal disabled
+  0b00010000,   //LOFF: Lead-off defaults
+  0b01000000,   //CH1SET: Ch 1 enabled, gain 6, connected to electrode in
+  0b01100000,   //CH2SET: Ch 2 enabled, gain 6, connected to electrode in
+  0b00101100,   //RLDSENS: fmod/16, RLD enabled, RLD inputs from Ch2 only
+  0x00,         //LOFFSENS: all disabled
+  0x00,         //LOFFSTAT: clock divider as at reset, the rest is read only
+  0b11110010,   //RESP1: MOD/DEMOD turned only, phase 0
+  0b00000011,   //RESP2: Calib OFF, respiration freq defaults
+};
+
+// Read the configuration back - false if any register differs
+static bool ads1292_Config_Check(const int chip_select)
+{
+  uint8_t readback[sizeof(ads1292_config)];
+  ads1292r::ads1292_Reg_Read_Burst(ADS1292_REG_CONFIG1, readback, sizeof(readback), chip_select);
+  for (uint8_t i = 0; i < sizeof(ads1292_config); i++)
+  {
+    uint8_t address = ADS1292_REG_CONFIG1 + i;
+    // Only CLK_DIV in LOFF_STAT is ours, the lead off bits follow the electrodes
+    uint8_t mask = (address == ADS1292_REG_LOFFSTAT) ? 0x40 : 0xFF;
+    if ((readback[i] ^ ads1292r::reg_value(address, ads1292_config[i])) & mask)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reset, write the configuration in one burst and read it back
+// If it did not take the chip is powered down and up as it used to be
+// and written again. Conversions start either way
 bool ads1292r::ads1292_Init(const int chip_select,const int pwdn_pin,const int start_pin)
 {
-  // start the SPI library:
-  ads1292_Reset(pwdn_pin);
-  delay(100);
-  ads1292_Disable_Start(start_pin);
-  ads1292_Enable_Start(start_pin);
-  ads1292_Hard_Stop(start_pin);
-  ads1292_Start_Data_Conv_Command(chip_select);
-  ads1292_Soft_Stop(chip_select);
-  delay(50);
-  ads1292_Stop_Read_Data_Continuous(chip_select);					// SDATAC command
-  delay(300);
-  ads1292_Reg_Write(ADS1292_REG_CONFIG1, 0x00,chip_select); 		//Set sampling rate to 125 SPS
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CONFIG2, 0b10100000,chip_select);	//Lead-off comp off, test signal disabled
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_LOFF, 0b00010000,chip_select);		//Lead-off defaults
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CH1SET, 0b01000000,chip_select);	//Ch 1 enabled, gain 6, connected to electrode in
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CH2SET, 0b01100000,chip_select);	//Ch 2 enabled, gain 6, connected to electrode in
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_RLDSENS, 0b00101100,chip_select);	//RLD settings: fmod/16, RLD enabled, RLD inputs from Ch2 only
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_LOFFSENS, 0x00,chip_select);		//LOFF settings: all disabled
-  delay(10);													//Skip register 8, LOFF Settings default
-  ads1292_Reg_Write(ADS1292_REG_RESP1, 0b11110010,chip_select);		//Respiration: MOD/DEMOD turned only, phase 0
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_RESP2, 0b00000011,chip_select);		//Respiration: Calib OFF, respiration freq defaults
-  delay(10);
+  // No conversions while the registers change
+  digitalWrite(start_pin, LOW);
+  bool configured = false;
+  for (int attempt = 0; attempt < ADS1292_CONFIG_TRIES && !configured; attempt++)
+  {
+    if (attempt == 0)
+    {
+      ads1292_Reset_Pulse(pwdn_pin);
+    }
+    else
+    {
+      ads1292_Reset(pwdn_pin);
+    }
+    // Powers up in RDATAC, which ignores register commands
+    ads1292_Stop_Read_Data_Continuous(chip_select);					// SDATAC command
+    ads1292_Reg_Write_Burst(ADS1292_REG_CONFIG1, ads1292_config, sizeof(ads1292_config), chip_select);
+    configured = ads1292_Config_Check(chip_select);
+  }
   ads1292_Start_Read_Data_Continuous(chip_select);
-  delay(10);
-  ads1292_Enable_Start(start_pin); 
-  return true;
+  digitalWrite(start_pin, HIGH);
+  return configured;
 }
 
 void ads1292r::ads1292_Init()
 {
-  // start the SPI library:
-  ads1292_Reset();
-  delay(100);
-  ads1292_Disable_Start();
-  ads1292_Enable_Start();
-  ads1292_Hard_Stop();
-  ads1292_Start_Data_Conv_Command();
-  ads1292_Soft_Stop();
-  delay(50);
-  ads1292_Stop_Read_Data_Continuous();         // SDATAC command
-  delay(300);
-  ads1292_Reg_Write(ADS1292_REG_CONFIG1, 0x00);     //Set sampling rate to 125 SPS
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CONFIG2, 0b10100000); //Lead-off comp off, test signal disabled
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_LOFF, 0b00010000);    //Lead-off defaults
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CH1SET, 0b01000000);  //Ch 1 enabled, gain 6, connected to electrode in
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_CH2SET, 0b01100000);  //Ch 2 enabled, gain 6, connected to electrode in
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_RLDSENS, 0b00101100); //RLD settings: fmod/16, RLD enabled, RLD inputs from Ch2 only
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_LOFFSENS, 0x00);    //LOFF settings: all disabled
-  delay(10);                          //Skip register 8, LOFF Settings default
-  ads1292_Reg_Write(ADS1292_REG_RESP1, 0b11110010);   //Respiration: MOD/DEMOD turned only, phase 0
-  delay(10);
-  ads1292_Reg_Write(ADS1292_REG_RESP2, 0b00000011);   //Respiration: Calib OFF, respiration freq defaults
-  delay(10);
-  ads1292_Start_Read_Data_Continuous();
-  delay(10);
-  ads1292_Enable_Start(); 
+  ads1292_Init(chip_select, pwdn_pin, start_pin);
 }
 
-void ads1292r::ads1292_Reset(const int pwdn_pin)
+// Short PWDN/RESET pulse - resets the registers without powering down
+void ads1292r::ads1292_Reset_Pulse(const int pwdn_pin)
 {
   digitalWrite(pwdn_pin, HIGH);
-  delay(100);					// Wait 100 mSec
   digitalWrite(pwdn_pin, LOW);
-  delay(100);
+  delayMicroseconds(ADS1292_RESET_PULSE_US);
   digitalWrite(pwdn_pin, HIGH);
-  delay(100);
+  delayMicroseconds(ADS1292_RESET_WAIT_US);
 }
 
-void ads1292r::ads1292_Reset()
+// Held low long enough to power down, then a full power up
+void ads1292r::ads1292_Reset(const int pwdn_pin)
 {
   digitalWrite(pwdn_pin, HIGH);
-  delay(100);         // Wait 100 mSec
+  delay(100);					// Wait 100 mSec
   digitalWrite(pwdn_pin, LOW);
   delay(100);
   digitalWrite(pwdn_pin, HIGH);
   delay(100);
 }
 
+void ads1292r::ads1292_Reset()
+{
+  ads1292_Reset(pwdn_pin);
+}
+
 void ads1292r::ads1292_Disable_Start(const int start_pin)
 {
   digitalWrite(start_pin, LOW);
@@ -284,132 +274,93 @@ void ads1292r::ads1292_Stop_Read_Data_Continuous ()
 
 void ads1292r::ads1292_SPI_Command_Data(unsigned char data_in,const int chip_select)
 {
-  byte data[1];
-  digitalWrite(chip_select, LOW);
-  delay(2);
-  digitalWrite(chip_select, HIGH);
-  delay(2);
   digitalWrite(chip_select, LOW);
-  delay(2);
   SPI.transfer(data_in);
-  delay(2);
+  delayMicroseconds(ADS1292_DECODE_US);
   digitalWrite(chip_select, HIGH);
 }
 
 void ads1292r::ads1292_SPI_Command_Data(unsigned char data_in)
 {
-  byte data[1];
-  digitalWrite(chip_select, LOW);
-  delay(2);
-  digitalWrite(chip_select, HIGH);
-  delay(2);
-  digitalWrite(chip_select, LOW);
-  delay(2);
-  SPI.transfer(data_in);
-  delay(2);
-  digitalWrite(chip_select, HIGH);
+  ads1292_SPI_Command_Data(data_in, chip_select);
 }
 
-void ads1292r::ads1292_Reg_Write (unsigned char READ_WRITE_ADDRESS, unsigned char DATA,const int chip_select)
+uint8_t ads1292r::reg_value(uint8_t address, uint8_t data)
 {
-
-  switch (READ_WRITE_ADDRESS)
+  switch (address)
   {
     case 1:
-            DATA = DATA & 0x87;
+            data = data & 0x87;
 	          break;
     case 2:
-            DATA = DATA & 0xFB;
-	          DATA |= 0x80;
+            data = data & 0xFB;
+	          data |= 0x80;
 	          break;
     case 3:
-      	    DATA = DATA & 0xFD;
-      	    DATA |= 0x10;
+      	    data = data & 0xFD;
+      	    data |= 0x10;
       	    break;
     case 7:
-      	    DATA = DATA & 0x3F;
+      	    data = data & 0x3F;
       	    break;
     case 8:
-    	      DATA = DATA & 0x5F;
+    	      data = data & 0x5F;
 	          break;
     case 9:
-      	    DATA |= 0x02;
+      	    data |= 0x02;
       	    break;
     case 10:
-      	    DATA = DATA & 0x87;
-      	    DATA |= 0x01;
+      	    data = data & 0x87;
+      	    data |= 0x01;
       	    break;
     case 11:
-      	    DATA = DATA & 0x0F;
+      	    data = data & 0x0F;
       	    break;
     default:
             break;
   }
-  // now combine the register address and the command into one byte:
-  byte dataToSend = READ_WRITE_ADDRESS | WREG;
-  digitalWrite(chip_select, LOW);
-  delay(2);
-  digitalWrite(chip_select, HIGH);
-  delay(2);
-  // take the chip select low to select the device:
-  digitalWrite(chip_select, LOW);
-  delay(2);
-  SPI.transfer(dataToSend); //Send register location
-  SPI.transfer(0x00);		//number of register to wr
-  SPI.transfer(DATA);		//Send value to record into register
-  delay(2);
-  // take the chip select high to de-select:
-  digitalWrite(chip_select, HIGH);
+  return data;
+}
+
+void ads1292r::ads1292_Reg_Write (unsigned char READ_WRITE_ADDRESS, unsigned char DATA,const int chip_select)
+{
+  ads1292_Reg_Write_Burst(READ_WRITE_ADDRESS, &DATA, 1, chip_select);
 }
 
 void ads1292r::ads1292_Reg_Write (unsigned char READ_WRITE_ADDRESS, unsigned char DATA)
 {
+  ads1292_Reg_Write_Burst(READ_WRITE_ADDRESS, &DATA, 1, chip_select);
+}
 
-  switch (READ_WRITE_ADDRESS)
+// One byte of a multi-byte command - the ADS1292R needs 4 tCLK to take
+// in each byte before the next one starts
+static uint8_t ads1292_Command_Byte(uint8_t data)
+{
+  uint8_t in = SPI.transfer(data);
+  delayMicroseconds(ADS1292_DECODE_US);
+  return in;
+}
+
+void ads1292r::ads1292_Reg_Write_Burst (uint8_t first, const uint8_t *data, uint8_t count, const int chip_select)
+{
+  digitalWrite(chip_select, LOW);
+  ads1292_Command_Byte(first | WREG);   //Send first register location
+  ads1292_Command_Byte(count - 1);      //number of registers less one
+  for (uint8_t i = 0; i < count; i++)
   {
-    case 1:
-            DATA = DATA & 0x87;
-            break;
-    case 2:
-            DATA = DATA & 0xFB;
-            DATA |= 0x80;
-            break;
-    case 3:
-            DATA = DATA & 0xFD;
-            DATA |= 0x10;
-            break;
-    case 7:
-            DATA = DATA & 0x3F;
-            break;
-    case 8:
-            DATA = DATA & 0x5F;
-            break;
-    case 9:
-            DATA |= 0x02;
-            break;
-    case 10:
-            DATA = DATA & 0x87;
-            DATA |= 0x01;
-            break;
-    case 11:
-            DATA = DATA & 0x0F;
-            break;
-    default:
-            break;
+    ads1292_Command_Byte(reg_value(first + i, data[i]));
   }
-  // now combine the register address and the command into one byte:
-  byte dataToSend = READ_WRITE_ADDRESS | WREG;
-  digitalWrite(chip_select, LOW);
-  delay(2);
   digitalWrite(chip_select, HIGH);
-  delay(2);
-  // take the chip select low to select the device:
+}
+
+void ads1292r::ads1292_Reg_Read_Burst (uint8_t first, uint8_t *data, uint8_t count, const int chip_select)
+{
   digitalWrite(chip_select, LOW);
-  delay(2);
-  SPI.transfer(dataToSend); //Send register location
-  SPI.transfer(0x00);   //number of register to wr
-  SPI.transfer(DATA);   //Send value to record into register
-  delay(2);
-  // take the chip select high to de-select:
+  ads1292_Command_Byte(first | RREG);
+  ads1292_Command_Byte(count - 1);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    data[i] = ads1292_Command_Byte(0x00);
+  }
   digitalWrite(chip_select, HIGH);
 }
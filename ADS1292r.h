@@ -36,6 +36,13 @@
 #define SDATAC  0x11		//Stop Read Data Continuously mode
 #define RDATA	0x12		//Read data by command; supports multiple read back.
 
+// Start up timing, tCLK being the 512 kHz internal clock (about 2 us)
+#define ADS1292_RESET_PULSE_US  20  // PWDN/RESET low for a reset: at least 1 tMOD (4 tCLK),
+                                    // well short of the 2^10 tMOD that powers it down
+#define ADS1292_RESET_WAIT_US   50  // 18 tCLK after reset before the first command
+#define ADS1292_DECODE_US       8   // 4 tCLK for each command byte to be decoded
+#define ADS1292_CONFIG_TRIES    2
+
 //register address
 #define ADS1292_REG_ID			  0x00
 #define ADS1292_REG_CONFIG1		  0x01
@@ -61,12 +68,21 @@ class ads1292r
 {
   public:
     bool getAds1292r_Data_if_Available(const int data_ready,const int chip_select,ads1292r_data * data_struct);
-    bool ads1292_Init(const int chip_select,const int pwdn_pin,const int start_pin);
+    // Unpack a frame read by getAds1292r_Data_if_Available or sensor_acquisition
+    static void decode_frame(const uint8_t *frame, ads1292r_data *data_struct);
+    // A register value with its fixed bits set as the datasheet requires
+    static uint8_t reg_value(uint8_t address, uint8_t data);
+    // Configure and start conversions - false if the registers did not read back as written
+    static bool ads1292_Init(const int chip_select,const int pwdn_pin,const int start_pin);
     static void ads1292_Init();
+    static void ads1292_Reset_Pulse(const int pwdn_pin);
     static void ads1292_Reset(const int pwdn_pin);
     static void ads1292_Reset();
 	static void ads1292_Reg_Write (unsigned char READ_WRITE_ADDRESS, unsigned char DATA,const int chip_select);
     static void ads1292_Reg_Write (unsigned char READ_WRITE_ADDRESS, unsigned char DATA);
+    // count registers from first in one WREG/RREG - not in RDATAC mode
+    static void ads1292_Reg_Write_Burst (uint8_t first, const uint8_t *data, uint8_t count, const int chip_select);
+    static void ads1292_Reg_Read_Burst (uint8_t first, uint8_t *data, uint8_t count, const int chip_select);
     static void ads1292_SPI_Command_Data(unsigned char data_in,const int chip_select);
     static void ads1292_SPI_Command_Data(unsigned char data_in);
     static void ads1292_Disable_Start(const int start_pin);
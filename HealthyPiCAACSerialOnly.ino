@@ -30,35 +30,69 @@
 
 #include "myAFE4490_Oximeter.h"
 
+// DRDY interrupt driven SPI reads into ring buffers
+#include "sensor_acquisition.h"
+#include "spsc_ring.h"
+// Processing and output as tasks on the other core
+#include "pipeline_tasks.h"
+// Which frames go out on the serial port and when
+#include "packet_scheduler.h"
+// Getting them onto the UART
+#include "serial_transport.h"
+// Settings from the host at run time
+#include "command_channel.h"
+
 // New library IR Thermometer
 #include "MLX90614.h"
 
 #include "arduinoFFT.h"
 
-// Serial port data rate
+// Serial port data rate at power on - the host can ask for up to
+// 1 Mbaud once streaming (serial_transport.h)
 #define SERIAL_BAUDRATE 115200
+// Debug text on the serial port once streaming has started
+// It lands in the middle of the binary frames, so viewers lose data
+#define SERIAL_DEBUG_TEXT 0
 // Board switches 
 #define PUSH_BUTTON 17
 #define SLIDE_SWITCH 16
 
-// Packet setup  
-// defines start/stop and length Bytes
-#define CES_CMDIF_PKT_START_1 0x0A
-#define CES_CMDIF_PKT_START_2 0xFA
-#define DATA_LENGTH 20
-#define CES_CMDIF_DATA_LEN_LSB 20   // 20 bytes of actual data
-#define CES_CMDIF_DATA_LEN_MSB 0
-#define CES_CMDIF_TYPE_DATA 0x02
-#define CES_CMDIF_PKT_STOP_1 0x00
-#define CES_CMDIF_PKT_STOP_2 0x0B
-char DataPacketHeader[] = {CES_CMDIF_PKT_START_1, CES_CMDIF_PKT_START_2, CES_CMDIF_DATA_LEN_LSB, CES_CMDIF_DATA_LEN_MSB, CES_CMDIF_TYPE_DATA};
-char DataPacketFooter[] = {CES_CMDIF_PKT_STOP_1, CES_CMDIF_PKT_STOP_2};
-// Actual data 
-char DataPacket[DATA_LENGTH];
+// Frames for the serial port, filled in place by the processing stage
+// and written from the same slot by the output stage - while the UART
+// drains one frame the next is being filled
+// STREAM_MODE_SCHEDULED for a frame per sample, STREAM_MODE_COMBINED
+// for viewers that only read the 0x02 frame, STREAM_MODE_COMPRESSED
+// for delta coded batches at under half the bandwidth
+#define SERIAL_STREAM_MODE STREAM_MODE_BATCHED
+packet_scheduler scheduler;
+// Writes the queued frames as the UART takes them, never waiting on it
+serial_transport transport;
+// Register access, stream mode and decimation from the host at run time
+command_channel commands;
 
 // Timing stuff
 #define TEMP_READ_INTERVAL 1000
 
+// Pipeline tasks - stack in bytes, idle sleep in ms
+// Processing above output so a busy serial port never holds up the filters
+#define DSP_TASK_STACK 4096
+#define DSP_TASK_PRIORITY 3
+#define DSP_TASK_IDLE_MS 1
+#define OUTPUT_TASK_STACK 3072
+#define OUTPUT_TASK_PRIORITY 2
+#define OUTPUT_TASK_IDLE_MS 1
+#define TEMP_TASK_STACK 3072
+#define TEMP_TASK_PRIORITY 1
+#define TEMP_TASK_IDLE_MS 100
+
+// Run the stages as tasks, or in turn from loop() when false
+// The host build runs them from loop() unless the replay asks for threads
+#if defined(ARDUINO_ARCH_ESP32)
+bool pipeline_tasks_enabled = true;
+#else
+bool pipeline_tasks_enabled = false;
+#endif
+
 // Peripherals pins 
 const int ADS1292_DRDY_PIN = 26;
 const int ADS1292_CS_PIN = 13;
@@ -81,10 +115,10 @@ bool leadoff_detected = true;
 int16_t ecg_wave_sample, ecg_filterout;
 
 // Variables for ECG Respiration algorithm 
-#define RESP_BUFFER_SIZE 2048 //128*10 secs
+#define RESP_BUFFER_SIZE 2048 //125 SPS * 16 secs - power of 2
 int16_t res_wave_sample, resp_filterout;
-int16_t resp_buffer[RESP_BUFFER_SIZE];
-uint16_t resp_buffer_counter = 0;
+// Most recent RESP_BUFFER_SIZE resp samples for the resp algorithm
+spsc_ring<int16_t, RESP_BUFFER_SIZE> resp_buffer;
 
 
 int8_t global_HeartRate = 0;
@@ -137,14 +171,20 @@ bool spo2_calc_done = false;
 afe44xx_data afe44xx_raw_data;
 int spo2;
 
+// Sensor reads queued from the data ready interrupts
+sensor_acquisition acquisition;
+ecg_sample ecg_data;
+ppg_sample ppg_data;
+
 // Temperature stuff
 // IR temp sensor instance
 MLX90614 mlx90614;
 // Temperature variables
 double temp, temperature;
-int16_t tempint;
+// Written by the temperature stage, read by the processing stage
+volatile int16_t tempint = 0;
 // Temperature timing
-long temp_read_timer = 0;
+unsigned long temp_read_timer = 0;
 // Flag for presence of Temp sensor 
 bool temperatureSensor = false;
 
@@ -153,7 +193,7 @@ void setup()
 {
   // Wait for Serial port to open 
   // Sketch will hang if not working
-  Serial.begin(SERIAL_BAUDRATE);
+  transport.begin(SERIAL_BAUDRATE);
   while(!Serial){
       }
   // seems we have to wait a while for the serial port     
@@ -170,6 +210,10 @@ void setup()
   pinMode(AFE4490_PWDN_PIN, OUTPUT);
   pinMode(AFE4490_CS_PIN, OUTPUT);  //Slave Select
   pinMode(AFE4490_DRDY_PIN, INPUT); // data ready
+  // Both chips off the bus until spoken to - an output starts low, and
+  // the ADS1292R would otherwise take the AFE4490's set up as its own
+  digitalWrite(ADS1292_CS_PIN, HIGH);
+  digitalWrite(AFE4490_CS_PIN, HIGH);
   
   //set up mode selection pins
   pinMode(SLIDE_SWITCH, OUTPUT);
@@ -205,8 +249,6 @@ void setup()
       Serial.println("Could not initialize Oximeter!");
   }
   
-  attachInterrupt(digitalPinToInterrupt(AFE4490_DRDY_PIN), afe4490_interrupt_handler, RISING); // Digital2 is attached to Data ready pin of AFE is interrupt0 in ARduino 
-  
      
   // And Initialize ECG frontend - needs SPI_MODE1
   SPI.setDataMode(SPI_MODE1); //Set SPI mode as 1
@@ -220,7 +262,16 @@ void setup()
       Serial.println("Failed to initialize ADS1292 ECG Frontend");
   }
   
-  attachInterrupt(digitalPinToInterrupt(ADS1292_DRDY_PIN), ads1292r_interrupt_handler, FALLING); // Digital2 is attached to Data ready pin of AFE is interrupt0 in ARduino
+  // From here on both front ends are read from their data ready interrupts
+  // AFE4490 DRDY rises, ADS1292R DRDY falls when a conversion is ready
+  if (acquisition.begin(ADS1292_CS_PIN, ADS1292_DRDY_PIN, AFE4490_CS_PIN, AFE4490_DRDY_PIN))
+  {
+      Serial.println("Sensor acquisition started");
+  }
+  else
+  {
+      Serial.println("Failed to start sensor acquisition");
+  }
   
   // Start I2C bus for temp sensor 
   Wire.begin(25, 22);
@@ -236,26 +287,66 @@ void setup()
        Serial.println("MLX90614 not found");
    }
 
+  scheduler.set_mode(SERIAL_STREAM_MODE);
+  transport.attach(&commands);
+
   Serial.println("Initialization is complete");
   Serial.println("");
+
+  // From here on the serial port carries only binary frames
+  // Processing and output on the core the sensor bus task is not using
+  if (pipeline_tasks_enabled)
+  {
+    if (pipeline_task_start("dsp", dsp_step, DSP_TASK_IDLE_MS, DSP_TASK_STACK, DSP_TASK_PRIORITY, DSP_TASK_CORE)
+        && pipeline_task_start("output", output_step, OUTPUT_TASK_IDLE_MS, OUTPUT_TASK_STACK, OUTPUT_TASK_PRIORITY, DSP_TASK_CORE)
+        && pipeline_task_start("temperature", temperature_step, TEMP_TASK_IDLE_MS, TEMP_TASK_STACK, TEMP_TASK_PRIORITY, ACQ_TASK_CORE))
+    {
+    }
+    else
+    {
+      // Fall back to running the stages from loop()
+      pipeline_task_stop_all();
+      pipeline_tasks_enabled = false;
+    }
+  }
    
 }
 
 void loop()
 {
-    // Get raw data from ADS1292 - needs SPI_MODE1
-    // Store in ads1292r_raw_data which is a struct in the ADS1292R header
-    SPI.setDataMode(SPI_MODE1);
-    if (ADS1292R.getAds1292r_Data_if_Available(ADS1292_DRDY_PIN, ADS1292_CS_PIN, &ads1292r_raw_data))
+    if (pipeline_tasks_enabled)
+    {
+        // Everything runs in the pipeline tasks
+        delay(1000);
+        return;
+    }
+    dsp_step();
+    output_step();
+    temperature_step();
+}
+
+// Filtering, HR/SpO2/resp estimation and packet framing
+// Drains the sensor rings and queues the frames that are due
+bool dsp_step()
+{
+    bool new_data = false;
+
+    // Every ECG frame read since the last pass
+    // ads1292r_raw_data is a struct in the ADS1292R header
+    while (acquisition.read_ecg(&ecg_data))
     {
+        new_data = true;
+        ads1292r_raw_data.raw_ecg = ecg_data.ecg;
+        ads1292r_raw_data.raw_resp = ecg_data.resp;
+        ads1292r_raw_data.status_reg = ecg_data.lead_status;
         // Check to see if leads are connected 
         if (!((ads1292r_raw_data.status_reg & 0x1f) == 0))
         {
             leadoff_detected = true;
             ecg_filterout = 0;
             resp_filterout = 0;
-            DataPacket[14] = 0;
-            DataPacket[16] = 0;
+            global_RespirationRate = 0;
+            global_HeartRate = 0;
         }
         else
         {
@@ -265,76 +356,65 @@ void loop()
             // Extract data from struct and discard lowest 8 bits of 24
             ecg_wave_sample = (int16_t)(ads1292r_raw_data.raw_ecg >> 8); 
             res_wave_sample = (int16_t)(ads1292r_raw_data.raw_resp >> 8);
-            
-            // Now copy ECG data stream to the serial packet - try raw data
+            // Raw data goes to the serial packet (not ecg_filterout/resp_filterout)
             // It appears that raw data is cleaner than the filtered sample! 
-            memcpy(&DataPacket[0], &ecg_wave_sample, 2); //&ecg_filterout, 2);
-            memcpy(&DataPacket[2], &res_wave_sample, 2); //&resp_filterout, 2);
             // Add resp data to resp data buffer 
-            if (resp_buffer_counter < RESP_BUFFER_SIZE)
+            // When full drop the oldest so it always holds the last 16 secs
+            // (Do ECG/Resp algorithm here)
+            if (resp_buffer.full())
             {
-                resp_buffer[resp_buffer_counter] = res_wave_sample;
-                resp_buffer_counter++;
-            }
-            else
-            {
-                // If resp buffer full
-                // (Do ECG/Resp algorithm here)
-                //Serial.println("Resp buffer full");
-                //delay(1000);
+                int16_t oldest;
+                resp_buffer.pop(&oldest);
             }
+            resp_buffer.push(res_wave_sample);
         }
+        // Every sample goes out - the last good one while leads are off
+        scheduler.ecg_sample(ecg_wave_sample, res_wave_sample, ads1292r_raw_data.status_reg);
     }
     
-        
-    // Get Oximeter data needs SPI_MODE0
-    SPI.setDataMode(SPI_MODE0);
-
-    // Load data from Oximeter
+    // Every Oximeter sample - all of them go through the decimator
     // afe44xx_raw_data is a struct in the ADE4490 header
-    if (afe4490.get_AFE4490_data_if_available(&afe44xx_raw_data, AFE4490_CS_PIN))
+    while (acquisition.read_ppg(&ppg_data))
     {   
-        //Serial.println("Get data"); 
-        // Copy Raw PPG data to packet 
-        memcpy(&DataPacket[4], &afe44xx_raw_data.IR_data, sizeof(signed long));
-        memcpy(&DataPacket[8], &afe44xx_raw_data.RED_data, sizeof(signed long)); 
+        new_data = true;
+        afe4490.process_AFE4490_sample(ppg_data.ir, ppg_data.red, &afe44xx_raw_data);
+        scheduler.ppg_sample((int32_t)afe44xx_raw_data.IR_data, (int32_t)afe44xx_raw_data.RED_data);
  
         // Heart rate and respiration rates algorithms are called from ECG/Oximeter Classes
-        // Placeholders
+        // Respiration rate is from the PPG baseline, 0 until it is confident
         global_HeartRate = afe44xx_raw_data.heart_rate;
-        global_RespirationRate = 45;
+        global_RespirationRate = (int8_t)afe44xx_raw_data.resp;
         spo2 = afe44xx_raw_data.spo2;
 
         // originally a 32 bit int - reduce to 8 
         //DataPacket[16] = (uint8_t)afe44xx_raw_data.heart_rate;
         spo2_calc_done = true;
         //afe44xx_raw_data.spO2_data_ready = false;   
-
-        DataPacket[14] = global_RespirationRate;
-        DataPacket[15] = afe44xx_raw_data.spo2;
-        DataPacket[16] = global_HeartRate; 
-    }
-    else
-    {
-        Serial.println("Oximeter data not available");
     }
-    
+
+    // Slow values - the scheduler sends them when they change or are due
+    vitals_payload vitals;
+    // Latest reading from the temperature stage
+    vitals.temperature = tempint;
+    vitals.resp_rate = global_RespirationRate;
+    vitals.spo2 = afe44xx_raw_data.spo2;
+    vitals.heart_rate = global_HeartRate;
     // Not Implemented at present 
-    DataPacket[17] = 80;  //Blood Pressure Placeholder Diastolic
-    DataPacket[18] = 120; //BP Systolic 
-    DataPacket[19] = ads1292r_raw_data.status_reg;
-    
-    // read temperature for every 100ms
-    temp = mlx90614.readObjectTempC(); 
-    temperature = temp*100 +100;
-    tempint = (int16_t)temperature;
-    DataPacket[12] = (int8_t)tempint;
-    DataPacket[13] = (int8_t)(tempint >> 8);
+    vitals.bp_diastolic = 80;  //Blood Pressure Placeholder Diastolic
+    vitals.bp_systolic = 120; //BP Systolic 
+    vitals.status = ads1292r_raw_data.status_reg;
+    scheduler.set_vitals(&vitals);
+    status_payload link;
+    transport.link_status(&link);
+    scheduler.set_link_status(&link);
+    // Commands first, so their answers come before the frames they change
+    bool commanded = commands.run(&scheduler, &acquisition, millis());
+    scheduler.update(millis(), new_data);
     
     // Debugging 
     if (afe44xx_raw_data.spO2_data_ready == true)
     {
-        //printPacket();
+#if SERIAL_DEBUG_TEXT
         //printOximeterVariables(&afe44xx_raw_data);
         //printECGVariables(&ads1292r_raw_data);
         //printspO2variables(&afe4490.internal_data); 
@@ -347,12 +427,32 @@ void loop()
 
         //print_buffer(afe4490.aun_ir_buffer);
         //print_locations_buffer(afe4490.internal_data.testbuffer);        
+#endif
         afe44xx_raw_data.spO2_data_ready = false;
     }
     
-    // Send completed packet via serial/USB   
-    SPI.setDataMode(SPI_MODE0); 
-    send_data_serial_port(); 
+    return new_data || commanded;
+}
+
+// Send queued packets via serial/USB, as much as the UART will take
+// without waiting, and act on baud rate requests and commands from the host
+bool output_step()
+{
+    return transport.service(&scheduler);
+}
 
+// IR temperature once every TEMP_READ_INTERVAL
+// The I2C read is slow, so it stays out of the processing stage
+bool temperature_step()
+{
+    if (!temperatureSensor || millis() - temp_read_timer < TEMP_READ_INTERVAL)
+    {
+        return false;
+    }
+    temp_read_timer = millis();
+    temp = mlx90614.readObjectTempC(); 
+    temperature = temp*100 +100;
+    tempint = (int16_t)temperature;
+    return true;
 }
 
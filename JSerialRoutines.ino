@@ -14,76 +14,28 @@
 /////////////////////////////////////////////////////////////////////////////////////*/
 
 // Interrupt handlers
+// No text from here - it would land in the middle of the binary stream
 void push_button_intr_handler()
 {
-    // Delay to debounce
-    delay(100);
+#if SERIAL_DEBUG_TEXT
     Serial.println("Push Button handler");
+#endif
 }
 
 void slideswitch_intr_handler()
 {
-    // Delay to debounce
-    delay(100);
+#if SERIAL_DEBUG_TEXT
     Serial.println("SlideSwitch handler");
-  
-}
-
-// send data in packet over serial/USB 
-// It seems quite hard to concatenate arrays in C++!
-// so send each array individually
-
-/**
- * Packet structure 
- * 8 bit bytes
- *  
- *  0 Start 0x0A
- *  1 Start 0xFA
- *  2 datalength LSB
- *  3 datalength MSB
- *  4 0x02
- *  These 4 bytes are 0x00 if lead off detected
- *  5 ECG LSB
- *  6 ECG MSB
- *  7 Resp LSB
- *  8 Resp MSB
- *  9-12 Oximeter IR data LSB first
- *  13-16 0ximeter Red data LSB first 
- *  Temp - Deg C in hundredths of a degree C
- *  17 Temperature LSB
- *  18 Temperature MSB
- *  19 Resp rate/min
- *  20 spO2 % saturation
- *  21 Heartrate BPM
- *  22 BP diastolic - not implemented = 80
- *  23 BP Systolic - not implemented
- *  24 spO2 probe status
- *  25 Stop 0x00
- *  26 Stop 0x0B
- */   
-void send_data_serial_port()
-{
-
-  for (int i = 0; i < 5; i++)
-  {
-    Serial.write(DataPacketHeader[i]); 
-  }
-
-  for (int i = 0; i < DATA_LENGTH; i++)
-  {
-    Serial.write(DataPacket[i]); 
-  }
-
-  for (int i = 0; i < 2; i++)
-  {
-    Serial.write(DataPacketFooter[i]); 
-  }
+#endif
 }
 
 // Debugging stuff - write out packet 
 
-void printPacket()
+void printPacket(const data_frame *frame)
 {
+  const char *DataPacketHeader = (const char *)frame;
+  const char *DataPacket = DataPacketHeader + 5;
+  const char *DataPacketFooter = DataPacket + DATA_LENGTH;
   Serial.printf("Packet Header start1: %02x", DataPacketHeader[0]);
   Serial.println("");
   Serial.printf("Packet Header start2: %02x", DataPacketHeader[1]);
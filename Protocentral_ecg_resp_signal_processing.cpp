@@ -1,6 +1,7 @@
 #include "Arduino.h"
 #include "ADS1292r.h"
 #include "Protocentral_ecg_resp_signal_processing.h"
+#include "fir_filter.h"
 #include <SPI.h>
 
 unsigned char Start_Sample_Count_Flag = 0;
@@ -25,11 +26,14 @@ volatile uint8_t peak_flag =0;
 volatile uint16_t QRS_Heart_Rate = 0 ;
 static uint16_t QRS_B4_Buffer_ptr = 0 ; /*   Variable which holds the threshold value to calculate the maxima */
 
-int16_t RESP_WorkingBuff[2 * FILTERORDER];
 int16_t Pvev_DC_Sample=0, Pvev_Sample=0;
 int16_t QRS_Threshold_Old = 0;
 int16_t QRS_Threshold_New = 0;
-int16_t ECG_WorkingBuff[2 * FILTERORDER];
+
+// 161 tap filters, folded and run in blocks by fir_filter
+static fir_filter ECG_Filter, RESP_Filter;
+static uint8_t ECGFirstFlag = 1, RESPFirstFlag = 1;
+static int16_t ECG_Pvev_DC_Sample, ECG_Pvev_Sample;
 int16_t CoeffBuf_40Hz_LowPass[FILTERORDER] = {-72,    122,    -31,    -99,    117,      0,   -121,    105,     34,
                                              -137,     84,     70,   -146,     55,    104,   -147,     20,    135,
                                              -137,    -21,    160,   -117,    -64,    177,    -87,   -108,    185,
@@ -95,23 +99,11 @@ void ads1292r_processing :: ECG_FilterProcess(int16_t * WorkingBuff, int16_t * C
 
 void ads1292r_processing :: Filter_CurrentECG_sample(int16_t *CurrAqsSample, int16_t *FilteredOut)
 {
-  static uint16_t ECG_bufStart = 0, ECG_bufCur = FILTERORDER - 1, ECGFirstFlag = 1;
-  static int16_t ECG_Pvev_DC_Sample, ECG_Pvev_Sample;/* Working Buffer Used for Filtering*/
-  int16_t *CoeffBuf;
   int16_t temp1, temp2, ECGData;
-  /* Count variable*/
-  uint16_t Cur_Chan;
-  int16_t FiltOut = 0;
-  CoeffBuf = CoeffBuf_40Hz_LowPass;         // Default filter option is 40Hz LowPass
 
   if  ( ECGFirstFlag )                // First Time initialize static variables.
   {
-    
-    for ( Cur_Chan = 0 ; Cur_Chan < FILTERORDER; Cur_Chan++)
-    {
-      ECG_WorkingBuff[Cur_Chan] = 0;
-    }
-
+    ECG_Filter.init(CoeffBuf_40Hz_LowPass, FILTERORDER);    // Default filter option is 40Hz LowPass
     ECG_Pvev_DC_Sample = 0;
     ECG_Pvev_Sample = 0;
     ECGFirstFlag = 0;
@@ -122,23 +114,34 @@ void ads1292r_processing :: Filter_CurrentECG_sample(int16_t *CurrAqsSample, int
   ECG_Pvev_Sample = CurrAqsSample[0];
   temp2 = ECG_Pvev_DC_Sample >> 2;
   ECGData = (int16_t) temp2;
-  /* Store the DC removed value in Working buffer in millivolts range*/
-  ECG_WorkingBuff[ECG_bufCur] = ECGData;
-  ECG_FilterProcess(&ECG_WorkingBuff[ECG_bufCur], CoeffBuf, (int16_t*)&FiltOut);
-  /* Store the DC removed value in ECG_WorkingBuff buffer in millivolts range*/
-  ECG_WorkingBuff[ECG_bufStart] = ECGData;
-  /* Store the filtered out sample to the LeadInfo buffer*/
-  FilteredOut[0] = FiltOut ;//(CurrOut);
-  ECG_bufCur++;
-  ECG_bufStart++;
-
-  if ( ECG_bufStart  == (FILTERORDER - 1))
+  /* Filter the DC removed value and store it to the LeadInfo buffer*/
+  FilteredOut[0] = ECG_Filter.process(ECGData);
+
+  return ;
+}
+
+// Same as Filter_CurrentECG_sample for a block of n samples,
+// in and out may be the same buffer
+void ads1292r_processing :: Filter_ECG_block(const int16_t *CurrAqsSamples, int16_t *FilteredOut, uint16_t n)
+{
+  int16_t temp1;
+
+  if  ( ECGFirstFlag )
   {
-    ECG_bufStart = 0;
-    ECG_bufCur = FILTERORDER - 1;
+    ECG_Filter.init(CoeffBuf_40Hz_LowPass, FILTERORDER);
+    ECG_Pvev_DC_Sample = 0;
+    ECG_Pvev_Sample = 0;
+    ECGFirstFlag = 0;
   }
 
-  return ;
+  for (uint16_t i = 0; i < n; i++)
+  {
+    temp1 = NRCOEFF * ECG_Pvev_DC_Sample;       //First order IIR
+    ECG_Pvev_DC_Sample = (CurrAqsSamples[i]  - ECG_Pvev_Sample) + temp1;
+    ECG_Pvev_Sample = CurrAqsSamples[i];
+    FilteredOut[i] = (int16_t)(ECG_Pvev_DC_Sample >> 2);
+  }
+  ECG_Filter.process_block(FilteredOut, FilteredOut, n);
 }
 
 void ads1292r_processing :: Calculate_HeartRate(int16_t CurrSample,volatile uint8_t *Heart_rate, volatile uint8_t *peakflag )
@@ -402,33 +405,44 @@ void ads1292r_processing :: Resp_FilterProcess(int16_t * RESP_WorkingBuff, int16
 
 void ads1292r_processing :: Filter_CurrentRESP_sample(int16_t CurrAqsSample, int16_t * FiltOut)
 {
-  static uint16_t bufStart=0, bufCur = FILTERORDER-1, FirstFlag = 1;
   int16_t temp1, temp2;//, RESPData;
   int16_t RESPData;
-  /* Count variable*/
-  uint16_t Cur_Chan;
-//  int16_t FiltOut;
+
+  if ( RESPFirstFlag )
+  {
+    RESP_Filter.init(RespCoeffBuf, FILTERORDER);
+    RESPFirstFlag = 0;
+  }
   temp1 = NRCOEFF * Pvev_DC_Sample;
   Pvev_DC_Sample = (CurrAqsSample  - Pvev_Sample) + temp1;
   Pvev_Sample = CurrAqsSample;
   temp2 = Pvev_DC_Sample;
   RESPData = (int16_t) temp2;
   RESPData = CurrAqsSample;
-  /* Store the DC removed value in RESP_WorkingBuff buffer in millivolts range*/
-  RESP_WorkingBuff[bufCur] = RESPData;
-  Resp_FilterProcess(&RESP_WorkingBuff[bufCur],RespCoeffBuf,FiltOut);
-  /* Store the DC removed value in Working buffer in millivolts range*/
-  RESP_WorkingBuff[bufStart] = RESPData;
-  /* Store the filtered out sample to the LeadInfo buffer*/
-  bufCur++;
-  bufStart++;
-
-  if ( bufStart  >= (FILTERORDER-1))
+  /* Filter the sample and store it to the LeadInfo buffer*/
+  FiltOut[0] = RESP_Filter.process(RESPData);
+}
+
+// Same as Filter_CurrentRESP_sample for a block of n samples,
+// in and out may be the same buffer
+void ads1292r_processing :: Filter_RESP_block(const int16_t *CurrAqsSamples, int16_t *FiltOut, uint16_t n)
+{
+  int16_t temp1;
+
+  if ( RESPFirstFlag )
   {
-    bufStart=0;
-    bufCur = FILTERORDER-1;
+    RESP_Filter.init(RespCoeffBuf, FILTERORDER);
+    RESPFirstFlag = 0;
   }
-
+  for (uint16_t i = 0; i < n; i++)
+  {
+    // DC tracker kept running as in Filter_CurrentRESP_sample, whose
+    // output is not used - the raw sample is filtered
+    temp1 = NRCOEFF * Pvev_DC_Sample;
+    Pvev_DC_Sample = (CurrAqsSamples[i]  - Pvev_Sample) + temp1;
+    Pvev_Sample = CurrAqsSamples[i];
+  }
+  RESP_Filter.process_block(CurrAqsSamples, FiltOut, n);
 }
 
 void ads1292r_processing :: CalcResRate(int16_t* resData)
@@ -22,11 +22,13 @@ class ads1292r_processing
   public:
     void ECG_FilterProcess(int16_t * WorkingBuff, int16_t * CoeffBuf, int16_t* FilterOut);
     void Filter_CurrentECG_sample(int16_t *CurrAqsSample, int16_t *FilteredOut);
+    void Filter_ECG_block(const int16_t *CurrAqsSamples, int16_t *FilteredOut, uint16_t n);
     void Calculate_HeartRate(int16_t CurrSample,volatile uint8_t *Heart_rate, volatile uint8_t *peakflag);
     void QRS_process_buffer(volatile uint8_t *Heart_rate,volatile uint8_t *peakflag);
     void QRS_check_sample_crossing_threshold( uint16_t scaled_result,volatile uint8_t *Heart_rate,volatile uint8_t *peakflag);  
     void Resp_FilterProcess(int16_t * RESP_WorkingBuff, int16_t * CoeffBuf, int16_t* FilterOut);
     void Filter_CurrentRESP_sample(int16_t CurrAqsSample, int16_t * FiltOut);
+    void Filter_RESP_block(const int16_t *CurrAqsSamples, int16_t *FiltOut, uint16_t n);
     void Calculate_RespRate(int16_t CurrSample,volatile uint8_t *RespirationRate);
     void Respiration_Rate_Detection(int16_t Resp_wave,volatile uint8_t *RespirationRate);
     void CalcResRate(int16_t* resData);
@@ -59,6 +59,9 @@
 #define twoPi 6.28318531
 #define fourPi 12.56637061
 #define sixPi 18.84955593
+#ifndef TWO_PI
+	#define TWO_PI 6.283185307179586476925286766559
+#endif
 
 #ifdef __AVR__
 	static const double _c1[]PROGMEM = {0.0000000000, 0.7071067812, 0.9238795325, 0.9807852804,
@@ -72,11 +75,18 @@
 																0.0003834952, 0.0001917476, 0.0000958738, 0.0000479369,
 																0.0000239684};
 #endif
+#include "arduinoFFTCore.h"
+
+/* The double transforms, as arduinoFFTCore<double>, and the original
+	pointer argument functions */
 class arduinoFFT {
 public:
 	/* Constructor */
 	arduinoFFT(void);
 	arduinoFFT(double *vReal, double *vImag, uint16_t samples, double samplingFrequency);
+	/* Size from the plan, whose tables Compute, ComputeReal and Windowing
+		(for the plan's window type) then use */
+	arduinoFFT(double *vReal, double *vImag, const arduinoFFTPlan *plan, double samplingFrequency);
 	/* Destructor */
 	~arduinoFFT(void);
 	/* Functions */
@@ -93,18 +103,17 @@ public:
 
 	void ComplexToMagnitude();
 	void Compute(uint8_t dir);
+	// Real input: vReal holds samples real values and vImag needs only
+	// samples/2 + 1. Forward leaves bins 0 to samples/2 in vReal/vImag,
+	// reverse takes those and leaves the real values in vReal
+	void ComputeReal(uint8_t dir);
 	void DCRemoval();
 	double MajorPeak();
 	void MajorPeak(double *f, double *v);
 	void Windowing(uint8_t windowType, uint8_t dir);
 
 private:
-	/* Variables */
-	uint16_t _samples;
-	double _samplingFrequency;
-	double *_vReal;
-	double *_vImag;
-	uint8_t _power;
+	arduinoFFTCore<double> _fft;
 	/* Functions */
 	void Swap(double *x, double *y);
 };
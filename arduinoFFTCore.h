@@ -0,0 +1,632 @@
+/*
+
+	FFT libray
+	Copyright (C) 2010 Didier Longueville
+	Copyright (C) 2014 Enrique Condes
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* The transforms for any sample type - double, float, or Q15 (int16_t)
+	and Q31 (int32_t) fixed point. Included by arduinoFFT.h, which has the
+	constants; include that rather than this.
+
+	The ESP32 has a single precision FPU, so double is done in software and
+	float is many times faster. The fixed point types take a quarter or half
+	the memory of double and need no FPU. They use block floating point:
+	before each butterfly stage and the real split step, if any value is a
+	quarter of full scale or more, the whole block is shifted down and
+	BlockExponent() goes up, so nothing can overflow. The result times
+	2^BlockExponent() is the true transform of the input (with the input
+	taken as a fraction of full scale); the reverse transform leaves its
+	1/samples in the exponent too rather than losing the bits. A forward
+	transform starts the exponent at 0 and a reverse one carries on from it.
+	Twiddles and window factors are Q15/Q31, so a factor of 1.0 is one LSB
+	short, and FFT_WIN_TYP_HANN, which goes up to 1.08 here, is clipped at
+	1.0. For float and double the exponent is always 0. */
+
+#ifndef arduinoFFTCore_h /* Prevent loading library twice */
+#define arduinoFFTCore_h
+
+/* Weighing factor of sample i (i below samples/2) of a window */
+double arduinoFFTWindowFactor(uint8_t windowType, uint16_t i, uint16_t samples);
+
+/* Arithmetic for each sample type */
+template <typename T>
+struct arduinoFFTMath {
+	typedef T acc_t;
+	static const bool fixedPoint = false;
+	static T FromDouble(double x) { return T(x); }
+	static double ToDouble(T x) { return double(x); }
+	static T Mul(T a, T b) { return a * b; }
+	static T MulAdd(T a, T b, T c, T d) { return a * b + c * d; }
+	static T MulSub(T a, T b, T c, T d) { return a * b - c * d; }
+	static T Div(T a, T b) { return a / b; }
+	static T Mean(T a, T b) { return (a + b) * T(0.5); }
+	static T HalfDiff(T a, T b) { return (a - b) * T(0.5); }
+	static T Magnitude(T re, T im) { return sqrt(re * re + im * im); }
+	static bool Large(T) { return false; }
+	static T Shift(T a, uint8_t) { return a; }
+};
+
+template <>
+inline float arduinoFFTMath<float>::Magnitude(float re, float im) { return sqrtf(re * re + im * im); }
+
+/* Q15 - the products are 32 bit, safe as the block scaling keeps the
+	data below a quarter of full scale */
+template <>
+struct arduinoFFTMath<int16_t> {
+	typedef int32_t acc_t;
+	static const bool fixedPoint = true;
+	static int16_t FromDouble(double x)
+	{
+		double y = x * 32768.0;
+		return (y >= 32767.0) ? 32767 : ((y <= -32768.0) ? -32768 : (int16_t)floor(y + 0.5));
+	}
+	static double ToDouble(int16_t x) { return double(x); }
+	static int16_t Mul(int16_t a, int16_t b) { return (int16_t)(((int32_t)a * b + (1 << 14)) >> 15); }
+	static int16_t MulAdd(int16_t a, int16_t b, int16_t c, int16_t d) { return (int16_t)(((int32_t)a * b + (int32_t)c * d + (1 << 14)) >> 15); }
+	static int16_t MulSub(int16_t a, int16_t b, int16_t c, int16_t d) { return (int16_t)(((int32_t)a * b - (int32_t)c * d + (1 << 14)) >> 15); }
+	static int16_t Div(int16_t a, int16_t b)
+	{
+		int32_t q = (b == 0) ? ((a < 0) ? -32768 : 32767) : (((int32_t)a << 15) / b);
+		return (q > 32767) ? 32767 : ((q < -32768) ? -32768 : (int16_t)q);
+	}
+	static int16_t Mean(int16_t a, int16_t b) { return (int16_t)(((int32_t)a + b) >> 1); }
+	static int16_t HalfDiff(int16_t a, int16_t b) { return (int16_t)(((int32_t)a - b) >> 1); }
+	static int16_t Magnitude(int16_t re, int16_t im)
+	{
+		uint32_t power = (uint32_t)((int32_t)re * re) + (uint32_t)((int32_t)im * im);
+		float root = sqrtf((float)power) + 0.5f;
+		return (root >= 32767.0f) ? 32767 : (int16_t)root;
+	}
+	static bool Large(int16_t a) { return (a >= (1 << 13)) || (a < -(1 << 13)); }
+	static int16_t Shift(int16_t a, uint8_t bits) { return (int16_t)(a >> bits); }
+};
+
+/* Q31 - 64 bit products */
+template <>
+struct arduinoFFTMath<int32_t> {
+	typedef int64_t acc_t;
+	static const bool fixedPoint = true;
+	static int32_t FromDouble(double x)
+	{
+		double y = x * 2147483648.0;
+		return (y >= 2147483647.0) ? 2147483647 : ((y <= -2147483648.0) ? (-2147483647 - 1) : (int32_t)floor(y + 0.5));
+	}
+	static double ToDouble(int32_t x) { return double(x); }
+	static int32_t Mul(int32_t a, int32_t b) { return (int32_t)(((int64_t)a * b + (1LL << 30)) >> 31); }
+	static int32_t MulAdd(int32_t a, int32_t b, int32_t c, int32_t d) { return (int32_t)(((int64_t)a * b + (int64_t)c * d + (1LL << 30)) >> 31); }
+	static int32_t MulSub(int32_t a, int32_t b, int32_t c, int32_t d) { return (int32_t)(((int64_t)a * b - (int64_t)c * d + (1LL << 30)) >> 31); }
+	static int32_t Div(int32_t a, int32_t b)
+	{
+		int64_t q = (b == 0) ? ((a < 0) ? INT32_MIN : INT32_MAX) : (((int64_t)a << 31) / b);
+		return (q > INT32_MAX) ? INT32_MAX : ((q < INT32_MIN) ? INT32_MIN : (int32_t)q);
+	}
+	static int32_t Mean(int32_t a, int32_t b) { return (int32_t)(((int64_t)a + b) >> 1); }
+	static int32_t HalfDiff(int32_t a, int32_t b) { return (int32_t)(((int64_t)a - b) >> 1); }
+	static int32_t Magnitude(int32_t re, int32_t im)
+	{// Integer square root, a bit at a time
+		uint64_t power = (uint64_t)((int64_t)re * re) + (uint64_t)((int64_t)im * im);
+		uint64_t root = 0;
+		uint64_t bit = (1ULL << 62);
+		while (bit > power) bit >>= 2;
+		while (bit != 0) {
+			if (power >= root + bit) {
+				power -= root + bit;
+				root = (root >> 1) + bit;
+			}
+			else {
+				root >>= 1;
+			}
+			bit >>= 2;
+		}
+		return (root > INT32_MAX) ? INT32_MAX : (int32_t)root;
+	}
+	static bool Large(int32_t a) { return (a >= (1L << 29)) || (a < -(1L << 29)); }
+	static int32_t Shift(int32_t a, uint8_t bits) { return (a >> bits); }
+};
+
+template <typename T> class arduinoFFTCore;
+
+/* Tables for one transform size and window, worked out once rather than
+	on every call: cos and sin of 2 pi k / samples for k below samples/2 (the
+	twiddles for samples and for samples/2, as ComputeReal needs), the bit
+	reversed index of each sample and the first half of the window. A plan
+	is only read, so one can serve any number of transforms */
+template <typename T>
+class arduinoFFTPlanCore {
+public:
+	/* Over tables worked out elsewhere, e.g. const arrays in flash */
+	arduinoFFTPlanCore(uint16_t samples, uint8_t windowType, const T *cosTable, const T *sinTable, const uint16_t *reverse, const T *window)
+	{
+		this->_samples = samples;
+		this->_windowType = windowType;
+		this->_cos = cosTable;
+		this->_sin = sinTable;
+		this->_reverse = reverse;
+		this->_window = window;
+	}
+	uint16_t Samples(void) const { return this->_samples; }
+	uint8_t WindowType(void) const { return this->_windowType; }
+
+protected:
+	arduinoFFTPlanCore(void) {}
+	/* Fill the tables and take them */
+	void Build(uint16_t samples, uint8_t windowType, T *cosTable, T *sinTable, uint16_t *reverse, T *window)
+	{
+		// Twiddles to full precision - twoPi is only good to 9 digits
+		for (uint16_t k = 0; k < (samples >> 1); k++) {
+			cosTable[k] = arduinoFFTMath<T>::FromDouble(cos(TWO_PI * k / samples));
+			sinTable[k] = arduinoFFTMath<T>::FromDouble(sin(TWO_PI * k / samples));
+			window[k] = arduinoFFTMath<T>::FromDouble(arduinoFFTWindowFactor(windowType, k, samples));
+		}
+		// The same walk as Compute's bit reversal, once
+		uint16_t j = 0;
+		for (uint16_t i = 0; i < samples; i++) {
+			reverse[i] = j;
+			uint16_t k = (samples >> 1);
+			while ((k > 0) && (k <= j)) {
+				j -= k;
+				k >>= 1;
+			}
+			j += k;
+		}
+		this->_samples = samples;
+		this->_windowType = windowType;
+		this->_cos = cosTable;
+		this->_sin = sinTable;
+		this->_reverse = reverse;
+		this->_window = window;
+	}
+
+private:
+	template <typename U> friend class arduinoFFTCore;
+	uint16_t _samples;
+	uint8_t _windowType;
+	const T *_cos;
+	const T *_sin;
+	const uint16_t *_reverse;
+	const T *_window;
+};
+
+/* A plan holding its own tables, for a size fixed at compile time */
+template <uint16_t samples, typename T = double>
+class arduinoFFTPlanN : public arduinoFFTPlanCore<T> {
+public:
+	arduinoFFTPlanN(uint8_t windowType = FFT_WIN_TYP_RECTANGLE)
+	{
+		this->Build(samples, windowType, this->_cosTable, this->_sinTable, this->_reverseTable, this->_windowTable);
+	}
+
+private:
+	T _cosTable[samples >> 1];
+	T _sinTable[samples >> 1];
+	uint16_t _reverseTable[samples];
+	T _windowTable[samples >> 1];
+};
+
+template <typename T>
+class arduinoFFTCore {
+public:
+	/* Constructor */
+	arduinoFFTCore(void) : _vReal(NULL), _vImag(NULL), _samples(0), _samplingFrequency(0), _power(0), _bins(0), _exponent(0), _plan(NULL) {}
+	arduinoFFTCore(T *vReal, T *vImag, uint16_t samples, double samplingFrequency)
+	{
+		this->_vReal = vReal;
+		this->_vImag = vImag;
+		this->_samples = samples;
+		this->_samplingFrequency = samplingFrequency;
+		this->_power = Log2(samples);
+		this->_bins = samples;
+		this->_exponent = 0;
+		this->_plan = NULL;
+	}
+	/* Size from the plan, whose tables Compute, ComputeReal and Windowing
+		(for the plan's window type) then use */
+	arduinoFFTCore(T *vReal, T *vImag, const arduinoFFTPlanCore<T> *plan, double samplingFrequency)
+	{
+		this->_vReal = vReal;
+		this->_vImag = vImag;
+		this->_samples = plan->_samples;
+		this->_samplingFrequency = samplingFrequency;
+		this->_power = Log2(plan->_samples);
+		this->_bins = plan->_samples;
+		this->_exponent = 0;
+		this->_plan = plan;
+	}
+
+	/* Functions */
+	void ComplexToMagnitude()
+	{ // vM is half the size of vReal and vImag
+		for (uint16_t i = 0; i < this->_bins; i++) {
+			this->_vReal[i] = Math::Magnitude(this->_vReal[i], this->_vImag[i]);
+		}
+		// After ComputeReal the bin above samples/2 is the mirror of the one
+		// below, as MajorPeak looks at it
+		if (this->_bins < this->_samples) {
+			this->_vReal[this->_bins] = this->_vReal[this->_bins - 2];
+		}
+	}
+
+	void Compute(uint8_t dir)
+	{// Computes in-place complex-to-complex FFT /
+		// The forward bit reversal leaves vImag alone - it is taken as all 0
+		if (dir == FFT_FORWARD) {
+			this->_exponent = 0;
+		}
+		Transform(this->_samples, this->_power, dir, dir == FFT_REVERSE);
+		this->_bins = this->_samples;
+	}
+
+	// Real input: vReal holds samples real values and vImag needs only
+	// samples/2 + 1. Forward leaves bins 0 to samples/2 in vReal/vImag,
+	// reverse takes those and leaves the real values in vReal
+	void ComputeReal(uint8_t dir)
+	{// Computes a real FFT through a complex FFT of half the length
+		uint16_t half = (this->_samples >> 1);
+		if (dir == FFT_FORWARD) {
+			this->_exponent = 0;
+			// Even samples to vReal[0..half-1], odd to vImag[0..half-1]
+			for (uint16_t i = 0; i < half; i++) {
+				this->_vImag[i] = this->_vReal[(i << 1) + 1];
+				this->_vReal[i] = this->_vReal[i << 1];
+			}
+			Transform(half, this->_power - 1, FFT_FORWARD, true);
+			Normalize(half);
+			SplitReal(FFT_FORWARD);
+			this->_bins = half + 1;
+		}
+		else {
+			Normalize(half + 1);
+			SplitReal(FFT_REVERSE);
+			Transform(half, this->_power - 1, FFT_REVERSE, true);
+			// Back out to even and odd samples, top down so nothing is
+			// overwritten before it is read
+			for (uint16_t i = half; i-- > 0; ) {
+				this->_vReal[(i << 1) + 1] = this->_vImag[i];
+				this->_vReal[i << 1] = this->_vReal[i];
+			}
+			this->_bins = this->_samples;
+		}
+	}
+
+	void DCRemoval()
+	{
+		// calculate the mean of vData
+		typename Math::acc_t mean = 0;
+		for (uint16_t i = 1; i < ((this->_samples >> 1) + 1); i++)
+		{
+			mean += this->_vReal[i];
+		}
+		mean /= this->_samples;
+		// Subtract the mean from vData
+		for (uint16_t i = 1; i < ((this->_samples >> 1) + 1); i++)
+		{
+			this->_vReal[i] -= mean;
+		}
+	}
+
+	double MajorPeak()
+	{
+		double f, v;
+		MajorPeak(&f, &v);
+		// returned value: interpolated frequency peak apex
+		return(f);
+	}
+
+	/* v is in the units of the transform - scaled by 2^-BlockExponent()
+		for fixed point */
+	void MajorPeak(double *f, double *v)
+	{
+		double maxY = 0;
+		uint16_t IndexOfMaxY = 0;
+		//If sampling_frequency = 2 * max_frequency in signal,
+		//value would be stored at position samples/2
+		for (uint16_t i = 1; i < ((this->_samples >> 1) + 1); i++) {
+			if ((this->_vReal[i - 1] < this->_vReal[i]) && (this->_vReal[i] > this->_vReal[i + 1])) {
+				if (Math::ToDouble(this->_vReal[i]) > maxY) {
+					maxY = Math::ToDouble(this->_vReal[i]);
+					IndexOfMaxY = i;
+				}
+			}
+		}
+		double before = Math::ToDouble(this->_vReal[IndexOfMaxY - 1]);
+		double at = Math::ToDouble(this->_vReal[IndexOfMaxY]);
+		double after = Math::ToDouble(this->_vReal[IndexOfMaxY + 1]);
+		double delta = 0.5 * ((before - after) / (before - (2.0 * at) + after));
+		double interpolatedX = ((IndexOfMaxY + delta)  * this->_samplingFrequency) / (this->_samples - 1);
+		if (IndexOfMaxY == (this->_samples >> 1)) //To improve calculation on edge values
+			interpolatedX = ((IndexOfMaxY + delta)  * this->_samplingFrequency) / (this->_samples);
+		// returned value: interpolated frequency peak apex
+		*f = interpolatedX;
+		*v = abs(before - (2.0 * at) + after);
+	}
+
+	void Windowing(uint8_t windowType, uint8_t dir)
+	{// Weighing factors are computed once before multiple use of FFT
+	// The weighing function is symetric; half the weighs are recorded
+		const T *window = NULL;
+		if ((this->_plan != NULL) && (this->_plan->_windowType == windowType)) {
+			window = this->_plan->_window;
+		}
+		for (uint16_t i = 0; i < (this->_samples >> 1); i++) {
+			// Compute and record weighting factor
+			T weighingFactor = (window != NULL) ? window[i] : Math::FromDouble(arduinoFFTWindowFactor(windowType, i, this->_samples));
+			if (dir == FFT_FORWARD) {
+				this->_vReal[i] = Math::Mul(this->_vReal[i], weighingFactor);
+				this->_vReal[this->_samples - (i + 1)] = Math::Mul(this->_vReal[this->_samples - (i + 1)], weighingFactor);
+			}
+			else {
+				this->_vReal[i] = Math::Div(this->_vReal[i], weighingFactor);
+				this->_vReal[this->_samples - (i + 1)] = Math::Div(this->_vReal[this->_samples - (i + 1)], weighingFactor);
+			}
+		}
+	}
+
+	/* Power of 2 the fixed point results are to be scaled by, 0 otherwise */
+	int8_t BlockExponent(void) const { return this->_exponent; }
+
+private:
+	typedef arduinoFFTMath<T> Math;
+
+	/* Variables */
+	T *_vReal;
+	T *_vImag;
+	uint16_t _samples;
+	double _samplingFrequency;
+	uint8_t _power;
+	uint16_t _bins; /* bins the last transform left, for ComplexToMagnitude */
+	int8_t _exponent;
+	const arduinoFFTPlanCore<T> *_plan;
+
+	/* Functions */
+	static uint8_t Log2(uint16_t value)
+	{
+		uint8_t result = 0;
+		while (((value >> result) & 1) != 1) result++;
+		return(result);
+	}
+
+	void Swap(T *x, T *y)
+	{
+		T temp = *x;
+		*x = *y;
+		*y = temp;
+	}
+
+	void Normalize(uint16_t count)
+	{// Block scaling - shift the first count values down until all are
+		// below a quarter of full scale. Nothing to do for floating point
+		if (!Math::fixedPoint) {
+			return;
+		}
+		T maxV = 0;
+		T minV = 0;
+		for (uint16_t i = 0; i < count; i++) {
+			if (this->_vReal[i] > maxV) maxV = this->_vReal[i];
+			if (this->_vReal[i] < minV) minV = this->_vReal[i];
+			if (this->_vImag[i] > maxV) maxV = this->_vImag[i];
+			if (this->_vImag[i] < minV) minV = this->_vImag[i];
+		}
+		uint8_t bits = 0;
+		while (Math::Large(Math::Shift(maxV, bits)) || Math::Large(Math::Shift(minV, bits))) {
+			bits++;
+		}
+		if (bits == 0) {
+			return;
+		}
+		for (uint16_t i = 0; i < count; i++) {
+			this->_vReal[i] = Math::Shift(this->_vReal[i], bits);
+			this->_vImag[i] = Math::Shift(this->_vImag[i], bits);
+		}
+		this->_exponent += bits;
+	}
+
+	void Transform(uint16_t samples, uint8_t power, uint8_t dir, bool swapImag)
+	{// In-place complex-to-complex FFT of the first samples values
+		if (this->_plan != NULL) {
+			TransformPlan(samples, power, dir, swapImag);
+			return;
+		}
+		// Reverse bits /
+		uint16_t j = 0;
+		for (uint16_t i = 0; i < (samples - 1); i++) {
+			if (i < j) {
+				Swap(&this->_vReal[i], &this->_vReal[j]);
+				if(swapImag)
+					Swap(&this->_vImag[i], &this->_vImag[j]);
+			}
+			uint16_t k = (samples >> 1);
+			while (k <= j) {
+				j -= k;
+				k >>= 1;
+			}
+			j += k;
+		}
+		// Compute the FFT  /
+#ifdef __AVR__
+		uint8_t index = 0;
+#endif
+		double c1 = -1.0;
+		double c2 = 0.0;
+		uint16_t l2 = 1;
+		for (uint8_t l = 0; (l < power); l++) {
+			Normalize(samples);
+			uint16_t l1 = l2;
+			l2 <<= 1;
+			double u1 = 1.0;
+			double u2 = 0.0;
+			for (j = 0; j < l1; j++) {
+				 T w1 = Math::FromDouble(u1);
+				 T w2 = Math::FromDouble(u2);
+				 for (uint16_t i = j; i < samples; i += l2) {
+						uint16_t i1 = i + l1;
+						T t1 = Math::MulSub(w1, this->_vReal[i1], w2, this->_vImag[i1]);
+						T t2 = Math::MulAdd(w1, this->_vImag[i1], w2, this->_vReal[i1]);
+						this->_vReal[i1] = this->_vReal[i] - t1;
+						this->_vImag[i1] = this->_vImag[i] - t2;
+						this->_vReal[i] += t1;
+						this->_vImag[i] += t2;
+				 }
+				 double z = ((u1 * c1) - (u2 * c2));
+				 u2 = ((u1 * c2) + (u2 * c1));
+				 u1 = z;
+			}
+#ifdef __AVR__
+			c2 = pgm_read_float_near(&(_c2[index]));
+			c1 = pgm_read_float_near(&(_c1[index]));
+			index++;
+#else
+			c2 = sqrt((1.0 - c1) / 2.0);
+			c1 = sqrt((1.0 + c1) / 2.0);
+#endif
+			if (dir == FFT_FORWARD) {
+				c2 = -c2;
+			}
+		}
+		Scale(samples, power, dir);
+	}
+
+	void TransformPlan(uint16_t samples, uint8_t power, uint8_t dir, bool swapImag)
+	{// Transform with the plan's tables. samples is the plan's or half of it;
+		// the bit reversed index for half is the plan's halved, and the
+		// twiddles for a span of l2 are every (plan samples / l2)th entry
+		const arduinoFFTPlanCore<T> *plan = this->_plan;
+		uint8_t shift = this->_power - power;
+		for (uint16_t i = 0; i < samples; i++) {
+			uint16_t j = (plan->_reverse[i] >> shift);
+			if (i < j) {
+				Swap(&this->_vReal[i], &this->_vReal[j]);
+				if(swapImag)
+					Swap(&this->_vImag[i], &this->_vImag[j]);
+			}
+		}
+		uint16_t l2 = 1;
+		for (uint8_t l = 0; (l < power); l++) {
+			Normalize(samples);
+			uint16_t l1 = l2;
+			l2 <<= 1;
+			uint16_t stride = (plan->_samples / l2);
+			for (uint16_t j = 0; j < l1; j++) {
+				T u1 = plan->_cos[j * stride];
+				T u2 = (dir == FFT_FORWARD) ? T(-plan->_sin[j * stride]) : plan->_sin[j * stride];
+				for (uint16_t i = j; i < samples; i += l2) {
+					uint16_t i1 = i + l1;
+					T t1 = Math::MulSub(u1, this->_vReal[i1], u2, this->_vImag[i1]);
+					T t2 = Math::MulAdd(u1, this->_vImag[i1], u2, this->_vReal[i1]);
+					this->_vReal[i1] = this->_vReal[i] - t1;
+					this->_vImag[i1] = this->_vImag[i] - t2;
+					this->_vReal[i] += t1;
+					this->_vImag[i] += t2;
+				}
+			}
+		}
+		Scale(samples, power, dir);
+	}
+
+	void Scale(uint16_t samples, uint8_t power, uint8_t dir)
+	{// Scaling for reverse transform - in the exponent for fixed point
+		if (dir == FFT_FORWARD) {
+			return;
+		}
+		if (Math::fixedPoint) {
+			this->_exponent -= power;
+			return;
+		}
+		for (uint16_t i = 0; i < samples; i++) {
+			 this->_vReal[i] /= samples;
+			 this->_vImag[i] /= samples;
+		}
+	}
+
+	void SplitReal(uint8_t dir)
+	{// Between the half length transform Z of z[n] = x[2n] + j x[2n+1] and
+		// the spectrum X of x, with M = samples/2 and W = exp(-j 2 pi / samples):
+		//   E[k] = (Z[k] + Z*[M-k]) / 2    transform of the even samples
+		//   O[k] = (Z[k] - Z*[M-k]) / 2j   transform of the odd samples
+		//   X[k] = E[k] + W^k O[k]    and    X[M-k] = (E[k] - W^k O[k])*
+		// Reverse runs the same the other way. Bins k and M-k are done
+		// together, so it works in place
+		uint16_t half = (this->_samples >> 1);
+		T *re = this->_vReal;
+		T *im = this->_vImag;
+		if (dir == FFT_FORWARD) {
+			// Z[0] gives both X[0] and X[M], which are real
+			T z0 = re[0];
+			re[0] = z0 + im[0];
+			re[half] = z0 - im[0];
+			im[0] = 0;
+			im[half] = 0;
+		}
+		else {
+			T x0 = re[0];
+			re[0] = Math::Mean(x0, re[half]);
+			im[0] = Math::HalfDiff(x0, re[half]);
+		}
+		// W^k from the plan, or by rotation - one sin and cos a call
+		double stepAngle = TWO_PI / this->_samples;
+		double wr1 = cos(stepAngle);
+		double wi1 = (dir == FFT_FORWARD) ? -sin(stepAngle) : sin(stepAngle);
+		double ur = 1.0;
+		double ui = 0.0;
+		for (uint16_t k = 1; k <= (half >> 1); k++) {
+			T wr, wi;
+			if (this->_plan != NULL) {
+				wr = this->_plan->_cos[k];
+				wi = (dir == FFT_FORWARD) ? T(-this->_plan->_sin[k]) : this->_plan->_sin[k];
+			}
+			else {
+				double z = ur * wr1 - ui * wi1;
+				ui = ur * wi1 + ui * wr1;
+				ur = z;
+				wr = Math::FromDouble(ur);
+				wi = Math::FromDouble(ui);
+			}
+			uint16_t m = half - k;
+			T ar = re[k], ai = im[k];
+			T br = re[m], bi = im[m];
+			if (dir == FFT_FORWARD) {
+				T er = Math::Mean(ar, br), ei = Math::HalfDiff(ai, bi);
+				T orr = Math::Mean(ai, bi), oi = Math::HalfDiff(br, ar);
+				T tr = Math::MulSub(wr, orr, wi, oi);
+				T ti = Math::MulAdd(wr, oi, wi, orr);
+				re[k] = er + tr;
+				im[k] = ei + ti;
+				re[m] = er - tr;
+				im[m] = ti - ei;
+			}
+			else {
+				// E = (X[k] + X*[M-k]) / 2 and O = (X[k] - X*[M-k]) / 2 times
+				// W^-k, then Z = E + jO
+				T er = Math::Mean(ar, br), ei = Math::HalfDiff(ai, bi);
+				T dr = Math::HalfDiff(ar, br), di = Math::Mean(ai, bi);
+				T orr = Math::MulSub(dr, wr, di, wi);
+				T oi = Math::MulAdd(dr, wi, di, wr);
+				re[k] = er - oi;
+				im[k] = ei + orr;
+				re[m] = er + oi;
+				im[m] = orr - ei;
+			}
+		}
+	}
+};
+
+typedef arduinoFFTPlanCore<double> arduinoFFTPlan;
+typedef arduinoFFTCore<float> arduinoFFTFloat;
+typedef arduinoFFTCore<int16_t> arduinoFFTQ15;
+typedef arduinoFFTCore<int32_t> arduinoFFTQ31;
+
+#endif
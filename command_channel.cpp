@@ -0,0 +1,172 @@
+/***************************************************************
+//   Command channel - runtime settings from the host
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "command_channel.h"
+#include "crc16.h"
+#include "sample_codec.h"
+
+command_channel::command_channel()
+  : received(0), lost(0), answered(0),
+    register_waiting(false), register_id(0), register_sent_ms(0), ack_waiting(false)
+{
+  memset(&register_command, 0, sizeof(register_command));
+  memset(&ack, 0, sizeof(ack));
+}
+
+// A damaged command is still answered, with whatever command and tag
+// bytes it has, so the host is not left waiting for the timeout
+void command_channel::receive(const uint8_t *payload, uint16_t length)
+{
+  command_request request;
+  memset(&request, 0, sizeof(request));
+  request.result = COMMAND_OK;
+  if (length == sizeof(command_payload))
+  {
+    memcpy(&request.command, payload, sizeof(command_payload));
+    if (crc16(payload, sizeof(command_payload) - 2) != request.command.crc)
+    {
+      request.result = COMMAND_ERROR_DAMAGED;
+    }
+  }
+  else
+  {
+    memcpy(&request.command, payload, length < 2 ? length : 2);
+    request.result = COMMAND_ERROR_DAMAGED;
+  }
+  received++;
+  if (!requests.push(request))
+  {
+    lost++;
+  }
+}
+
+void command_channel::answer(packet_scheduler *scheduler, const command_payload *command, uint8_t result,
+                             uint32_t value)
+{
+  ack.command = command->command;
+  ack.tag = command->tag;
+  ack.result = result;
+  ack.value = value;
+  ack.crc = crc16((const uint8_t *)&ack, sizeof(ack) - 2);
+  ack_waiting = !scheduler->queue_ack(&ack);
+  answered++;
+}
+
+bool command_channel::run(packet_scheduler *scheduler, sensor_acquisition *acquisition, uint32_t now_ms)
+{
+  bool worked = false;
+  if (ack_waiting)
+  {
+    if (!scheduler->queue_ack(&ack))
+    {
+      return false;
+    }
+    ack_waiting = false;
+    worked = true;
+  }
+
+  // Results of timed out requests are passed over
+  register_op op;
+  while (acquisition->register_result(&op))
+  {
+    if (register_waiting && op.id == register_id)
+    {
+      register_waiting = false;
+      answer(scheduler, &register_command, op.ok ? COMMAND_OK : COMMAND_ERROR_FAILED, op.value);
+      worked = true;
+    }
+  }
+  if (register_waiting && now_ms - register_sent_ms >= COMMAND_REGISTER_TIMEOUT_MS)
+  {
+    register_waiting = false;
+    answer(scheduler, &register_command, COMMAND_ERROR_FAILED, 0);
+    worked = true;
+  }
+
+  command_request request;
+  while (!register_waiting && !ack_waiting && requests.pop(&request))
+  {
+    execute(&request, scheduler, acquisition, now_ms);
+    worked = true;
+  }
+  return worked;
+}
+
+void command_channel::execute(const command_request *request, packet_scheduler *scheduler,
+                              sensor_acquisition *acquisition, uint32_t now_ms)
+{
+  const command_payload *command = &request->command;
+  if (request->result != COMMAND_OK)
+  {
+    answer(scheduler, command, request->result, 0);
+    return;
+  }
+
+  switch (command->command)
+  {
+  case COMMAND_PING:
+    answer(scheduler, command, COMMAND_OK, COMMAND_PROTOCOL_VERSION);
+    break;
+
+  case COMMAND_READ_REGISTER:
+  case COMMAND_WRITE_REGISTER:
+  {
+    uint8_t last = command->target == COMMAND_TARGET_AFE4490 ? ACQ_AFE_LAST_REG : ACQ_ADS_LAST_REG;
+    if (command->target > COMMAND_TARGET_AFE4490 || command->address > last)
+    {
+      answer(scheduler, command, COMMAND_ERROR_ARGUMENT, 0);
+      break;
+    }
+    register_op op;
+    op.id = ++register_id;
+    op.target = command->target == COMMAND_TARGET_AFE4490 ? ACQ_TARGET_AFE4490 : ACQ_TARGET_ADS1292R;
+    op.address = command->address;
+    op.write = command->command == COMMAND_WRITE_REGISTER;
+    op.value = command->value;
+    op.ok = false;
+    if (!acquisition->request_register(&op))
+    {
+      answer(scheduler, command, COMMAND_ERROR_FAILED, 0);
+      break;
+    }
+    register_waiting = true;
+    register_sent_ms = now_ms;
+    register_command = *command;
+    break;
+  }
+
+  case COMMAND_STREAM_MODE:
+    if (command->value > STREAM_MODE_COMPRESSED || command->address >= SAMPLE_CODER_COUNT)
+    {
+      answer(scheduler, command, COMMAND_ERROR_ARGUMENT, scheduler->get_mode());
+      break;
+    }
+    scheduler->set_coder(command->address);
+    scheduler->set_mode((uint8_t)command->value);
+    answer(scheduler, command, COMMAND_OK, scheduler->get_mode());
+    break;
+
+  case COMMAND_DECIMATION:
+  {
+    uint8_t ecg = (uint8_t)command->value;
+    uint8_t ppg = (uint8_t)(command->value >> 8);
+    if (ecg < 1 || ecg > COMMAND_MAX_DECIMATION || ppg < 1 || ppg > COMMAND_MAX_DECIMATION)
+    {
+      answer(scheduler, command, COMMAND_ERROR_ARGUMENT,
+             scheduler->ecg_decimation() | (uint32_t)scheduler->ppg_decimation() << 8);
+      break;
+    }
+    scheduler->set_decimation(ecg, ppg);
+    answer(scheduler, command, COMMAND_OK, ecg | (uint32_t)ppg << 8);
+    break;
+  }
+
+  default:
+    answer(scheduler, command, COMMAND_ERROR_UNKNOWN, 0);
+    break;
+  }
+}
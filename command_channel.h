@@ -0,0 +1,84 @@
+/***************************************************************
+//   Command channel - runtime settings from the host
+//
+//   The host sends CES_CMDIF_TYPE_COMMAND frames (serial_frame.h) to
+//   read and write front end registers, change the stream mode and
+//   coder, and change the decimation of the waveforms, all without
+//   reflashing. Each command gets one CES_CMDIF_TYPE_ACK frame back,
+//   with the host's tag, a result and a value.
+//
+//   serial_transport reads the frames in the output stage and hands
+//   them to receive(), which checks them and queues them for the
+//   processing stage. run() carries them out there, in order, and
+//   queues the answers with the packet scheduler, so an answer is in
+//   order with the frames around it and the scheduler keeps its single
+//   producer. Register access is passed on to sensor_acquisition and
+//   answered when the bus has done it, or with COMMAND_ERROR_FAILED
+//   after COMMAND_REGISTER_TIMEOUT_MS; the commands after it wait.
+//
+//   A command that arrives with COMMAND_QUEUE_SIZE already waiting is
+//   dropped and counted in lost; the host sees no answer and sends it
+//   again.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef command_channel_h
+#define command_channel_h
+
+#include "Arduino.h"
+#include "serial_frame.h"
+#include "spsc_ring.h"
+#include "packet_scheduler.h"
+#include "sensor_acquisition.h"
+
+#define COMMAND_QUEUE_SIZE          4
+#define COMMAND_REGISTER_TIMEOUT_MS 100
+// Most samples averaged into one sent
+#define COMMAND_MAX_DECIMATION      16
+
+// A command as received, and COMMAND_OK or the error to answer with
+typedef struct command_Request{
+  command_payload command;
+  uint8_t result;
+}command_request;
+
+class command_channel
+{
+  public:
+    command_channel();
+
+    // Output stage - the payload of a CES_CMDIF_TYPE_COMMAND frame
+    void receive(const uint8_t *payload, uint16_t length);
+
+    // Processing stage - carry out the commands waiting and queue their
+    // answers. True if it did any work
+    bool run(packet_scheduler *scheduler, sensor_acquisition *acquisition, uint32_t now_ms);
+
+    // Written by the output stage
+    uint32_t received;
+    uint32_t lost;          // arrived with the queue full
+    // Written by the processing stage
+    uint32_t answered;
+
+  private:
+    void execute(const command_request *request, packet_scheduler *scheduler,
+                 sensor_acquisition *acquisition, uint32_t now_ms);
+    void answer(packet_scheduler *scheduler, const command_payload *command, uint8_t result, uint32_t value);
+
+    spsc_ring<command_request, COMMAND_QUEUE_SIZE> requests;
+
+    // Register access on the bus, at most one at a time
+    bool register_waiting;
+    uint8_t register_id;
+    uint32_t register_sent_ms;
+    command_payload register_command;
+
+    // Answer that found the packet queue full - goes out before anything
+    // else is done
+    bool ack_waiting;
+    ack_payload ack;
+};
+
+#endif
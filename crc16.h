@@ -0,0 +1,27 @@
+/***************************************************************
+//   CRC-16/CCITT-FALSE (poly 0x1021, initial value 0xFFFF, no
+//   reflection, no final XOR) - check value 0x29B1 for "123456789"
+//
+//   A nibble at a time from a 16 entry table: 32 bytes of flash and
+//   two lookups per byte.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef crc16_h
+#define crc16_h
+
+#include "Arduino.h"
+
+#define CRC16_INIT 0xFFFF
+
+// Continue a CRC over len more bytes - start with CRC16_INIT
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, size_t len);
+
+inline uint16_t crc16(const uint8_t *data, size_t len)
+{
+  return crc16_update(CRC16_INIT, data, len);
+}
+
+#endif
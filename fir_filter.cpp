@@ -0,0 +1,127 @@
+/***************************************************************
+//   Q15 FIR filter engine for the ECG and respiration channels
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "fir_filter.h"
+
+fir_filter::fir_filter() : coeffs(NULL), taps(0), symmetric(false), kernel(NULL), mac(NULL), fill(0)
+{
+}
+
+bool fir_filter::init(const int16_t *coeff_table, uint16_t n_taps)
+{
+  if (coeff_table == NULL || n_taps == 0 || n_taps > FIR_MAX_TAPS)
+  {
+    coeffs = NULL;
+    taps = 0;
+    return false;
+  }
+  taps = n_taps;
+
+  // Fold only if the table really is linear phase
+  symmetric = true;
+  for (uint16_t k = 0; k < (taps >> 1); k++)
+  {
+    if (coeff_table[k] != coeff_table[taps - 1 - k])
+    {
+      symmetric = false;
+      break;
+    }
+  }
+  // The kernels walk the window oldest first, so the table is applied
+  // back to front. A symmetric table reads the same either way.
+  if (symmetric)
+  {
+    coeffs = coeff_table;
+  }
+  else
+  {
+    for (uint16_t k = 0; k < taps; k++)
+    {
+      reversed[k] = coeff_table[taps - 1 - k];
+    }
+    coeffs = reversed;
+  }
+  if (kernel == NULL)
+  {
+    kernel = fir_kernel_best();
+  }
+  mac = symmetric ? kernel->folded : kernel->dot;
+  reset();
+  return true;
+}
+
+bool fir_filter::set_kernel(const fir_kernel *k)
+{
+  if (k == NULL)
+  {
+    return false;
+  }
+  kernel = k;
+  mac = symmetric ? kernel->folded : kernel->dot;
+  return true;
+}
+
+void fir_filter::reset()
+{
+  memset(history, 0, sizeof(history));
+  fill = (taps > 0) ? taps - 1 : 0;
+}
+
+// Keep the last taps-1 samples, freeing a block of space above them
+void fir_filter::shift_history()
+{
+  uint16_t keep = taps - 1;
+  memmove(history, &history[fill - keep], keep * sizeof(int16_t));
+  fill = keep;
+}
+
+int16_t fir_filter::process(int16_t sample)
+{
+  if (taps == 0)
+  {
+    return 0;
+  }
+  if (fill >= (sizeof(history) / sizeof(history[0])))
+  {
+    shift_history();
+  }
+  history[fill] = sample;
+  fill++;
+  return mac(&history[fill - taps], coeffs, taps);
+}
+
+void fir_filter::process_block(const int16_t *in, int16_t *out, uint16_t n)
+{
+  if (taps == 0)
+  {
+    memset(out, 0, n * sizeof(int16_t));
+    return;
+  }
+  const uint16_t capacity = sizeof(history) / sizeof(history[0]);
+  while (n > 0)
+  {
+    if (fill >= capacity)
+    {
+      shift_history();
+    }
+    uint16_t chunk = capacity - fill;
+    if (chunk > n)
+    {
+      chunk = n;
+    }
+    memcpy(&history[fill], in, chunk * sizeof(int16_t));
+    const int16_t *oldest = &history[fill + 1 - taps];
+    for (uint16_t i = 0; i < chunk; i++)
+    {
+      out[i] = mac(&oldest[i], coeffs, taps);
+    }
+    fill += chunk;
+    in += chunk;
+    out += chunk;
+    n -= chunk;
+  }
+}
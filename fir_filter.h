@@ -0,0 +1,71 @@
+/***************************************************************
+//   Q15 FIR filter engine for the ECG and respiration channels
+//
+//   Same arithmetic as ECG_FilterProcess/Resp_FilterProcess - 32 bit
+//   accumulate of Q15 taps * Q15 samples, saturate to Q30 and take the
+//   top 16 bits - so the output is bit for bit the same, but:
+//
+//   - Linear phase (symmetric) coefficient sets are folded by the scalar
+//     backends, adding the two samples that share a tap before the
+//     multiply. 161 taps then cost 81 multiplies instead of 161.
+//   - Samples go into a linear history buffer with room for a block of
+//     FIR_BLOCK_SIZE new samples. The taps-1 samples of history are
+//     moved down once per block rather than the window being rebuilt
+//     per sample, and process_block() filters N samples in one call.
+//
+//   The MAC loop itself runs through the fir_kernels backend picked by
+//   fir_kernel_best(), or the one given to set_kernel().
+//
+//   Symmetric tables are used in place and must outlive the filter,
+//   others are copied time reversed.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef fir_filter_h
+#define fir_filter_h
+
+#include "Arduino.h"
+#include "fir_kernels.h"
+
+#define FIR_MAX_TAPS    161
+// New samples held before the history is shifted down
+#define FIR_BLOCK_SIZE  32
+
+class fir_filter
+{
+  public:
+    fir_filter();
+    // Returns false if taps is out of range
+    bool init(const int16_t *coeffs, uint16_t taps);
+    // Clear the history - as if all past input was zero
+    void reset();
+    // Filter one sample
+    int16_t process(int16_t sample);
+    // Filter n samples - in and out may be the same buffer
+    void process_block(const int16_t *in, int16_t *out, uint16_t n);
+
+    // Run the MAC loop on another backend, false if k is NULL
+    bool set_kernel(const fir_kernel *k);
+    const fir_kernel *get_kernel() const { return kernel; }
+
+    bool is_symmetric() const { return symmetric; }
+    uint16_t length() const { return taps; }
+
+  private:
+    void shift_history();
+
+    // Coefficients in window order, oldest sample first
+    const int16_t *coeffs;
+    uint16_t taps;
+    bool symmetric;
+    const fir_kernel *kernel;
+    fir_q15_kernel mac;
+    int16_t reversed[FIR_MAX_TAPS];
+    // Oldest sample at history[0], next free slot at history[fill]
+    uint16_t fill;
+    int16_t history[FIR_MAX_TAPS - 1 + FIR_BLOCK_SIZE];
+};
+
+#endif
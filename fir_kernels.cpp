@@ -0,0 +1,234 @@
+/***************************************************************
+//   Q15 FIR MAC kernels with per-target backends
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "fir_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIR_HAVE_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FIR_HAVE_NEON 1
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Reference - the accumulators are unsigned so that near full scale they
+// wrap as the SIMD lanes do, rather than overflow a signed int
+
+static int16_t fir_dot_reference(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  uint32_t acc = 0;
+  for (uint16_t k = 0; k < taps; k++)
+  {
+    acc += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+  }
+  return fir_q30_to_q15((int32_t)acc);
+}
+
+// Add the two samples that share a tap before the multiply. The pair
+// needs 17 bits, so the product is taken modulo 2^32 as well.
+static int16_t fir_folded_reference(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  const int16_t *last = x + taps - 1;
+  uint16_t half = taps >> 1;
+  uint32_t acc = 0;
+  for (uint16_t k = 0; k < half; k++)
+  {
+    acc += (uint32_t)(int32_t)h[k] * (uint32_t)((int32_t)x[k] + (int32_t)last[-k]);
+  }
+  // Centre tap of an odd length filter
+  if (taps & 1)
+  {
+    acc += (uint32_t)((int32_t)h[half] * (int32_t)x[half]);
+  }
+  return fir_q30_to_q15((int32_t)acc);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ESP32 - the LX6 has one 16x16 MAC, so the win is in halving the
+// multiplies and keeping two independent accumulators in flight so
+// loads overlap the multiplies. Plain C so the host can check it too.
+
+static int16_t fir_dot_dual(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  uint32_t acc0 = 0, acc1 = 0;
+  uint16_t k = 0;
+  for (; k + 2 <= taps; k += 2)
+  {
+    acc0 += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+    acc1 += (uint32_t)((int32_t)h[k + 1] * (int32_t)x[k + 1]);
+  }
+  if (k < taps)
+  {
+    acc0 += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+  }
+  return fir_q30_to_q15((int32_t)(acc0 + acc1));
+}
+
+static int16_t fir_folded_dual(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  const int16_t *last = x + taps - 1;
+  uint16_t half = taps >> 1;
+  uint32_t acc0 = 0, acc1 = 0;
+  uint16_t k = 0;
+  for (; k + 2 <= half; k += 2)
+  {
+    acc0 += (uint32_t)(int32_t)h[k] * (uint32_t)((int32_t)x[k] + (int32_t)last[-k]);
+    acc1 += (uint32_t)(int32_t)h[k + 1] * (uint32_t)((int32_t)x[k + 1] + (int32_t)last[-(k + 1)]);
+  }
+  if (k < half)
+  {
+    acc0 += (uint32_t)(int32_t)h[k] * (uint32_t)((int32_t)x[k] + (int32_t)last[-k]);
+  }
+  if (taps & 1)
+  {
+    acc1 += (uint32_t)((int32_t)h[half] * (int32_t)x[half]);
+  }
+  return fir_q30_to_q15((int32_t)(acc0 + acc1));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// x86 - pmaddwd multiplies 16 bit pairs and adds adjacent products into
+// 32 bit lanes, which wrap exactly like the scalar accumulator
+
+#ifdef FIR_HAVE_X86
+static int16_t fir_dot_sse2(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  __m128i acc = _mm_setzero_si128();
+  uint16_t k = 0;
+  for (; k + 8 <= taps; k += 8)
+  {
+    __m128i xv = _mm_loadu_si128((const __m128i *)(x + k));
+    __m128i hv = _mm_loadu_si128((const __m128i *)(h + k));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(xv, hv));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  uint32_t sum = (uint32_t)_mm_cvtsi128_si32(acc);
+  for (; k < taps; k++)
+  {
+    sum += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+  }
+  return fir_q30_to_q15((int32_t)sum);
+}
+
+__attribute__((target("avx2")))
+static int16_t fir_dot_avx2(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  __m256i acc = _mm256_setzero_si256();
+  uint16_t k = 0;
+  for (; k + 16 <= taps; k += 16)
+  {
+    __m256i xv = _mm256_loadu_si256((const __m256i *)(x + k));
+    __m256i hv = _mm256_loadu_si256((const __m256i *)(h + k));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(xv, hv));
+  }
+  __m128i acc4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  if (k + 8 <= taps)
+  {
+    __m128i xv = _mm_loadu_si128((const __m128i *)(x + k));
+    __m128i hv = _mm_loadu_si128((const __m128i *)(h + k));
+    acc4 = _mm_add_epi32(acc4, _mm_madd_epi16(xv, hv));
+    k += 8;
+  }
+  acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, _MM_SHUFFLE(2, 3, 0, 1)));
+  uint32_t sum = (uint32_t)_mm_cvtsi128_si32(acc4);
+  for (; k < taps; k++)
+  {
+    sum += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+  }
+  return fir_q30_to_q15((int32_t)sum);
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+// NEON - widening multiply-accumulate into 32 bit lanes
+
+#ifdef FIR_HAVE_NEON
+static int16_t fir_dot_neon(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+  int32x4_t acc0 = vdupq_n_s32(0);
+  int32x4_t acc1 = vdupq_n_s32(0);
+  uint16_t k = 0;
+  for (; k + 8 <= taps; k += 8)
+  {
+    int16x8_t xv = vld1q_s16(x + k);
+    int16x8_t hv = vld1q_s16(h + k);
+    acc0 = vmlal_s16(acc0, vget_low_s16(xv), vget_low_s16(hv));
+    acc1 = vmlal_s16(acc1, vget_high_s16(xv), vget_high_s16(hv));
+  }
+  uint32x4_t acc = vaddq_u32(vreinterpretq_u32_s32(acc0), vreinterpretq_u32_s32(acc1));
+  uint32_t sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1)
+               + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+  for (; k < taps; k++)
+  {
+    sum += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+  }
+  return fir_q30_to_q15((int32_t)sum);
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Dispatch - the SIMD paths multiply 8 or 16 taps per instruction, which
+// beats folding, so they use the plain dot product for both forms
+
+static const fir_kernel fir_kernels[FIR_KERNEL_COUNT] = {
+  { "reference", fir_dot_reference, fir_folded_reference },
+#ifdef FIR_HAVE_X86
+  { "sse2", fir_dot_sse2, fir_dot_sse2 },
+  { "avx2", fir_dot_avx2, fir_dot_avx2 },
+#else
+  { "sse2", NULL, NULL },
+  { "avx2", NULL, NULL },
+#endif
+#ifdef FIR_HAVE_NEON
+  { "neon", fir_dot_neon, fir_dot_neon },
+#else
+  { "neon", NULL, NULL },
+#endif
+  { "esp32", fir_dot_dual, fir_folded_dual },
+};
+
+const fir_kernel *fir_kernel_get(uint8_t id)
+{
+  if (id >= FIR_KERNEL_COUNT || fir_kernels[id].dot == NULL)
+  {
+    return NULL;
+  }
+#ifdef FIR_HAVE_X86
+  if (id == FIR_KERNEL_AVX2)
+  {
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2"))
+    {
+      return NULL;
+    }
+  }
+#endif
+  return &fir_kernels[id];
+}
+
+const fir_kernel *fir_kernel_best()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return &fir_kernels[FIR_KERNEL_ESP32];
+#else
+  static const uint8_t order[] = { FIR_KERNEL_AVX2, FIR_KERNEL_SSE2, FIR_KERNEL_NEON };
+  for (uint8_t i = 0; i < sizeof(order); i++)
+  {
+    const fir_kernel *k = fir_kernel_get(order[i]);
+    if (k != NULL)
+    {
+      return k;
+    }
+  }
+  return &fir_kernels[FIR_KERNEL_REFERENCE];
+#endif
+}
@@ -0,0 +1,64 @@
+/***************************************************************
+//   Q15 FIR MAC kernels with per-target backends
+//
+//   Each kernel computes one FIR output as a dot product of the tap
+//   window (oldest sample first) with the time reversed coefficients,
+//   then applies the same Q30 saturation and >>15 as ECG_FilterProcess.
+//   The 32 bit accumulator wraps the same way whatever order the
+//   products are added in, so every backend returns the same value as
+//   the reference for every input.
+//
+//   dot    - any coefficient table
+//   folded - linear phase tables only, h[k] == h[taps-1-k]
+//
+//   Backends:
+//     reference  plain C, folded form (81 multiplies for 161 taps)
+//     sse2/avx2  x86 hosts, pmaddwd 8/16 taps at a time
+//     neon       ARM hosts, vmlal 8 taps at a time
+//     esp32      two accumulators, 2 taps per iteration, folded - suits
+//                the single MAC pipeline of the LX6
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef fir_kernels_h
+#define fir_kernels_h
+
+#include "Arduino.h"
+
+#define FIR_KERNEL_REFERENCE  0
+#define FIR_KERNEL_SSE2       1
+#define FIR_KERNEL_AVX2       2
+#define FIR_KERNEL_NEON       3
+#define FIR_KERNEL_ESP32      4
+#define FIR_KERNEL_COUNT      5
+
+typedef int16_t (*fir_q15_kernel)(const int16_t *x, const int16_t *h, uint16_t taps);
+
+typedef struct fir_Kernel{
+  const char *name;
+  fir_q15_kernel dot;
+  fir_q15_kernel folded;
+}fir_kernel;
+
+// NULL if the backend is not built for this target or the CPU lacks it
+const fir_kernel *fir_kernel_get(uint8_t id);
+// Fastest backend available here
+const fir_kernel *fir_kernel_best();
+
+// Saturate a Q30 accumulator and return the Q15 result
+static inline int16_t fir_q30_to_q15(int32_t acc)
+{
+  if ( acc > 0x3fffffff )
+  {
+    acc = 0x3fffffff;
+  }
+  else if ( acc < -0x40000000 )
+  {
+    acc = -0x40000000;
+  }
+  return (int16_t)(acc >> 15);
+}
+
+#endif
@@ -0,0 +1,193 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 Arduino core
+//   Pins, virtual time and interrupts
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SPI.h"
+#include "Wire.h"
+#include <atomic>
+
+#define HOST_MAX_PIN_HOOKS 8
+
+static uint8_t pin_mode[NUM_DIGITAL_PINS];
+static uint8_t pin_level[NUM_DIGITAL_PINS];
+
+static void (*isr_handler[NUM_DIGITAL_PINS])(void);
+static int isr_mode[NUM_DIGITAL_PINS];
+
+static struct
+{
+    uint8_t pin;
+    HostPinWriteHook hook;
+    void *ctx;
+} pin_hooks[HOST_MAX_PIN_HOOKS];
+static int pin_hook_count = 0;
+
+// Virtual time in microseconds since power on
+// Atomic as the pipeline tasks read it from their own threads
+static std::atomic<unsigned long long> host_micros(0);
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    pin_mode[pin] = mode;
+    // Pull ups read HIGH until driven
+    if ((mode & PULLUP) == PULLUP)
+    {
+        pin_level[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    pin_level[pin] = val ? HIGH : LOW;
+    for (int i = 0; i < pin_hook_count; i++)
+    {
+        if (pin_hooks[i].pin == pin)
+        {
+            pin_hooks[i].hook(pin, pin_level[pin], pin_hooks[i].ctx);
+        }
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return LOW;
+    }
+    return pin_level[pin];
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    isr_handler[pin] = handler;
+    isr_mode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    isr_handler[pin] = NULL;
+}
+
+// Interrupts only ever run from the host thread - nothing to mask
+void interrupts(void)
+{
+}
+
+void noInterrupts(void)
+{
+}
+
+unsigned long millis(void)
+{
+    return (unsigned long)(host_micros / 1000);
+}
+
+unsigned long micros(void)
+{
+    return (unsigned long)host_micros;
+}
+
+void delay(uint32_t ms)
+{
+    host_micros += (unsigned long long)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    host_micros += us;
+}
+
+void yield(void)
+{
+}
+
+// Host controls
+
+void hostAdvanceMicros(unsigned long us)
+{
+    host_micros += us;
+}
+
+void hostSetMicros(unsigned long us)
+{
+    host_micros = us;
+}
+
+void hostSetPin(uint8_t pin, uint8_t val)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    uint8_t old_level = pin_level[pin];
+    pin_level[pin] = val ? HIGH : LOW;
+    if (isr_handler[pin] == NULL || old_level == pin_level[pin])
+    {
+        return;
+    }
+    if ((isr_mode[pin] == CHANGE) ||
+        (isr_mode[pin] == RISING && pin_level[pin] == HIGH) ||
+        (isr_mode[pin] == FALLING && pin_level[pin] == LOW))
+    {
+        isr_handler[pin]();
+    }
+}
+
+bool hostTriggerInterrupt(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS || isr_handler[pin] == NULL)
+    {
+        return false;
+    }
+    isr_handler[pin]();
+    return true;
+}
+
+bool hostOnPinWrite(uint8_t pin, HostPinWriteHook hook, void *ctx)
+{
+    if (pin_hook_count >= HOST_MAX_PIN_HOOKS)
+    {
+        return false;
+    }
+    pin_hooks[pin_hook_count].pin = pin;
+    pin_hooks[pin_hook_count].hook = hook;
+    pin_hooks[pin_hook_count].ctx = ctx;
+    pin_hook_count++;
+    return true;
+}
+
+void hostReset(void)
+{
+    memset(pin_mode, 0, sizeof(pin_mode));
+    memset(pin_level, 0, sizeof(pin_level));
+    memset(isr_handler, 0, sizeof(isr_handler));
+    memset(isr_mode, 0, sizeof(isr_mode));
+    pin_hook_count = 0;
+    host_micros = 0;
+    hostSetSerialSink(NULL, NULL);
+    hostSerialClear();
+    SPI.hostDetachAll();
+    Wire.hostDetachAll();
+}
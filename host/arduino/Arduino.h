@@ -0,0 +1,97 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 Arduino core
+//
+//   Just enough of Arduino.h to build the HealthyPi signal chain
+//   unchanged on a build server - pins, time, interrupts and Serial.
+//   Time is virtual: delay() advances the clock instead of sleeping,
+//   so setup() and replayed data run as fast as the host allows.
+//   See HostShim.h for the calls a host program uses to drive it.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+// Attributes used by the ESP32 core - no meaning on the host
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+#define F(string_literal) (string_literal)
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+// Pin levels and modes
+#define LOW               0x0
+#define HIGH              0x1
+#define INPUT             0x01
+#define OUTPUT            0x02
+#define PULLUP            0x04
+#define INPUT_PULLUP      0x05
+#define PULLDOWN          0x08
+#define INPUT_PULLDOWN    0x09
+
+// Interrupt modes
+#define RISING    0x01
+#define FALLING   0x02
+#define CHANGE    0x03
+
+// ESP32 analog pin aliases used by the sketch
+#define A13 15
+#define A15 12
+
+#define NUM_DIGITAL_PINS 40
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define sq(x) ((x)*(x))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+
+#define digitalPinToInterrupt(p) (((p) < NUM_DIGITAL_PINS) ? (p) : -1)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+void interrupts(void);
+void noInterrupts(void);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+#include "HardwareSerial.h"
+
+#endif
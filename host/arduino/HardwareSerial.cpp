@@ -0,0 +1,199 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 HardwareSerial (UART0)
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Arduino.h"
+#include "HardwareSerial.h"
+#include "HostShim.h"
+#include <mutex>
+
+// Same depth as the ESP32 UART driver RX buffer
+#define SERIAL_HOST_RX_SIZE 256
+// Free TX space with the FIFO empty, as the ESP32 core reports it
+#define SERIAL_HOST_TX_SIZE 127
+
+static HostSerialSink serial_sink = NULL;
+static void *serial_sink_ctx = NULL;
+
+static uint8_t rx_buffer[SERIAL_HOST_RX_SIZE];
+static size_t rx_head = 0;
+static size_t rx_tail = 0;
+
+// Bytes in the TX FIFO as of tx_time_us - the output task writes
+// while the replay looks at the space left
+static std::mutex tx_lock;
+static unsigned long tx_level = 0;
+static unsigned long tx_time_us = 0;
+static unsigned long tx_stalls = 0;
+
+HardwareSerial Serial;
+
+HardwareSerial::HardwareSerial() : _baud(0)
+{
+}
+
+// Take out what the line has sent since tx_time_us - 10 bits a byte
+static void tx_drain(unsigned long baud)
+{
+    unsigned long now = micros();
+    if (baud == 0 || tx_level == 0)
+    {
+        tx_level = 0;
+        tx_time_us = now;
+        return;
+    }
+    unsigned long long sent = (unsigned long long)(now - tx_time_us) * baud / 10000000ULL;
+    if (sent >= tx_level)
+    {
+        tx_level = 0;
+        tx_time_us = now;
+    }
+    else
+    {
+        tx_level -= (unsigned long)sent;
+        tx_time_us += (unsigned long)(sent * 10000000ULL / baud);
+    }
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    std::lock_guard<std::mutex> lock(tx_lock);
+    _baud = baud;
+    tx_level = 0;
+    tx_time_us = micros();
+}
+
+void HardwareSerial::end()
+{
+    _baud = 0;
+}
+
+void HardwareSerial::updateBaudRate(unsigned long baud)
+{
+    std::lock_guard<std::mutex> lock(tx_lock);
+    tx_drain(_baud);
+    _baud = baud;
+}
+
+unsigned long HardwareSerial::baudRate()
+{
+    return _baud;
+}
+
+int HardwareSerial::available(void)
+{
+    return (int)((rx_head + SERIAL_HOST_RX_SIZE - rx_tail) % SERIAL_HOST_RX_SIZE);
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+    std::lock_guard<std::mutex> lock(tx_lock);
+    tx_drain(_baud);
+    return (tx_level >= SERIAL_HOST_TX_SIZE) ? 0 : (int)(SERIAL_HOST_TX_SIZE - tx_level);
+}
+
+int HardwareSerial::peek(void)
+{
+    if (rx_head == rx_tail)
+    {
+        return -1;
+    }
+    return rx_buffer[rx_tail];
+}
+
+int HardwareSerial::read(void)
+{
+    if (rx_head == rx_tail)
+    {
+        return -1;
+    }
+    uint8_t c = rx_buffer[rx_tail];
+    rx_tail = (rx_tail + 1) % SERIAL_HOST_RX_SIZE;
+    return c;
+}
+
+size_t HardwareSerial::read(uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && rx_head != rx_tail)
+    {
+        buffer[n++] = (uint8_t)read();
+    }
+    return n;
+}
+
+void HardwareSerial::flush(void)
+{
+    if (serial_sink == NULL)
+    {
+        fflush(stdout);
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(tx_lock);
+        tx_drain(_baud);
+        if (_baud != 0)
+        {
+            if (tx_level + size > SERIAL_HOST_TX_SIZE)
+            {
+                tx_stalls++;
+            }
+            tx_level += size;
+        }
+    }
+    if (serial_sink != NULL)
+    {
+        serial_sink(buffer, size, serial_sink_ctx);
+        return size;
+    }
+    return fwrite(buffer, 1, size, stdout);
+}
+
+// Host controls
+
+void hostSetSerialSink(HostSerialSink sink, void *ctx)
+{
+    serial_sink = sink;
+    serial_sink_ctx = ctx;
+}
+
+void hostSerialClear(void)
+{
+    rx_head = 0;
+    rx_tail = 0;
+    std::lock_guard<std::mutex> lock(tx_lock);
+    tx_level = 0;
+    tx_time_us = micros();
+    tx_stalls = 0;
+}
+
+unsigned long hostSerialTxStalls(void)
+{
+    return tx_stalls;
+}
+
+void hostSerialInject(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t next = (rx_head + 1) % SERIAL_HOST_RX_SIZE;
+        // Drop on overflow, as the UART driver does
+        if (next == rx_tail)
+        {
+            return;
+        }
+        rx_buffer[rx_head] = data[i];
+        rx_head = next;
+    }
+}
@@ -0,0 +1,55 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 HardwareSerial (UART0)
+//
+//   Bytes written to Serial go to a sink - stdout unless a host
+//   program installs its own with hostSetSerialSink() to capture
+//   the binary packet stream. Received bytes are queued by the host
+//   with hostSerialInject() and read back through available()/read().
+//
+//   Once begin() has set a rate the TX side behaves as the UART FIFO
+//   does: it holds 127 bytes and drains at baud/10 bytes per second of
+//   virtual time, and availableForWrite() reports the space left. The
+//   core's write() waits for space when the FIFO is full; here it takes
+//   every byte at once, as if it had waited, and counts hostSerialTxStalls().
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Print.h"
+
+class HardwareSerial : public Print
+{
+  public:
+    HardwareSerial();
+
+    void begin(unsigned long baud);
+    void end();
+    void updateBaudRate(unsigned long baud);
+    unsigned long baudRate();
+
+    int available(void);
+    int availableForWrite(void);
+    int peek(void);
+    int read(void);
+    size_t read(uint8_t *buffer, size_t size);
+    void flush(void);
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+
+    operator bool() const { return true; }
+
+  private:
+    unsigned long _baud;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,45 @@
+/***************************************************************
+//   Controls for the host (Linux) Arduino shim
+//
+//   Only host programs (replay, benchmarks, simulators) include this.
+//   Firmware sources see the plain Arduino API in Arduino.h.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef HostShim_h
+#define HostShim_h
+
+#include "Arduino.h"
+
+// Virtual clock - advanced by delay() and by the host program
+void hostAdvanceMicros(unsigned long us);
+void hostSetMicros(unsigned long us);
+
+// Drive an input pin from outside, as a sensor would.
+// Fires the attached interrupt if the edge matches its mode.
+void hostSetPin(uint8_t pin, uint8_t val);
+// Fire the handler attached to pin regardless of level
+bool hostTriggerInterrupt(uint8_t pin);
+
+// Called on every digitalWrite() to pin - used by simulated SPI
+// devices to see their chip select
+typedef void (*HostPinWriteHook)(uint8_t pin, uint8_t val, void *ctx);
+bool hostOnPinWrite(uint8_t pin, HostPinWriteHook hook, void *ctx);
+
+// Serial output sink - default writes to stdout
+typedef void (*HostSerialSink)(const uint8_t *data, size_t len, void *ctx);
+void hostSetSerialSink(HostSerialSink sink, void *ctx);
+// Queue bytes to be read by Serial.read()
+void hostSerialInject(const uint8_t *data, size_t len);
+// Drop any bytes not yet read or sent
+void hostSerialClear(void);
+// Writes that found the TX FIFO too full and would have waited
+unsigned long hostSerialTxStalls(void);
+
+// Put the pins, clock, interrupts and serial back to power-on state.
+// Simulated SPI and I2C devices are detached - attach them afterwards.
+void hostReset(void);
+
+#endif
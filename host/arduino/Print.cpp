@@ -0,0 +1,243 @@
+/***************************************************************
+//   Host (Linux) stand-in for the Arduino Print class
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Arduino.h"
+#include "Print.h"
+#include <stdarg.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char *str)
+{
+    if (str == NULL)
+    {
+        return 0;
+    }
+    return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const char *buffer, size_t size)
+{
+    return write((const uint8_t *)buffer, size);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char loc_buf[64];
+    char *temp = loc_buf;
+    va_list arg;
+    va_list copy;
+    va_start(arg, format);
+    va_copy(copy, arg);
+    int len = vsnprintf(temp, sizeof(loc_buf), format, copy);
+    va_end(copy);
+    if (len < 0)
+    {
+        va_end(arg);
+        return 0;
+    }
+    if (len >= (int)sizeof(loc_buf))
+    {
+        temp = (char *)malloc(len + 1);
+        if (temp == NULL)
+        {
+            va_end(arg);
+            return 0;
+        }
+        len = vsnprintf(temp, len + 1, format, arg);
+    }
+    va_end(arg);
+    len = write((const uint8_t *)temp, len);
+    if (temp != loc_buf)
+    {
+        free(temp);
+    }
+    return len;
+}
+
+size_t Print::print(const char str[])
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char b, int base)
+{
+    return print((unsigned long)b, base);
+}
+
+size_t Print::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)n);
+    }
+    if (base == 10 && n < 0)
+    {
+        size_t t = print('-');
+        return printNumber((unsigned long)(-n), 10) + t;
+    }
+    return printNumber((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)n);
+    }
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+    return printFloat(n, digits);
+}
+
+size_t Print::println(void)
+{
+    return print("\r\n");
+}
+
+size_t Print::println(const char c[])
+{
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(char c)
+{
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(unsigned char b, int base)
+{
+    size_t n = print(b, base);
+    return n + println();
+}
+
+size_t Print::println(int num, int base)
+{
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned int num, int base)
+{
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(long num, int base)
+{
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(unsigned long num, int base)
+{
+    size_t n = print(num, base);
+    return n + println();
+}
+
+size_t Print::println(double num, int digits)
+{
+    size_t n = print(num, digits);
+    return n + println();
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(n) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+    if (base < 2)
+    {
+        base = 10;
+    }
+    do
+    {
+        unsigned long m = n;
+        n /= base;
+        char c = m - base * n;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits)
+{
+    if (isnan(number))
+    {
+        return print("nan");
+    }
+    if (isinf(number))
+    {
+        return print("inf");
+    }
+    if (number > 4294967040.0 || number < -4294967040.0)
+    {
+        return print("ovf");
+    }
+
+    size_t n = 0;
+    if (number < 0.0)
+    {
+        n += print('-');
+        number = -number;
+    }
+
+    // Round correctly so that print(1.999, 2) prints as "2.00"
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i)
+    {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += print(int_part);
+
+    if (digits > 0)
+    {
+        n += print('.');
+    }
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        int to_print = int(remainder);
+        n += print(to_print);
+        remainder -= to_print;
+    }
+    return n;
+}
@@ -0,0 +1,53 @@
+/***************************************************************
+//   Host (Linux) stand-in for the Arduino Print class
+//
+//   Formats numbers and text the same way the ESP32 core does and
+//   hands the bytes to write(), which Serial implements.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef Print_h
+#define Print_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str);
+    size_t write(const char *buffer, size_t size);
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char str[]);
+    size_t print(char c);
+    size_t print(unsigned char b, int base = 10);
+    size_t print(int n, int base = 10);
+    size_t print(unsigned int n, int base = 10);
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(double n, int digits = 2);
+
+    size_t println(void);
+    size_t println(const char str[]);
+    size_t println(char c);
+    size_t println(unsigned char b, int base = 10);
+    size_t println(int n, int base = 10);
+    size_t println(unsigned int n, int base = 10);
+    size_t println(long n, int base = 10);
+    size_t println(unsigned long n, int base = 10);
+    size_t println(double n, int digits = 2);
+
+  private:
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double number, uint8_t digits);
+};
+
+#endif
@@ -0,0 +1,129 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 SPI class
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SPI.h"
+
+SPIClass SPI;
+
+SPIClass::SPIClass()
+    : _dataMode(SPI_MODE0), _bitOrder(MSBFIRST), _clockDiv(SPI_CLOCK_DIV16), _bytes(0), _count(0)
+{
+}
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss)
+{
+    (void)sck;
+    (void)miso;
+    (void)mosi;
+    (void)ss;
+    _bytes = 0;
+}
+
+void SPIClass::end()
+{
+}
+
+void SPIClass::setBitOrder(uint8_t bitOrder)
+{
+    _bitOrder = bitOrder;
+}
+
+void SPIClass::setDataMode(uint8_t dataMode)
+{
+    _dataMode = dataMode;
+}
+
+void SPIClass::setFrequency(uint32_t freq)
+{
+    (void)freq;
+}
+
+void SPIClass::setClockDivider(uint32_t clockDiv)
+{
+    _clockDiv = clockDiv;
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+    _bitOrder = settings._bitOrder;
+    _dataMode = settings._dataMode;
+}
+
+void SPIClass::endTransaction(void)
+{
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    _bytes++;
+    HostSPIDevice *device = selectedDevice();
+    if (device == NULL)
+    {
+        return 0;
+    }
+    return device->transfer(data, _dataMode);
+}
+
+void SPIClass::transferBytes(const uint8_t *data, uint8_t *out, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        uint8_t in = transfer(data ? data[i] : 0xFF);
+        if (out)
+        {
+            out[i] = in;
+        }
+    }
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size)
+{
+    transferBytes(data, NULL, size);
+}
+
+bool SPIClass::hostAttach(uint8_t cs_pin, HostSPIDevice *device)
+{
+    if (_count >= SPI_HOST_MAX_DEVICES)
+    {
+        return false;
+    }
+    _cs[_count] = cs_pin;
+    _devices[_count] = device;
+    _count++;
+    return hostOnPinWrite(cs_pin, pinWritten, this);
+}
+
+void SPIClass::hostDetachAll()
+{
+    _count = 0;
+}
+
+void SPIClass::pinWritten(uint8_t pin, uint8_t val, void *ctx)
+{
+    SPIClass *spi = (SPIClass *)ctx;
+    for (uint8_t i = 0; i < spi->_count; i++)
+    {
+        if (spi->_cs[i] == pin)
+        {
+            spi->_devices[i]->select(val == LOW);
+        }
+    }
+}
+
+HostSPIDevice *SPIClass::selectedDevice()
+{
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (digitalRead(_cs[i]) == LOW)
+        {
+            return _devices[i];
+        }
+    }
+    return NULL;
+}
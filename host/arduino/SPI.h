@@ -0,0 +1,96 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 SPI class
+//
+//   There is no bus on the host. A simulated peripheral registers
+//   itself against its chip select pin with SPI.hostAttach() and
+//   receives every byte clocked while that pin is held LOW.
+//   With nothing attached transfer() returns 0.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+#define SPI_CLOCK_DIV2    0x00101001
+#define SPI_CLOCK_DIV4    0x00241001
+#define SPI_CLOCK_DIV8    0x004c1001
+#define SPI_CLOCK_DIV16   0x009c1001
+#define SPI_CLOCK_DIV32   0x013c1001
+#define SPI_CLOCK_DIV64   0x027c1001
+
+#define SPI_HOST_MAX_DEVICES 4
+
+// A peripheral on the simulated bus
+class HostSPIDevice
+{
+  public:
+    virtual ~HostSPIDevice() {}
+    // Chip select edge - selected is true when CS goes LOW
+    virtual void select(bool selected) { (void)selected; }
+    // One full duplex byte - return what the device shifts out
+    virtual uint8_t transfer(uint8_t data, uint8_t data_mode) = 0;
+};
+
+class SPISettings
+{
+  public:
+    SPISettings() : _clock(1000000), _bitOrder(MSBFIRST), _dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+      : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+    uint32_t _clock;
+    uint8_t _bitOrder;
+    uint8_t _dataMode;
+};
+
+class SPIClass
+{
+  public:
+    SPIClass();
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void end();
+
+    void setBitOrder(uint8_t bitOrder);
+    void setDataMode(uint8_t dataMode);
+    void setFrequency(uint32_t freq);
+    void setClockDivider(uint32_t clockDiv);
+
+    void beginTransaction(SPISettings settings);
+    void endTransaction(void);
+
+    uint8_t transfer(uint8_t data);
+    void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size);
+    void writeBytes(const uint8_t *data, uint32_t size);
+
+    uint8_t dataMode() const { return _dataMode; }
+
+    // Host only - route transfers made while cs_pin is LOW to device
+    bool hostAttach(uint8_t cs_pin, HostSPIDevice *device);
+    void hostDetachAll();
+    // Number of bytes clocked since begin()
+    uint32_t hostBytesTransferred() const { return _bytes; }
+
+  private:
+    static void pinWritten(uint8_t pin, uint8_t val, void *ctx);
+    HostSPIDevice *selectedDevice();
+
+    uint8_t _dataMode;
+    uint8_t _bitOrder;
+    uint32_t _clockDiv;
+    uint32_t _bytes;
+    uint8_t _count;
+    uint8_t _cs[SPI_HOST_MAX_DEVICES];
+    HostSPIDevice *_devices[SPI_HOST_MAX_DEVICES];
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,13 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 OTA Update library
+//
+//   The sketch includes Update.h but never uses it - nothing to do.
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef ESP8266UPDATER_H
+#define ESP8266UPDATER_H
+
+#include "Arduino.h"
+
+#endif
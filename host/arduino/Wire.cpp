@@ -0,0 +1,176 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 TwoWire (I2C) class
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Arduino.h"
+#include "Wire.h"
+
+// endTransmission() results, as the ESP32 core reports them
+#define I2C_OK          0
+#define I2C_NACK_ADDR   2
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+    : _txAddress(0), _txLength(0), _rxIndex(0), _rxLength(0), _count(0)
+{
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+}
+
+void TwoWire::end()
+{
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+    (void)frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _txAddress = address;
+    _txLength = 0;
+}
+
+void TwoWire::beginTransmission(int address)
+{
+    beginTransmission((uint8_t)address);
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    HostI2CDevice *device = deviceAt(_txAddress);
+    if (device == NULL)
+    {
+        _txLength = 0;
+        return I2C_NACK_ADDR;
+    }
+    device->receive(_txBuffer, _txLength);
+    _txLength = 0;
+    return I2C_OK;
+}
+
+uint8_t TwoWire::endTransmission(void)
+{
+    return endTransmission(true);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size, uint8_t sendStop)
+{
+    (void)sendStop;
+    _rxIndex = 0;
+    _rxLength = 0;
+    HostI2CDevice *device = deviceAt(address);
+    if (device == NULL)
+    {
+        return 0;
+    }
+    if (size > I2C_BUFFER_LENGTH)
+    {
+        size = I2C_BUFFER_LENGTH;
+    }
+    _rxLength = device->request(_rxBuffer, size);
+    return (uint8_t)_rxLength;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size)
+{
+    return requestFrom(address, size, (uint8_t)true);
+}
+
+uint8_t TwoWire::requestFrom(int address, int size)
+{
+    return requestFrom((uint8_t)address, (uint8_t)size, (uint8_t)true);
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (_txLength >= I2C_BUFFER_LENGTH)
+    {
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (!write(data[i]))
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+int TwoWire::available(void)
+{
+    return (int)(_rxLength - _rxIndex);
+}
+
+int TwoWire::read(void)
+{
+    if (_rxIndex >= _rxLength)
+    {
+        return -1;
+    }
+    return _rxBuffer[_rxIndex++];
+}
+
+int TwoWire::peek(void)
+{
+    if (_rxIndex >= _rxLength)
+    {
+        return -1;
+    }
+    return _rxBuffer[_rxIndex];
+}
+
+void TwoWire::flush(void)
+{
+    _rxIndex = 0;
+    _rxLength = 0;
+    _txLength = 0;
+}
+
+bool TwoWire::hostAttach(uint8_t address, HostI2CDevice *device)
+{
+    if (_count >= WIRE_HOST_MAX_DEVICES)
+    {
+        return false;
+    }
+    _address[_count] = address;
+    _devices[_count] = device;
+    _count++;
+    return true;
+}
+
+void TwoWire::hostDetachAll()
+{
+    _count = 0;
+}
+
+HostI2CDevice *TwoWire::deviceAt(uint8_t address)
+{
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (_address[i] == address)
+        {
+            return _devices[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,77 @@
+/***************************************************************
+//   Host (Linux) stand-in for the ESP32 TwoWire (I2C) class
+//
+//   A simulated I2C peripheral registers its 7 bit address with
+//   Wire.hostAttach(). Writes between beginTransmission() and
+//   endTransmission() are delivered to it in one call, and
+//   requestFrom() asks it for the reply. Unattached addresses NACK,
+//   so the sketch sees "MLX90614 not found" by default.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+#define WIRE_HOST_MAX_DEVICES 4
+
+// A peripheral on the simulated bus
+class HostI2CDevice
+{
+  public:
+    virtual ~HostI2CDevice() {}
+    // Bytes written in one transmission
+    virtual void receive(const uint8_t *data, size_t len) = 0;
+    // Fill up to len bytes for a read - return the number supplied
+    virtual size_t request(uint8_t *data, size_t len) = 0;
+};
+
+class TwoWire
+{
+  public:
+    TwoWire();
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void end();
+    void setClock(uint32_t frequency);
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address);
+    uint8_t endTransmission(bool sendStop);
+    uint8_t endTransmission(void);
+
+    uint8_t requestFrom(uint8_t address, uint8_t size, uint8_t sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t size);
+    uint8_t requestFrom(int address, int size);
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t size);
+    int available(void);
+    int read(void);
+    int peek(void);
+    void flush(void);
+
+    // Host only - put a simulated device on the bus
+    bool hostAttach(uint8_t address, HostI2CDevice *device);
+    void hostDetachAll();
+
+  private:
+    HostI2CDevice *deviceAt(uint8_t address);
+
+    uint8_t _txAddress;
+    uint8_t _txBuffer[I2C_BUFFER_LENGTH];
+    size_t _txLength;
+    uint8_t _rxBuffer[I2C_BUFFER_LENGTH];
+    size_t _rxIndex;
+    size_t _rxLength;
+    uint8_t _count;
+    uint8_t _address[WIRE_HOST_MAX_DEVICES];
+    HostI2CDevice *_devices[WIRE_HOST_MAX_DEVICES];
+};
+
+extern TwoWire Wire;
+
+#endif
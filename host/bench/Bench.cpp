@@ -0,0 +1,172 @@
+/***************************************************************
+//   Minimal benchmark harness for the host build
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Bench.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+volatile int32_t bench_sink = 0;
+
+static uint64_t bench_ticks()
+{
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double bench_seconds()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchSuite::BenchSuite(const char *name) : _name(name)
+{
+}
+
+void BenchSuite::add(const char *group, const char *name, BenchFunction run, void *ctx,
+                     uint32_t samples_per_iteration, double sample_rate_hz)
+{
+    bench_case c;
+    memset(&c, 0, sizeof(c));
+    c.name = name;
+    c.group = group;
+    c.run = run;
+    c.ctx = ctx;
+    c.samples_per_iteration = samples_per_iteration;
+    c.sample_rate_hz = sample_rate_hz;
+    _cases.push_back(c);
+}
+
+void BenchSuite::setBytesPerSample(double bytes_per_sample)
+{
+    if (!_cases.empty())
+    {
+        _cases.back().bytes_per_sample = bytes_per_sample;
+    }
+}
+
+void BenchSuite::run(const char *filter, double min_seconds, int repeats)
+{
+    if (repeats < 1)
+    {
+        repeats = 1;
+    }
+    if (repeats > BENCH_MAX_REPEATS)
+    {
+        repeats = BENCH_MAX_REPEATS;
+    }
+
+    for (size_t i = 0; i < _cases.size(); i++)
+    {
+        bench_case &c = _cases[i];
+        if (filter != NULL && strstr(c.name, filter) == NULL)
+        {
+            continue;
+        }
+
+        // Warm up and grow the iteration count until one run is long enough
+        uint64_t iterations = 1;
+        for (;;)
+        {
+            double start = bench_seconds();
+            c.run((uint32_t)iterations, c.ctx);
+            double elapsed = bench_seconds() - start;
+            if (elapsed >= min_seconds || iterations >= (1u << 30))
+            {
+                break;
+            }
+            iterations = (elapsed > 0) ? (uint64_t)(iterations * (min_seconds / elapsed) * 1.2) + 1
+                                       : iterations * 10;
+        }
+
+        double ns[BENCH_MAX_REPEATS];
+        double ticks[BENCH_MAX_REPEATS];
+        double samples = (double)iterations * c.samples_per_iteration;
+        for (int r = 0; r < repeats; r++)
+        {
+            double start = bench_seconds();
+            uint64_t tick_start = bench_ticks();
+            c.run((uint32_t)iterations, c.ctx);
+            uint64_t tick_end = bench_ticks();
+            double elapsed = bench_seconds() - start;
+            ns[r] = elapsed * 1e9 / samples;
+            ticks[r] = (double)(tick_end - tick_start) / samples;
+        }
+        std::sort(ns, ns + repeats);
+        std::sort(ticks, ticks + repeats);
+        c.iterations = iterations;
+        c.ns_per_sample = ns[repeats / 2];
+        c.ns_per_sample_min = ns[0];
+        c.ticks_per_sample = ticks[repeats / 2];
+    }
+}
+
+void BenchSuite::writeJson(FILE *out) const
+{
+    fprintf(out, "{\n  \"suite\": \"%s\",\n", _name);
+#ifdef __VERSION__
+    fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(out, "  \"tsc\": %s,\n", BENCH_HAVE_TSC ? "true" : "false");
+    fprintf(out, "  \"benchmarks\": [");
+    bool first = true;
+    for (size_t i = 0; i < _cases.size(); i++)
+    {
+        const bench_case &c = _cases[i];
+        if (c.iterations == 0)
+        {
+            continue;
+        }
+        double budget_ns = 1e9 / c.sample_rate_hz;
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"group\": \"%s\", "
+                "\"samples_per_call\": %u, \"calls\": %llu, "
+                "\"ns_per_sample\": %.3f, \"ns_per_sample_min\": %.3f, "
+                "\"ticks_per_sample\": %.1f, \"sample_rate_hz\": %.1f, "
+                "\"budget_percent\": %.5f",
+                first ? "" : ",", c.name, c.group, c.samples_per_iteration,
+                (unsigned long long)c.iterations, c.ns_per_sample, c.ns_per_sample_min,
+                c.ticks_per_sample, c.sample_rate_hz, 100.0 * c.ns_per_sample / budget_ns);
+        if (c.bytes_per_sample > 0)
+        {
+            fprintf(out, ", \"bytes_per_sample\": %.4f", c.bytes_per_sample);
+        }
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void BenchSuite::writeTable(FILE *out) const
+{
+    fprintf(out, "%-36s %12s %12s %12s %12s\n", "benchmark", "ns/sample", "ticks/sample", "% budget", "bytes/sample");
+    for (size_t i = 0; i < _cases.size(); i++)
+    {
+        const bench_case &c = _cases[i];
+        if (c.iterations == 0)
+        {
+            continue;
+        }
+        double budget_ns = 1e9 / c.sample_rate_hz;
+        fprintf(out, "%-36s %12.2f %12.1f %12.5f", c.name, c.ns_per_sample,
+                c.ticks_per_sample, 100.0 * c.ns_per_sample / budget_ns);
+        if (c.bytes_per_sample > 0)
+        {
+            fprintf(out, " %12.3f", c.bytes_per_sample);
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,68 @@
+/***************************************************************
+//   Minimal benchmark harness for the host build
+//
+//   Each case runs a kernel over a block of samples. The harness picks
+//   an iteration count that fills the minimum run time, repeats the
+//   run, and reports the median and best time per sample together with
+//   the share of the sample period that cost represents on the stream
+//   the kernel serves (8 ms for the ADS1292R at 125 SPS, 2 ms for the
+//   AFE4490 at 500 SPS, 40 ms for the decimated 25 SPS PPG).
+//   Results are written as JSON so they can be compared per commit.
+//
+//   Host timings are indicative only - the ESP32 is an in-order core
+//   at 240 MHz - but relative changes carry over.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef Bench_h
+#define Bench_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#define BENCH_MAX_REPEATS 15
+
+// Run the kernel iterations times - each iteration handles
+// samples_per_iteration samples
+typedef void (*BenchFunction)(uint32_t iterations, void *ctx);
+
+typedef struct bench_Case{
+  const char *name;
+  const char *group;
+  BenchFunction run;
+  void *ctx;
+  uint32_t samples_per_iteration;
+  double sample_rate_hz;         // rate of the stream this kernel serves
+  // Results
+  uint64_t iterations;
+  double ns_per_sample;          // median of the repeats
+  double ns_per_sample_min;
+  double ticks_per_sample;       // TSC ticks on x86, 0 elsewhere
+  double bytes_per_sample;       // output size of a coder, 0 if not one
+}bench_case;
+
+class BenchSuite
+{
+  public:
+    BenchSuite(const char *name);
+    void add(const char *group, const char *name, BenchFunction run, void *ctx,
+             uint32_t samples_per_iteration, double sample_rate_hz);
+    // For the case just added, when it codes samples into bytes
+    void setBytesPerSample(double bytes_per_sample);
+    // Run every case whose name contains filter (NULL runs all)
+    void run(const char *filter, double min_seconds, int repeats);
+    void writeJson(FILE *out) const;
+    void writeTable(FILE *out) const;
+
+  private:
+    const char *_name;
+    std::vector<bench_case> _cases;
+};
+
+// Keep the optimiser from discarding a result
+extern volatile int32_t bench_sink;
+
+#endif
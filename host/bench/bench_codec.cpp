@@ -0,0 +1,188 @@
+/***************************************************************
+//   Benchmarks for the waveform sample coders
+//
+//   Each case codes one channel in blocks of the size the compressed
+//   batch frame uses (5 ECG, 20 PPG samples), so ns_per_sample is the
+//   cost per sample per channel and bytes_per_sample the size it codes
+//   to - 2 bytes raw for ECG/resp, 3 for IR/RED.
+//
+//   The samples come from a sample text recording (Recording.h) when
+//   one is given, taken as the sketch sends them (ECG and resp >> 8),
+//   otherwise from synthetic signals of the same shape.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <Arduino.h>
+#include <vector>
+#include "Bench.h"
+#include "Recording.h"
+#include "sample_codec.h"
+#include "serial_frame.h"
+
+#define BENCH_ECG_SPS     125.0
+#define BENCH_PPG_SPS     500.0
+#define BENCH_CODEC_SECONDS 60          // synthetic signal length
+
+enum
+{
+    CHANNEL_ECG,
+    CHANNEL_RESP,
+    CHANNEL_IR,
+    CHANNEL_RED,
+    CHANNEL_COUNT
+};
+
+static const char *channel_names[CHANNEL_COUNT] = {"ecg", "resp", "ir", "red"};
+
+static std::vector<int32_t> channels[CHANNEL_COUNT];
+
+typedef struct bench_Codec{
+  uint8_t coder;
+  const std::vector<int32_t> *signal;
+  uint16_t block;
+  std::vector<uint8_t> coded;        // whole signal, block after block
+  std::vector<size_t> offsets;       // start of each block in coded
+  char name[48];
+}bench_codec;
+
+static bench_codec codec_cases[SAMPLE_CODER_COUNT][CHANNEL_COUNT][2];
+
+static bool load_recording(const char *path)
+{
+    Recording recording;
+    if (!recording.open(path, false))
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    replay_event event;
+    while (recording.next(&event))
+    {
+        if (event.type == REPLAY_EVENT_ECG)
+        {
+            channels[CHANNEL_ECG].push_back((int16_t)(event.v1 >> 8));
+            channels[CHANNEL_RESP].push_back((int16_t)(event.v2 >> 8));
+        }
+        else if (event.type == REPLAY_EVENT_PPG)
+        {
+            channels[CHANNEL_IR].push_back(event.v1);
+            channels[CHANNEL_RED].push_back(event.v2);
+        }
+    }
+    return true;
+}
+
+// Small repeatable noise, so runs code the same data
+static int32_t noise(int32_t amplitude)
+{
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (int32_t)(state % (2 * amplitude + 1)) - amplitude;
+}
+
+static void make_signals()
+{
+    for (int n = 0; n < BENCH_CODEC_SECONDS * BENCH_ECG_SPS; n++)
+    {
+        double t = n / BENCH_ECG_SPS;
+        double qrs = exp(-sq((fmod(t * 1.2, 1.0) - 0.3) / 0.012));
+        channels[CHANNEL_ECG].push_back((int32_t)(4000.0 * qrs + 300.0 * sin(TWO_PI * 0.25 * t) + noise(8)));
+        channels[CHANNEL_RESP].push_back((int32_t)(3000.0 * sin(TWO_PI * 0.25 * t) + noise(8)));
+    }
+    for (int n = 0; n < BENCH_CODEC_SECONDS * BENCH_PPG_SPS; n++)
+    {
+        double t = n / BENCH_PPG_SPS;
+        double pulse = exp(-sq((fmod(t * 1.2, 1.0) - 0.25) / 0.08));
+        channels[CHANNEL_IR].push_back((int32_t)(200000.0 + 6000.0 * pulse + noise(40)));
+        channels[CHANNEL_RED].push_back((int32_t)(160000.0 + 2400.0 * pulse + noise(40)));
+    }
+}
+
+// Code the whole signal once - the decode cases and the size come from it
+static void prepare(bench_codec *c)
+{
+    uint8_t out[BATCH_FRAME_MAX];
+    size_t blocks = c->signal->size() / c->block;
+    c->coded.clear();
+    c->offsets.clear();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        size_t bytes = sample_encode(c->coder, &(*c->signal)[b * c->block], c->block, out, sizeof(out));
+        c->offsets.push_back(c->coded.size());
+        c->coded.insert(c->coded.end(), out, out + bytes);
+    }
+    c->offsets.push_back(c->coded.size());
+}
+
+static void bench_encode(uint32_t iterations, void *ctx)
+{
+    bench_codec *c = (bench_codec *)ctx;
+    size_t blocks = c->offsets.size() - 1;
+    uint8_t out[BATCH_FRAME_MAX];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        const int32_t *samples = &(*c->signal)[(i % blocks) * c->block];
+        total += sample_encode(c->coder, samples, c->block, out, sizeof(out));
+    }
+    bench_sink = (int32_t)total + out[0];
+}
+
+static void bench_decode(uint32_t iterations, void *ctx)
+{
+    bench_codec *c = (bench_codec *)ctx;
+    size_t blocks = c->offsets.size() - 1;
+    int32_t samples[BATCH_PPG_SAMPLES];
+    int32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        size_t b = i % blocks;
+        sample_decode(c->coder, &c->coded[c->offsets[b]], c->offsets[b + 1] - c->offsets[b],
+                      samples, c->block);
+        total += samples[c->block - 1];
+    }
+    bench_sink = total;
+}
+
+bool register_codec_benchmarks(BenchSuite &suite, const char *recording)
+{
+    if (recording == NULL)
+    {
+        make_signals();
+    }
+    else if (!load_recording(recording))
+    {
+        return false;
+    }
+    for (uint8_t coder = 0; coder < SAMPLE_CODER_COUNT; coder++)
+    {
+        const char *coder_name = (coder == SAMPLE_CODER_RICE) ? "rice" : "varint";
+        for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++)
+        {
+            bool ecg = (ch == CHANNEL_ECG || ch == CHANNEL_RESP);
+            uint16_t block = ecg ? BATCH_ECG_SAMPLES : BATCH_PPG_SAMPLES;
+            double rate = ecg ? BENCH_ECG_SPS : BENCH_PPG_SPS;
+            if (channels[ch].size() < block)
+            {
+                continue;
+            }
+            for (int decode = 0; decode < 2; decode++)
+            {
+                bench_codec *c = &codec_cases[coder][ch][decode];
+                c->coder = coder;
+                c->signal = &channels[ch];
+                c->block = block;
+                prepare(c);
+                snprintf(c->name, sizeof(c->name), "sample_%s %s/%s", decode ? "decode" : "encode",
+                         coder_name, channel_names[ch]);
+                suite.add("codec", c->name, decode ? bench_decode : bench_encode, c, block, rate);
+                suite.setBytesPerSample((double)c->coded.size() / ((c->offsets.size() - 1) * block));
+            }
+        }
+    }
+    return true;
+}
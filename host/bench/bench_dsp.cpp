@@ -0,0 +1,552 @@
+/***************************************************************
+//   Benchmarks for the per-sample DSP kernels
+//
+//   Inputs are synthetic but shaped like the real signals so that the
+//   data dependent paths (QRS and breath detection, peak finding) do
+//   the same work they do on a patient. Sizes match the firmware:
+//   161 tap FIRs at 125 SPS, a 128 sample decimated PPG window at
+//   25 SPS for estimate_spo2 (or one sample for spo2_stream,
+//   ppg_resp_rate and the sliding DFT bands), and FFTs over that window.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <Arduino.h>
+#include "Bench.h"
+#include "Protocentral_ecg_resp_signal_processing.h"
+#include "myAFE4490_Oximeter.h"
+#include "myoximeter_algorithm.h"
+#include "arduinoFFT.h"
+#include "fir_filter.h"
+#include "fir_kernels.h"
+#include "polyphase_decimator.h"
+#include "sensor_acquisition.h"
+#include "ppg_resp_rate.h"
+#include "spo2_stream.h"
+#include "sliding_dft.h"
+#include "spsc_ring.h"
+
+// Filter tables from Protocentral_ecg_resp_signal_processing.cpp
+extern int16_t CoeffBuf_40Hz_LowPass[FILTERORDER];
+extern int16_t RespCoeffBuf[FILTERORDER];
+
+#define BENCH_ECG_SPS     125.0
+#define BENCH_PPG_SPS     500.0
+#define BENCH_PPG_DEC_SPS 25.0
+#define BENCH_SIGNAL_LEN  4096          // about 33 s at 125 SPS
+#define BENCH_SPO2_WINDOW 128           // aun_ir_buffer length
+
+static int16_t ecg_signal[BENCH_SIGNAL_LEN];
+static int16_t resp_signal[BENCH_SIGNAL_LEN];
+static uint16_t ir_window[BENCH_SPO2_WINDOW];
+static uint16_t red_window[BENCH_SPO2_WINDOW];
+
+static ads1292r_processing ecg_processing;
+
+typedef struct bench_Fir{
+  fir_filter filter;
+  const int16_t *signal;
+}bench_fir;
+
+static bench_fir ecg_fir, resp_fir;
+static bench_fir kernel_fir[FIR_KERNEL_COUNT];
+static char kernel_bench_name[FIR_KERNEL_COUNT][48];
+static spo2_algorithm spo2_bench;
+static afe44xx_internal_data spo2_data;
+static spo2_stream spo2_stream_bench;
+static ppg_resp_rate resp_rate_bench;
+static sliding_dft pulse_spectrum_bench;
+static sliding_dft cic_spectrum_bench;
+
+static void make_signals()
+{
+    for (int n = 0; n < BENCH_SIGNAL_LEN; n++)
+    {
+        double t = n / BENCH_ECG_SPS;
+        // 72 BPM QRS-like spike on a slow baseline, 15 breaths/min
+        double beat = fmod(t * 1.2, 1.0);
+        double qrs = exp(-sq((beat - 0.3) / 0.012));
+        ecg_signal[n] = (int16_t)(4000.0 * qrs + 300.0 * sin(TWO_PI * 0.25 * t));
+        resp_signal[n] = (int16_t)(3000.0 * sin(TWO_PI * 0.25 * t));
+    }
+    for (int n = 0; n < BENCH_SPO2_WINDOW; n++)
+    {
+        double t = n / BENCH_PPG_DEC_SPS;
+        double pulse = exp(-sq((fmod(t * 1.2, 1.0) - 0.25) / 0.08));
+        ir_window[n] = (uint16_t)(3125.0 + 94.0 * pulse);
+        red_window[n] = (uint16_t)(2500.0 + 38.0 * pulse);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ECG and respiration
+
+// The MAC kernels on their own, fed through a working buffer laid out
+// as Filter_CurrentECG_sample keeps it
+static void bench_ecg_filter_process(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    static int16_t working[2 * FILTERORDER];
+    uint16_t start = 0, cur = FILTERORDER - 1;
+    int16_t out = 0;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        int16_t x = ecg_signal[i % BENCH_SIGNAL_LEN];
+        working[cur] = x;
+        ecg_processing.ECG_FilterProcess(&working[cur], CoeffBuf_40Hz_LowPass, &out);
+        working[start] = x;
+        sum += out;
+        cur++;
+        start++;
+        if (start == FILTERORDER - 1)
+        {
+            start = 0;
+            cur = FILTERORDER - 1;
+        }
+    }
+    bench_sink = sum;
+}
+
+static void bench_resp_filter_process(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    static int16_t working[2 * FILTERORDER];
+    uint16_t start = 0, cur = FILTERORDER - 1;
+    int16_t out = 0;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        int16_t x = resp_signal[i % BENCH_SIGNAL_LEN];
+        working[cur] = x;
+        ecg_processing.Resp_FilterProcess(&working[cur], RespCoeffBuf, &out);
+        working[start] = x;
+        sum += out;
+        cur++;
+        start++;
+        if (start == FILTERORDER - 1)
+        {
+            start = 0;
+            cur = FILTERORDER - 1;
+        }
+    }
+    bench_sink = sum;
+}
+
+// Whole per-sample paths including DC removal and buffer upkeep
+static void bench_filter_current_ecg(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    int16_t out = 0;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        int16_t x = ecg_signal[i % BENCH_SIGNAL_LEN];
+        ecg_processing.Filter_CurrentECG_sample(&x, &out);
+        sum += out;
+    }
+    bench_sink = sum;
+}
+
+static void bench_filter_current_resp(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    int16_t out = 0;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        ecg_processing.Filter_CurrentRESP_sample(resp_signal[i % BENCH_SIGNAL_LEN], &out);
+        sum += out;
+    }
+    bench_sink = sum;
+}
+
+// The folded engine alone, one sample per call and in blocks
+static void bench_fir_filter(uint32_t iterations, void *ctx)
+{
+    bench_fir *f = (bench_fir *)ctx;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        sum += f->filter.process(f->signal[i % BENCH_SIGNAL_LEN]);
+    }
+    bench_sink = sum;
+}
+
+static void bench_fir_filter_block(uint32_t iterations, void *ctx)
+{
+    bench_fir *f = (bench_fir *)ctx;
+    static int16_t out[FIR_BLOCK_SIZE];
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        f->filter.process_block(&f->signal[(i * FIR_BLOCK_SIZE) % BENCH_SIGNAL_LEN], out, FIR_BLOCK_SIZE);
+        sum += out[0];
+    }
+    bench_sink = sum;
+}
+
+static void bench_calculate_heart_rate(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    volatile uint8_t heart_rate = 0, peak = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        ecg_processing.Calculate_HeartRate(ecg_signal[i % BENCH_SIGNAL_LEN], &heart_rate, &peak);
+    }
+    bench_sink = heart_rate;
+}
+
+static void bench_respiration_rate(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    volatile uint8_t rate = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        ecg_processing.Respiration_Rate_Detection(resp_signal[i % BENCH_SIGNAL_LEN], &rate);
+    }
+    bench_sink = rate;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Oximeter
+
+// Full rate IR samples in, 25 SPS out
+static void bench_ppg_decimator(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    static polyphase_decimator decimator;
+    if (!decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE))
+    {
+        return;
+    }
+    int32_t out = 0, sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        int32_t x = 100000 + 32 * ir_window[i % BENCH_SPO2_WINDOW];
+        if (decimator.push(x, &out))
+        {
+            sum += out;
+        }
+    }
+    bench_sink = sum;
+}
+
+// Hand-over cost between acquisition and processing, one sample at a
+// time and drained in blocks of 32
+static spsc_ring<ppg_sample, ACQ_PPG_RING_SIZE> ppg_ring;
+
+static void bench_ring_push_pop(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    ppg_sample in, out;
+    memset(&in, 0, sizeof(in));
+    memset(&out, 0, sizeof(out));
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        in.timestamp_us = i;
+        in.ir = ir_window[i % BENCH_SPO2_WINDOW];
+        ppg_ring.push(in);
+        ppg_ring.pop(&out);
+        sum += out.ir;
+    }
+    bench_sink = sum;
+}
+
+static void bench_ring_block(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    ppg_sample in, out[32];
+    memset(&in, 0, sizeof(in));
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        for (uint32_t j = 0; j < 32; j++)
+        {
+            in.ir = ir_window[j];
+            ppg_ring.push(in);
+        }
+        uint32_t n = ppg_ring.pop_block(out, 32);
+        sum += out[n - 1].ir;
+    }
+    bench_sink = sum;
+}
+
+static void bench_estimate_spo2(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        spo2_data.buffer_length = BENCH_SPO2_WINDOW;
+        spo2_bench.estimate_spo2(ir_window, red_window, &spo2_data);
+    }
+    bench_sink = spo2_data.n_spo2;
+}
+
+static void bench_spo2_stream(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint32_t k = i % BENCH_SPO2_WINDOW;
+        sum += spo2_stream_bench.push(ir_window[k], red_window[k]);
+    }
+    bench_sink = sum + spo2_stream_bench.spo2;
+}
+
+// Averaged over the hop - the analysis steps land on 3 samples in 64
+static void bench_ppg_resp_rate(uint32_t iterations, void *ctx)
+{
+    (void)ctx;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint32_t k = i % BENCH_SPO2_WINDOW;
+        sum += resp_rate_bench.push(ir_window[k], 72);
+    }
+    bench_sink = sum + resp_rate_bench.rate;
+}
+
+// The pulse band the firmware keeps over the 25 SPS IR, and a
+// 0.07-1 Hz band of a 125 SPS input decimated by 25 through the CIC
+static void bench_sliding_dft(uint32_t iterations, void *ctx)
+{
+    sliding_dft *s = (sliding_dft *)ctx;
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        sum += s->push(ir_window[i % BENCH_SPO2_WINDOW]);
+    }
+    bench_sink = sum + (int32_t)s->power(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// FFT over the decimated PPG window
+
+typedef struct bench_Fft{
+  uint16_t samples;
+  // Tables for the size, or NULL to work them out on each call
+  const arduinoFFTPlan *plan;
+  double real[512];
+  double imag[512];
+  double input[512];
+}bench_fft;
+
+static bench_fft fft_64, fft_128, fft_256, fft_plan_128, fft_plan_256;
+static arduinoFFTPlanN<128> plan_128(FFT_WIN_TYP_HAMMING);
+static arduinoFFTPlanN<256> plan_256(FFT_WIN_TYP_HAMMING);
+
+static void fft_setup(bench_fft *f, uint16_t samples, const arduinoFFTPlan *plan = NULL)
+{
+    f->samples = samples;
+    f->plan = plan;
+    for (uint16_t n = 0; n < samples; n++)
+    {
+        f->input[n] = ir_window[n % BENCH_SPO2_WINDOW];
+    }
+}
+
+static arduinoFFT fft_make(bench_fft *f)
+{
+    if (f->plan != NULL)
+    {
+        return arduinoFFT(f->real, f->imag, f->plan, BENCH_PPG_DEC_SPS);
+    }
+    return arduinoFFT(f->real, f->imag, f->samples, BENCH_PPG_DEC_SPS);
+}
+
+static void bench_fft_compute(uint32_t iterations, void *ctx)
+{
+    bench_fft *f = (bench_fft *)ctx;
+    arduinoFFT fft = fft_make(f);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, f->samples * sizeof(double));
+        memset(f->imag, 0, f->samples * sizeof(double));
+        fft.Compute(FFT_FORWARD);
+    }
+    bench_sink = (int32_t)f->real[1];
+}
+
+// The same through the half length transform - vImag is not cleared, as
+// the real input never reads it
+static void bench_fft_compute_real(uint32_t iterations, void *ctx)
+{
+    bench_fft *f = (bench_fft *)ctx;
+    arduinoFFT fft = fft_make(f);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, f->samples * sizeof(double));
+        fft.ComputeReal(FFT_FORWARD);
+    }
+    bench_sink = (int32_t)f->real[1];
+}
+
+// Window, transform, magnitude and peak pick - a complete spectral estimate
+static void bench_fft_spectrum(uint32_t iterations, void *ctx)
+{
+    bench_fft *f = (bench_fft *)ctx;
+    arduinoFFT fft = fft_make(f);
+    double peak = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, f->samples * sizeof(double));
+        memset(f->imag, 0, f->samples * sizeof(double));
+        fft.DCRemoval();
+        fft.Windowing(FFT_WIN_TYP_HAMMING, FFT_FORWARD);
+        fft.Compute(FFT_FORWARD);
+        fft.ComplexToMagnitude();
+        peak += fft.MajorPeak();
+    }
+    bench_sink = (int32_t)peak;
+}
+
+static void bench_fft_spectrum_real(uint32_t iterations, void *ctx)
+{
+    bench_fft *f = (bench_fft *)ctx;
+    arduinoFFT fft = fft_make(f);
+    double peak = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, f->samples * sizeof(double));
+        fft.DCRemoval();
+        fft.Windowing(FFT_WIN_TYP_HAMMING, FFT_FORWARD);
+        fft.ComputeReal(FFT_FORWARD);
+        fft.ComplexToMagnitude();
+        peak += fft.MajorPeak();
+    }
+    bench_sink = (int32_t)peak;
+}
+
+// The real spectrum in each sample type, with a plan. The pulse is taken
+// about its mean as a fraction of full scale, as the fixed point types
+// need
+template <typename T>
+struct bench_TypedFft{
+  arduinoFFTPlanN<BENCH_SPO2_WINDOW, T> plan;
+  T real[BENCH_SPO2_WINDOW];
+  T imag[BENCH_SPO2_WINDOW / 2 + 1];
+  T input[BENCH_SPO2_WINDOW];
+  bench_TypedFft() : plan(FFT_WIN_TYP_HAMMING) {}
+};
+
+static bench_TypedFft<double> fft_double;
+static bench_TypedFft<float> fft_float;
+static bench_TypedFft<int16_t> fft_q15;
+static bench_TypedFft<int32_t> fft_q31;
+
+template <typename T>
+static void typed_fft_setup(bench_TypedFft<T> *f)
+{
+    for (uint16_t n = 0; n < BENCH_SPO2_WINDOW; n++)
+    {
+        f->input[n] = arduinoFFTMath<T>::FromDouble((ir_window[n] - 3125.0) / 256.0);
+    }
+}
+
+template <typename T>
+static void bench_fft_compute_real_typed(uint32_t iterations, void *ctx)
+{
+    bench_TypedFft<T> *f = (bench_TypedFft<T> *)ctx;
+    arduinoFFTCore<T> fft(f->real, f->imag, &f->plan, BENCH_PPG_DEC_SPS);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, sizeof(f->real));
+        fft.ComputeReal(FFT_FORWARD);
+    }
+    bench_sink = (int32_t)f->real[1];
+}
+
+template <typename T>
+static void bench_fft_spectrum_typed(uint32_t iterations, void *ctx)
+{
+    bench_TypedFft<T> *f = (bench_TypedFft<T> *)ctx;
+    arduinoFFTCore<T> fft(f->real, f->imag, &f->plan, BENCH_PPG_DEC_SPS);
+    double peak = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(f->real, f->input, sizeof(f->real));
+        fft.Windowing(FFT_WIN_TYP_HAMMING, FFT_FORWARD);
+        fft.ComputeReal(FFT_FORWARD);
+        fft.ComplexToMagnitude();
+        peak += fft.MajorPeak();
+    }
+    bench_sink = (int32_t)peak;
+}
+
+void register_dsp_benchmarks(BenchSuite &suite)
+{
+    make_signals();
+    ecg_fir.filter.init(CoeffBuf_40Hz_LowPass, FILTERORDER);
+    ecg_fir.signal = ecg_signal;
+    resp_fir.filter.init(RespCoeffBuf, FILTERORDER);
+    resp_fir.signal = resp_signal;
+    fft_setup(&fft_64, 64);
+    fft_setup(&fft_128, 128);
+    fft_setup(&fft_256, 256);
+    fft_setup(&fft_plan_128, 128, &plan_128);
+    fft_setup(&fft_plan_256, 256, &plan_256);
+    typed_fft_setup(&fft_double);
+    typed_fft_setup(&fft_float);
+    typed_fft_setup(&fft_q15);
+    typed_fft_setup(&fft_q31);
+    pulse_spectrum_bench.init(BENCH_PPG_DEC_SPS, 1, PULSE_SPECTRUM_LENGTH, PULSE_SPECTRUM_LO_HZ, PULSE_SPECTRUM_HI_HZ);
+    cic_spectrum_bench.init(BENCH_ECG_SPS, 25, 160, 0.07, 1.0);
+
+    suite.add("ecg", "ECG_FilterProcess", bench_ecg_filter_process, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "Resp_FilterProcess", bench_resp_filter_process, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "Filter_CurrentECG_sample", bench_filter_current_ecg, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "Filter_CurrentRESP_sample", bench_filter_current_resp, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "fir_filter::process/ecg", bench_fir_filter, &ecg_fir, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "fir_filter::process_block/ecg", bench_fir_filter_block, &ecg_fir, FIR_BLOCK_SIZE, BENCH_ECG_SPS);
+    suite.add("ecg", "fir_filter::process_block/resp", bench_fir_filter_block, &resp_fir, FIR_BLOCK_SIZE, BENCH_ECG_SPS);
+    // One case per FIR backend this host can run
+    for (uint8_t id = 0; id < FIR_KERNEL_COUNT; id++)
+    {
+        const fir_kernel *k = fir_kernel_get(id);
+        if (k == NULL)
+        {
+            continue;
+        }
+        kernel_fir[id].filter.set_kernel(k);
+        kernel_fir[id].filter.init(CoeffBuf_40Hz_LowPass, FILTERORDER);
+        kernel_fir[id].signal = ecg_signal;
+        snprintf(kernel_bench_name[id], sizeof(kernel_bench_name[id]), "fir_kernel %s/ecg", k->name);
+        suite.add("ecg", kernel_bench_name[id], bench_fir_filter_block, &kernel_fir[id], FIR_BLOCK_SIZE, BENCH_ECG_SPS);
+    }
+    suite.add("ecg", "Calculate_HeartRate", bench_calculate_heart_rate, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ecg", "Respiration_Rate_Detection", bench_respiration_rate, NULL, 1, BENCH_ECG_SPS);
+    suite.add("ppg", "polyphase_decimator/20", bench_ppg_decimator, NULL, 1, BENCH_PPG_SPS);
+    suite.add("ppg", "spsc_ring push+pop", bench_ring_push_pop, NULL, 1, BENCH_PPG_SPS);
+    suite.add("ppg", "spsc_ring push/pop_block/32", bench_ring_block, NULL, 32, BENCH_PPG_SPS);
+    suite.add("ppg", "estimate_spo2/128", bench_estimate_spo2, NULL, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("ppg", "spo2_stream::push", bench_spo2_stream, NULL, 1, BENCH_PPG_DEC_SPS);
+    suite.add("ppg", "ppg_resp_rate::push", bench_ppg_resp_rate, NULL, 1, BENCH_PPG_DEC_SPS);
+    suite.add("ppg", "sliding_dft::push/pulse", bench_sliding_dft, &pulse_spectrum_bench, 1, BENCH_PPG_DEC_SPS);
+    suite.add("ecg", "sliding_dft::push/cic 25", bench_sliding_dft, &cic_spectrum_bench, 1, BENCH_ECG_SPS);
+    suite.add("fft", "arduinoFFT::Compute/64", bench_fft_compute, &fft_64, 64, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::Compute/128", bench_fft_compute, &fft_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::Compute/256", bench_fft_compute, &fft_256, 256, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::ComputeReal/64", bench_fft_compute_real, &fft_64, 64, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::ComputeReal/128", bench_fft_compute_real, &fft_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::ComputeReal/256", bench_fft_compute_real, &fft_256, 256, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT spectrum/128", bench_fft_spectrum, &fft_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT real spectrum/128", bench_fft_spectrum_real, &fft_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::Compute plan/128", bench_fft_compute, &fft_plan_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::Compute plan/256", bench_fft_compute, &fft_plan_256, 256, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::ComputeReal plan/128", bench_fft_compute_real, &fft_plan_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT::ComputeReal plan/256", bench_fft_compute_real, &fft_plan_256, 256, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT spectrum plan/128", bench_fft_spectrum, &fft_plan_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFT real spectrum plan/128", bench_fft_spectrum_real, &fft_plan_128, 128, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTCore<double>::ComputeReal/128", bench_fft_compute_real_typed<double>, &fft_double, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTFloat::ComputeReal/128", bench_fft_compute_real_typed<float>, &fft_float, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTQ15::ComputeReal/128", bench_fft_compute_real_typed<int16_t>, &fft_q15, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTQ31::ComputeReal/128", bench_fft_compute_real_typed<int32_t>, &fft_q31, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTCore<double> real spectrum/128", bench_fft_spectrum_typed<double>, &fft_double, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTFloat real spectrum/128", bench_fft_spectrum_typed<float>, &fft_float, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTQ15 real spectrum/128", bench_fft_spectrum_typed<int16_t>, &fft_q15, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+    suite.add("fft", "arduinoFFTQ31 real spectrum/128", bench_fft_spectrum_typed<int32_t>, &fft_q31, BENCH_SPO2_WINDOW, BENCH_PPG_DEC_SPS);
+}
@@ -0,0 +1,97 @@
+/***************************************************************
+//   healthypi_bench - time the signal chain kernels on the host
+//
+//   usage: healthypi_bench [options]
+//     -o <file>        write JSON results to file (default stdout)
+//     --filter <text>  only run benchmarks whose name contains text
+//     --min-time <s>   minimum time per run, default 0.05
+//     --repeat <n>     runs per benchmark, median reported, default 5
+//     --table          also print a readable table to stderr
+//     --recording <file>  code these samples in the codec benchmarks
+//                      (sample text, see Recording.h) rather than
+//                      synthetic ones
+//
+//   ns_per_sample is the cost per input sample. budget_percent is that
+//   cost as a share of the sample period of the stream the kernel runs
+//   on, i.e. how much of one core the kernel needs at the firmware rate.
+//   The codec benchmarks also give bytes_per_sample, the coded size.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Bench.h"
+
+void register_dsp_benchmarks(BenchSuite &suite);
+bool register_codec_benchmarks(BenchSuite &suite, const char *recording);
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL;
+    const char *filter = NULL;
+    double min_time = 0.05;
+    int repeats = 5;
+    bool table = false;
+    const char *recording = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            out_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            min_time = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeats = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--recording") == 0 && i + 1 < argc)
+        {
+            recording = argv[++i];
+        }
+        else if (strcmp(argv[i], "--table") == 0)
+        {
+            table = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-o results.json] [--filter text] [--min-time s] [--repeat n] [--table] [--recording file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    BenchSuite suite("healthypi_dsp");
+    register_dsp_benchmarks(suite);
+    if (!register_codec_benchmarks(suite, recording))
+    {
+        return 1;
+    }
+    suite.run(filter, min_time, repeats);
+
+    FILE *out = stdout;
+    if (out_path != NULL && (out = fopen(out_path, "w")) == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    suite.writeJson(out);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    if (table)
+    {
+        suite.writeTable(stderr);
+    }
+    return 0;
+}
@@ -0,0 +1,777 @@
+/***************************************************************
+//   healthypi_check - self checks of the signal chain on the host
+//
+//   usage: healthypi_check [--filter <text>]
+//     --filter <text>  only run checks whose name contains text
+//
+//   Each check feeds a kernel synthetic input and compares it with a
+//   plain recomputation of the same quantity. Failures are printed to
+//   stderr; the exit status is 1 if any check failed. ctest runs it.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spo2_stream.h"
+#include "packet_scheduler.h"
+#include "myAFE4490_Oximeter.h"
+#include "fir_kernels.h"
+#include "fir_filter.h"
+#include "polyphase_decimator.h"
+#include "Protocentral_ecg_resp_signal_processing.h"
+#include "arduinoFFT.h"
+#include "sample_codec.h"
+
+// Filter tables from Protocentral_ecg_resp_signal_processing.cpp
+extern int16_t CoeffBuf_40Hz_LowPass[FILTERORDER];
+extern int16_t RespCoeffBuf[FILTERORDER];
+
+typedef struct check_Case{
+  const char *name;
+  // Number of failures
+  int (*run)(void);
+}check_case;
+
+/////////////////////////////////////////////////////////////////////////////////////
+// spo2_stream window minimum and maximum
+
+// IR sample n of a test signal
+typedef uint16_t (*check_signal)(uint32_t n);
+
+static uint16_t falling(uint32_t n) { return (uint16_t)(40000 - 10 * n); }
+static uint16_t rising(uint32_t n) { return (uint16_t)(1000 + 10 * n); }
+// Runs of 200 up then 200 down - longer than the window each way
+static uint16_t zigzag(uint32_t n)
+{
+    uint32_t k = n % 400;
+    return (uint16_t)(k < 200 ? 20000 + 50 * k : 40000 - 50 * (k - 200));
+}
+// Held values, so ties go through the deques too
+static uint16_t steps(uint32_t n) { return (uint16_t)(30000 + 1000 * ((n / 37) % 5)); }
+static uint16_t noise(uint32_t n)
+{
+    uint32_t x = n * 2654435761u;
+    return (uint16_t)(x >> 16);
+}
+
+// sample_max and sample_min after every push against a scan of the last
+// SPO2_STREAM_WINDOW samples
+static int check_extremes(const char *name, check_signal signal, uint32_t samples)
+{
+    static spo2_stream stream;
+    static uint16_t history[4096];
+    int failures = 0;
+    stream.reset();
+    for (uint32_t n = 0; n < samples && n < sizeof(history) / sizeof(history[0]); n++)
+    {
+        history[n] = signal(n);
+        stream.push(history[n], history[n]);
+        uint32_t first = (n + 1 > SPO2_STREAM_WINDOW) ? n + 1 - SPO2_STREAM_WINDOW : 0;
+        uint16_t max = history[first], min = history[first];
+        for (uint32_t k = first; k <= n; k++)
+        {
+            if (history[k] > max)
+            {
+                max = history[k];
+            }
+            if (history[k] < min)
+            {
+                min = history[k];
+            }
+        }
+        if (stream.sample_max != max || stream.sample_min != min)
+        {
+            if (failures < 3)
+            {
+                fprintf(stderr, "  %s sample %u: max %u min %u, window has max %u min %u\n",
+                        name, n, stream.sample_max, stream.sample_min, max, min);
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int check_spo2_stream_extremes(void)
+{
+    return check_extremes("falling", falling, 1000) +
+           check_extremes("rising", rising, 1000) +
+           check_extremes("zigzag", zigzag, 2000) +
+           check_extremes("steps", steps, 2000) +
+           check_extremes("noise", noise, 4000);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// packet_scheduler reserved slots with the port stalled
+
+// 1.5 s of samples in the sketch's batched mode with nothing sent: the
+// batches without vitals must stop short of the reserved slots once the
+// queue fills at about 1 s, the status frame then and the vitals batch
+// for a heart rate change at 1.3 s must still get in, and so must a
+// command ack after them
+static int check_packet_scheduler_reserve(void)
+{
+    static packet_scheduler scheduler;
+    int failures = 0;
+    scheduler.set_mode(STREAM_MODE_BATCHED);
+    vitals_payload vitals;
+    memset(&vitals, 0, sizeof(vitals));
+    status_payload link;
+    memset(&link, 0, sizeof(link));
+    for (uint32_t us = 0; us < 1500000; us += 2000)
+    {
+        scheduler.ppg_sample(100000, 80000);
+        vitals.heart_rate = us < 1300000 ? 72 : 80;
+        if (us % 8000 == 0)
+        {
+            scheduler.ecg_sample(0, 0, 0);
+            scheduler.set_vitals(&vitals);
+            scheduler.set_link_status(&link);
+            scheduler.update(us / 1000, true);
+        }
+    }
+    ack_payload ack;
+    memset(&ack, 0, sizeof(ack));
+    if (!scheduler.queue_ack(&ack))
+    {
+        fprintf(stderr, "  no slot for a command ack with %u frames waiting\n", scheduler.waiting());
+        failures++;
+    }
+    if (scheduler.dropped() == 0)
+    {
+        fprintf(stderr, "  the stalled port dropped no batches\n");
+        failures++;
+    }
+
+    uint32_t plain_batches = 0, vitals_batches = 0, status_frames = 0, acks = 0;
+    int32_t last_sequence = -1;
+    bool gap = false;
+    serial_packet *packet;
+    while ((packet = scheduler.next()) != NULL)
+    {
+        const uint8_t *payload = &packet->bytes[sizeof(frame_header)];
+        switch (packet->header.type)
+        {
+            case CES_CMDIF_TYPE_BATCH:
+            case CES_CMDIF_TYPE_PACKED_BATCH:
+            {
+                int32_t sequence = payload[1] | (payload[2] << 8);
+                gap = gap || (last_sequence >= 0 && sequence != last_sequence + 1);
+                last_sequence = sequence;
+                if (payload[3] & BATCH_FLAG_VITALS)
+                {
+                    vitals_batches++;
+                }
+                else
+                {
+                    plain_batches++;
+                }
+                break;
+            }
+            case CES_CMDIF_TYPE_STATUS:
+                status_frames++;
+                break;
+            case CES_CMDIF_TYPE_ACK:
+                acks++;
+                break;
+        }
+        scheduler.sent();
+    }
+    if (plain_batches > PACKET_QUEUE_SIZE - PACKET_QUEUE_RESERVED)
+    {
+        fprintf(stderr, "  %u batches without vitals took reserved slots\n", plain_batches);
+        failures++;
+    }
+    if (vitals_batches != 3 || status_frames != 1 || acks != 1)
+    {
+        fprintf(stderr, "  queued %u vitals batches, %u status frames, %u acks\n", vitals_batches, status_frames, acks);
+        failures++;
+    }
+    if (!gap)
+    {
+        fprintf(stderr, "  no gap in the batch sequence numbers for the dropped batches\n");
+        failures++;
+    }
+    return failures;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// AFE4490 pulse band fallback with the probe off and on
+
+// One AFE4490 IR/RED pair at 500 SPS, 22 bit codes
+typedef void (*check_ppg)(uint32_t n, int32_t *ir, int32_t *red);
+
+// Ambient cancelled down to a few counts of noise and a faint 1.5 Hz
+// flicker - most of the pulse band's power is in one peak
+static void probe_off(uint32_t n, int32_t *ir, int32_t *red)
+{
+    uint32_t x = n * 2654435761u;
+    int32_t flicker = (int32_t)(8.0 * sin(2.0 * PI * 1.5 * n / 500.0));
+    *ir = 40 + flicker + (int32_t)((x >> 16) % 9) - 4;
+    *red = 30 + flicker + (int32_t)((x >> 24) % 9) - 4;
+}
+
+// A narrow 180 /min pulse, about 0.1% of full scale
+static void fast_pulse(uint32_t n, int32_t *ir, int32_t *red)
+{
+    double phase = fmod(n * 3.0 / 500.0, 1.0) - 0.25;
+    double pulse = exp(-phase * phase / (0.08 * 0.08));
+    *ir = (int32_t)(200000.0 + 2000.0 * pulse);
+    *red = (int32_t)(160000.0 + 800.0 * pulse);
+}
+
+// Runs seconds of signal through process_AFE4490_sample and returns
+// the pulse band rate at the end; failures if it ever stood in for the
+// beat rate when it should not
+static int16_t run_oximeter(check_ppg signal, uint32_t seconds, bool expect_pulse, int *failures)
+{
+    static AFE4490 afe;
+    afe = AFE4490();
+    afe44xx_data data;
+    memset(&data, 0, sizeof(data));
+    for (uint32_t n = 0; n < seconds * 500; n++)
+    {
+        int32_t ir, red;
+        signal(n, &ir, &red);
+        afe.process_AFE4490_sample((uint32_t)ir & 0x3fffff, (uint32_t)red & 0x3fffff, &data);
+        if (!expect_pulse && afe.pulse_rate != 0)
+        {
+            if (*failures < 3)
+            {
+                fprintf(stderr, "  probe off sample %u: pulse band rate %d, heart rate %d published\n",
+                        n, afe.pulse_rate, data.heart_rate);
+            }
+            (*failures)++;
+        }
+    }
+    return afe.pulse_rate;
+}
+
+static int check_afe4490_probe_off(void)
+{
+    int failures = 0;
+    run_oximeter(probe_off, 120, false, &failures);
+    int16_t rate = run_oximeter(fast_pulse, 30, true, &failures);
+    if (abs(rate - 180) > 3)
+    {
+        fprintf(stderr, "  180 /min pulse: pulse band rate %d\n", rate);
+        failures++;
+    }
+    return failures;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// FIR kernels, fir_filter and the polyphase decimator, bit for bit
+
+static uint32_t check_random_state = 1;
+
+// xorshift32, the same sequence every run
+static uint32_t check_random(void)
+{
+    uint32_t x = check_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    check_random_state = x;
+    return x;
+}
+
+// Kinds of Q15 test vector - random over the full range and the extremes
+// that wrap the 32 bit accumulator
+enum
+{
+    VECTOR_RANDOM,
+    VECTOR_MOST_NEGATIVE,
+    VECTOR_MOST_POSITIVE,
+    VECTOR_ALTERNATE,
+    VECTOR_EXTREMES,
+    VECTOR_KINDS
+};
+
+static int16_t vector_value(int kind, uint16_t k)
+{
+    switch (kind)
+    {
+        case VECTOR_MOST_NEGATIVE:
+            return -32768;
+        case VECTOR_MOST_POSITIVE:
+            return 32767;
+        case VECTOR_ALTERNATE:
+            return (k & 1) ? 32767 : -32768;
+        case VECTOR_EXTREMES:
+        {
+            static const int16_t values[] = { -32768, -32767, -1, 0, 1, 32767 };
+            return values[check_random() % 6];
+        }
+        default:
+            return (int16_t)check_random();
+    }
+}
+
+// The dot product with a 32 bit accumulator that wraps, as the kernels
+// document, then ECG_FilterProcess's saturation
+static int16_t fir_plain(const int16_t *x, const int16_t *h, uint16_t taps)
+{
+    uint32_t acc = 0;
+    for (uint16_t k = 0; k < taps; k++)
+    {
+        acc += (uint32_t)((int32_t)h[k] * (int32_t)x[k]);
+    }
+    return fir_q30_to_q15((int32_t)acc);
+}
+
+// Every backend built here, dot on any table and folded on symmetric
+// ones, for every length up to FIR_MAX_TAPS
+static int check_fir_kernels(void)
+{
+    static int16_t x[FIR_MAX_TAPS], h[FIR_MAX_TAPS], symmetric[FIR_MAX_TAPS];
+    int failures = 0;
+    check_random_state = 1;
+    for (uint8_t id = 0; id < FIR_KERNEL_COUNT; id++)
+    {
+        const fir_kernel *kernel = fir_kernel_get(id);
+        if (kernel == NULL)
+        {
+            continue;
+        }
+        for (uint16_t taps = 1; taps <= FIR_MAX_TAPS; taps++)
+        {
+            for (int x_kind = 0; x_kind < VECTOR_KINDS; x_kind++)
+            {
+                for (int h_kind = 0; h_kind < VECTOR_KINDS; h_kind++)
+                {
+                    for (uint16_t k = 0; k < taps; k++)
+                    {
+                        x[k] = vector_value(x_kind, k);
+                        h[k] = vector_value(h_kind, k);
+                    }
+                    for (uint16_t k = 0; k < taps; k++)
+                    {
+                        symmetric[k] = h[k < taps - 1 - k ? k : taps - 1 - k];
+                    }
+                    int16_t want_dot = fir_plain(x, h, taps);
+                    int16_t want_folded = fir_plain(x, symmetric, taps);
+                    int16_t dot = kernel->dot(x, h, taps);
+                    int16_t folded = kernel->folded(x, symmetric, taps);
+                    if (dot != want_dot || folded != want_folded)
+                    {
+                        if (failures < 3)
+                        {
+                            fprintf(stderr, "  %s %u taps, vectors %d/%d: dot %d folded %d, want %d and %d\n",
+                                    kernel->name, taps, x_kind, h_kind, dot, folded, want_dot, want_folded);
+                        }
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// fir_filter on each backend, a sample and a block at a time, against
+// ECG_FilterProcess over a running window - with the ECG table, the
+// respiration table and, for the unfolded path, the ECG table made
+// lopsided. Inputs stay within half scale, where ECG_FilterProcess's
+// signed accumulator cannot overflow with these tables
+#define CHECK_FIR_SAMPLES 2000
+
+static int check_fir_filter(void)
+{
+    static int16_t lopsided[FILTERORDER];
+    static int16_t window[FILTERORDER - 1 + CHECK_FIR_SAMPLES];
+    static int16_t want[CHECK_FIR_SAMPLES], got[CHECK_FIR_SAMPLES];
+    static ads1292r_processing processing;
+    static fir_filter filter;
+    int16_t *const tables[] = { CoeffBuf_40Hz_LowPass, RespCoeffBuf, lopsided };
+    const char *const table_names[] = { "ecg", "resp", "lopsided" };
+    int failures = 0;
+
+    memcpy(lopsided, CoeffBuf_40Hz_LowPass, sizeof(lopsided));
+    lopsided[0] += 7;
+    check_random_state = 2;
+    memset(window, 0, sizeof(window));
+    int16_t *samples = &window[FILTERORDER - 1];
+    for (int n = 0; n < CHECK_FIR_SAMPLES; n++)
+    {
+        samples[n] = (int16_t)check_random() >> 1;
+    }
+
+    for (int t = 0; t < 3; t++)
+    {
+        for (int n = 0; n < CHECK_FIR_SAMPLES; n++)
+        {
+            processing.ECG_FilterProcess(&samples[n], tables[t], &want[n]);
+        }
+        for (uint8_t id = 0; id < FIR_KERNEL_COUNT; id++)
+        {
+            const fir_kernel *kernel = fir_kernel_get(id);
+            if (kernel == NULL)
+            {
+                continue;
+            }
+            filter.set_kernel(kernel);
+            filter.init(tables[t], FILTERORDER);
+            if (filter.is_symmetric() != (t != 2))
+            {
+                fprintf(stderr, "  %s table taken as %ssymmetric\n", table_names[t], filter.is_symmetric() ? "" : "not ");
+                failures++;
+            }
+            for (int n = 0; n < CHECK_FIR_SAMPLES; n++)
+            {
+                got[n] = filter.process(samples[n]);
+            }
+            // And in uneven blocks, to cross the history shifts
+            filter.reset();
+            static int16_t blocked[CHECK_FIR_SAMPLES];
+            for (int n = 0, size = 1; n < CHECK_FIR_SAMPLES; n += size, size = size % 45 + 1)
+            {
+                int count = (n + size > CHECK_FIR_SAMPLES) ? CHECK_FIR_SAMPLES - n : size;
+                filter.process_block(&samples[n], &blocked[n], count);
+            }
+            for (int n = 0; n < CHECK_FIR_SAMPLES; n++)
+            {
+                if (got[n] != want[n] || blocked[n] != want[n])
+                {
+                    if (failures < 3)
+                    {
+                        fprintf(stderr, "  %s %s sample %d: process %d, process_block %d, ECG_FilterProcess %d\n",
+                                kernel->name, table_names[t], n, got[n], blocked[n], want[n]);
+                    }
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// polyphase_decimator against the filter worked out in full at each
+// output, the input before the first sample held at its value as the
+// decimator seeds it - random 22 bit codes, then the extremes
+#define CHECK_DECIMATOR_SAMPLES 20000
+
+static int check_polyphase_decimator(void)
+{
+    static int32_t input[PPG_DECIMATOR_TAPS + CHECK_DECIMATOR_SAMPLES];
+    static polyphase_decimator decimator;
+    int failures = 0;
+    check_random_state = 3;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int32_t *x = &input[PPG_DECIMATOR_TAPS];
+        for (int n = 0; n < CHECK_DECIMATOR_SAMPLES; n++)
+        {
+            int32_t code = (int32_t)(check_random() << 10) >> 10;
+            x[n] = (pass == 0) ? code : ((code & 1) ? 0x1fffff : -0x200000);
+        }
+        for (int n = 1; n <= PPG_DECIMATOR_TAPS; n++)
+        {
+            x[-n] = x[0];
+        }
+        decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE);
+        int outputs = 0;
+        for (int n = 0; n < CHECK_DECIMATOR_SAMPLES; n++)
+        {
+            int32_t out;
+            bool ready = decimator.push(x[n], &out);
+            if (ready != ((n + 1) % DECIMATE == 0))
+            {
+                fprintf(stderr, "  output at input %d out of step\n", n);
+                return failures + 1;
+            }
+            if (!ready)
+            {
+                continue;
+            }
+            int64_t acc = 0;
+            for (int j = 0; j < PPG_DECIMATOR_TAPS; j++)
+            {
+                acc += (int64_t)PPG_DecimatorCoeffs[j] * x[n - j];
+            }
+            int32_t want = (int32_t)(acc >> 15);
+            if (out != want)
+            {
+                if (failures < 3)
+                {
+                    fprintf(stderr, "  %s input %d: decimator %d, convolution %d\n",
+                            pass ? "extremes" : "random", n, out, want);
+                }
+                failures++;
+            }
+            outputs++;
+        }
+        if (outputs != CHECK_DECIMATOR_SAMPLES / DECIMATE)
+        {
+            fprintf(stderr, "  %d outputs from %d inputs\n", outputs, CHECK_DECIMATOR_SAMPLES);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// arduinoFFT ComputeReal against Compute and a direct DFT
+
+#define CHECK_FFT_MAX 256
+
+// Errors of one transform against the direct DFT, in fractions of full
+// scale: the largest and the signal to noise ratio
+typedef struct fft_Error{
+  double max;
+  double snr_db;
+}fft_error;
+
+static void fft_compare(const double *got_re, const double *got_im, const double *want_re,
+                        const double *want_im, uint16_t count, fft_error *error)
+{
+    double signal = 0, noise = 0;
+    error->max = 0;
+    for (uint16_t k = 0; k < count; k++)
+    {
+        double dr = got_re[k] - want_re[k];
+        double di = (got_im != NULL) ? got_im[k] - want_im[k] : 0;
+        double e = sqrt(dr * dr + di * di);
+        if (e > error->max)
+        {
+            error->max = e;
+        }
+        signal += want_re[k] * want_re[k] + ((want_im != NULL) ? want_im[k] * want_im[k] : 0);
+        noise += e * e;
+    }
+    error->snr_db = (noise > 0) ? 10.0 * log10(signal / noise) : 400.0;
+}
+
+// Transform results as fractions of full scale, times 2^BlockExponent()
+template <typename T>
+static void fft_values(const T *v, uint16_t count, int8_t exponent, double *out)
+{
+    double full = 2.0 * arduinoFFTMath<T>::ToDouble(arduinoFFTMath<T>::FromDouble(0.5));
+    for (uint16_t k = 0; k < count; k++)
+    {
+        out[k] = ldexp(arduinoFFTMath<T>::ToDouble(v[k]) / full, exponent);
+    }
+}
+
+// One size, with or without a plan: ComputeReal forward against Compute
+// forward and against the direct DFT over bins 0 to samples/2, then
+// ComputeReal reverse against the input. Floating point is held to
+// max_error, fixed point to min_snr_db
+template <typename T>
+static int check_fft_size(const char *type, uint16_t samples, const arduinoFFTPlanCore<T> *plan,
+                          double max_error, double min_snr_db)
+{
+    static double x[CHECK_FFT_MAX], want_re[CHECK_FFT_MAX], want_im[CHECK_FFT_MAX];
+    static double real_re[CHECK_FFT_MAX], real_im[CHECK_FFT_MAX];
+    static double complex_re[CHECK_FFT_MAX], complex_im[CHECK_FFT_MAX], back[CHECK_FFT_MAX];
+    static T re[CHECK_FFT_MAX], im[CHECK_FFT_MAX];
+    int failures = 0;
+    uint16_t bins = samples / 2 + 1;
+
+    // Up to half scale, so the fixed point input is exact at its precision
+    for (uint16_t n = 0; n < samples; n++)
+    {
+        T v = arduinoFFTMath<T>::FromDouble((int32_t)check_random() / 4294967296.0);
+        fft_values(&v, 1, 0, &x[n]);
+    }
+    for (uint16_t k = 0; k < bins; k++)
+    {
+        double sr = 0, si = 0;
+        for (uint16_t n = 0; n < samples; n++)
+        {
+            double phase = 2.0 * M_PI * (double)((uint32_t)k * n % samples) / samples;
+            sr += x[n] * cos(phase);
+            si -= x[n] * sin(phase);
+        }
+        want_re[k] = sr;
+        want_im[k] = si;
+    }
+
+    arduinoFFTCore<T> fft = plan ? arduinoFFTCore<T>(re, im, plan, 100.0) : arduinoFFTCore<T>(re, im, samples, 100.0);
+    for (uint16_t n = 0; n < samples; n++)
+    {
+        re[n] = arduinoFFTMath<T>::FromDouble(x[n]);
+        im[n] = 0;
+    }
+    fft.Compute(FFT_FORWARD);
+    fft_values(re, bins, fft.BlockExponent(), complex_re);
+    fft_values(im, bins, fft.BlockExponent(), complex_im);
+
+    for (uint16_t n = 0; n < samples; n++)
+    {
+        re[n] = arduinoFFTMath<T>::FromDouble(x[n]);
+        im[n] = 0;
+    }
+    fft.ComputeReal(FFT_FORWARD);
+    fft_values(re, bins, fft.BlockExponent(), real_re);
+    fft_values(im, bins, fft.BlockExponent(), real_im);
+    fft.ComputeReal(FFT_REVERSE);
+    fft_values(re, samples, fft.BlockExponent(), back);
+
+    fft_error vs_complex, vs_dft, complex_vs_dft, round_trip;
+    fft_compare(real_re, real_im, complex_re, complex_im, bins, &vs_complex);
+    fft_compare(real_re, real_im, want_re, want_im, bins, &vs_dft);
+    fft_compare(complex_re, complex_im, want_re, want_im, bins, &complex_vs_dft);
+    fft_compare(back, NULL, x, NULL, samples, &round_trip);
+    bool fixed = arduinoFFTMath<T>::fixedPoint;
+    bool ok = fixed ? (vs_dft.snr_db >= min_snr_db && complex_vs_dft.snr_db >= min_snr_db
+                       && round_trip.snr_db >= min_snr_db)
+                    : (vs_complex.max <= max_error && vs_dft.max <= max_error && round_trip.max <= max_error);
+    if (!ok)
+    {
+        fprintf(stderr, "  %s %u%s: ComputeReal against Compute %.3g, against the DFT %.3g (%.1f dB), "
+                "Compute %.3g (%.1f dB), round trip %.3g (%.1f dB)\n",
+                type, samples, plan ? " planned" : "", vs_complex.max, vs_dft.max, vs_dft.snr_db,
+                complex_vs_dft.max, complex_vs_dft.snr_db, round_trip.max, round_trip.snr_db);
+        failures++;
+    }
+    return failures;
+}
+
+template <typename T>
+static int check_fft_type(const char *type, double max_error, double min_snr_db)
+{
+    static arduinoFFTPlanN<128, T> plan128;
+    static arduinoFFTPlanN<256, T> plan256;
+    return check_fft_size<T>(type, 128, NULL, max_error, min_snr_db) +
+           check_fft_size<T>(type, 128, &plan128, max_error, min_snr_db) +
+           check_fft_size<T>(type, 256, NULL, max_error, min_snr_db) +
+           check_fft_size<T>(type, 256, &plan256, max_error, min_snr_db);
+}
+
+// Measured on random half scale input, bins up to about 10: double
+// within 2e-13 of each other and the DFT, float 2e-6, Q15 59-67 dB and
+// Q31 156-162 dB signal to noise
+static int check_fft_real(void)
+{
+    check_random_state = 4;
+    return check_fft_type<double>("double", 1e-12, 0) +
+           check_fft_type<float>("float", 1e-5, 0) +
+           check_fft_type<int16_t>("Q15", 0, 55) +
+           check_fft_type<int32_t>("Q31", 0, 150);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// sample_codec round trip
+
+#define CHECK_CODEC_BLOCK 64
+
+enum
+{
+    BLOCK_RANDOM,
+    BLOCK_SMALL_STEPS,
+    BLOCK_PPG,
+    BLOCK_ALTERNATE,
+    BLOCK_EXTREMES,
+    BLOCK_KINDS
+};
+
+static int32_t block_value(int kind, uint16_t i, int32_t previous)
+{
+    switch (kind)
+    {
+        case BLOCK_SMALL_STEPS:
+            return (int32_t)((uint32_t)previous + (check_random() % 65) - 32);
+        case BLOCK_PPG:
+            return (int32_t)(check_random() << 10) >> 10;
+        case BLOCK_ALTERNATE:
+            return (i & 1) ? INT32_MAX : INT32_MIN;
+        case BLOCK_EXTREMES:
+        {
+            static const int32_t values[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX };
+            return values[check_random() % 7];
+        }
+        default:
+            return (int32_t)check_random();
+    }
+}
+
+// Every coder and block length up to CHECK_CODEC_BLOCK, over random and
+// full range int32 samples - the differences of the extremes wrap
+static int check_sample_codec(void)
+{
+    static int32_t samples[CHECK_CODEC_BLOCK], decoded[CHECK_CODEC_BLOCK];
+    // An escaped Rice value is 16 + 32 bits, a varint at most 5 bytes
+    static uint8_t coded[CHECK_CODEC_BLOCK * 6 + 8];
+    int failures = 0;
+    check_random_state = 5;
+    for (uint8_t coder = 0; coder < SAMPLE_CODER_COUNT; coder++)
+    {
+        for (uint16_t n = 1; n <= CHECK_CODEC_BLOCK; n++)
+        {
+            for (int kind = 0; kind < BLOCK_KINDS; kind++)
+            {
+                int32_t previous = (int32_t)check_random();
+                for (uint16_t i = 0; i < n; i++)
+                {
+                    samples[i] = previous = block_value(kind, i, previous);
+                }
+                size_t bytes = sample_encode(coder, samples, n, coded, sizeof(coded));
+                memset(decoded, 0, sizeof(decoded));
+                size_t used = (bytes > 0) ? sample_decode(coder, coded, bytes, decoded, n) : 0;
+                if (bytes == 0 || used != bytes || memcmp(samples, decoded, n * sizeof(int32_t)) != 0)
+                {
+                    if (failures < 3)
+                    {
+                        fprintf(stderr, "  coder %u, %u samples of kind %d: coded %u bytes, decoded %u\n",
+                                coder, n, kind, (unsigned)bytes, (unsigned)used);
+                    }
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+static const check_case checks[] = {
+    { "spo2_stream extremes", check_spo2_stream_extremes },
+    { "packet_scheduler reserve", check_packet_scheduler_reserve },
+    { "AFE4490 probe off", check_afe4490_probe_off },
+    { "fir_kernels bit exact", check_fir_kernels },
+    { "fir_filter bit exact", check_fir_filter },
+    { "polyphase_decimator bit exact", check_polyphase_decimator },
+    { "arduinoFFT ComputeReal", check_fft_real },
+    { "sample_codec round trip", check_sample_codec },
+};
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--filter text]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++)
+    {
+        if (filter != NULL && strstr(checks[i].name, filter) == NULL)
+        {
+            continue;
+        }
+        int failures = checks[i].run();
+        fprintf(stderr, "%-32s %s", checks[i].name, failures ? "FAILED" : "ok");
+        if (failures)
+        {
+            fprintf(stderr, " (%d)", failures);
+            failed++;
+        }
+        fprintf(stderr, "\n");
+    }
+    return failed ? 1 : 0;
+}
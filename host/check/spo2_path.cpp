@@ -0,0 +1,76 @@
+/***************************************************************
+//   One build of the SpO2 code behind a common face
+//
+//   SPO2_PATH_FACTORY and SPO2_PATH_NAME are set by CMakeLists.txt for
+//   each of the two builds. See spo2_path.h
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "spo2_path.h"
+#include "myAFE4490_Oximeter.h"
+#include "myoximeter_algorithm.h"
+#include "spo2_stream.h"
+
+namespace {
+
+class spo2_path_build : public spo2_path
+{
+  public:
+    spo2_path_build() : count(0)
+    {
+      internal_data.n_spo2 = 0;
+      internal_data.n_heart_rate = 0;
+      internal_data.n_resp_rate = 0;
+      internal_data.buffer_length = SPO2_STREAM_WINDOW;
+    }
+
+    const char *name() const { return SPO2_PATH_NAME; }
+
+    void push(uint16_t ir, uint16_t red,
+              bool *stream_ready, spo2_path_estimate *stream,
+              bool *batch_ready, spo2_path_estimate *batch)
+    {
+      *stream_ready = beat_estimator.push(ir, red);
+      if (*stream_ready)
+      {
+        stream->spo2 = beat_estimator.spo2;
+        stream->heart_rate = beat_estimator.heart_rate;
+        stream->spo2_valid = beat_estimator.spo2_valid;
+        stream->hr_valid = beat_estimator.hr_valid;
+      }
+
+      // A 5 s buffer at a time, as with SPO2_STREAMING 0
+      ir_buffer[count] = ir;
+      red_buffer[count] = red;
+      *batch_ready = false;
+      if (++count == SPO2_STREAM_WINDOW)
+      {
+        count = 0;
+        internal_data.spO2_calc_done = false;
+        algorithm.estimate_spo2(ir_buffer, red_buffer, &internal_data);
+        *batch_ready = internal_data.spO2_calc_done;
+        batch->spo2 = internal_data.n_spo2;
+        batch->heart_rate = internal_data.n_heart_rate;
+        batch->spo2_valid = internal_data.ch_spo2_valid;
+        batch->hr_valid = internal_data.ch_hr_valid;
+      }
+    }
+
+  private:
+    spo2_stream beat_estimator;
+    spo2_algorithm algorithm;
+    afe44xx_internal_data internal_data;
+    uint16_t ir_buffer[SPO2_STREAM_WINDOW];
+    uint16_t red_buffer[SPO2_STREAM_WINDOW];
+    int count;
+};
+
+}
+
+spo2_path *SPO2_PATH_FACTORY()
+{
+  static spo2_path_build path;
+  return &path;
+}
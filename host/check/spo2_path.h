@@ -0,0 +1,43 @@
+/***************************************************************
+//   One build of the SpO2 code behind a common face
+//
+//   spo2_path.cpp is compiled twice: once against the firmware build
+//   (R in Q15), and once with SPO2_FIXED_POINT 0 and spo2_algorithm and
+//   spo2_stream renamed (CMakeLists.txt), so both can run side by side
+//   on the same decimated samples in healthypi_spo2_paths.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef spo2_path_h
+#define spo2_path_h
+
+#include <stdint.h>
+
+typedef struct spo2_path_Estimate{
+  int16_t spo2;
+  int16_t heart_rate;
+  bool spo2_valid;
+  bool hr_valid;
+}spo2_path_estimate;
+
+class spo2_path
+{
+  public:
+    virtual ~spo2_path() {}
+    // Name of the build - "q15" or "float"
+    virtual const char *name() const = 0;
+    // One decimated IR/RED pair, as AFE4490::process_AFE4490_sample
+    // hands them on. true in *stream_ready when spo2_stream published,
+    // and in *batch_ready when a full buffer went through estimate_spo2
+    virtual void push(uint16_t ir, uint16_t red,
+                      bool *stream_ready, spo2_path_estimate *stream,
+                      bool *batch_ready, spo2_path_estimate *batch) = 0;
+};
+
+// The firmware's build, and the float one
+spo2_path *spo2_path_q15();
+spo2_path *spo2_path_float();
+
+#endif
@@ -0,0 +1,174 @@
+/***************************************************************
+//   healthypi_spo2_paths - the fixed point and float SpO2 code side by
+//   side on a recording
+//
+//   usage: healthypi_spo2_paths [--capture] [-v] <recording>
+//     --capture        recording is a raw serial packet capture
+//                      (default: sample text, see Recording.h)
+//     -v               print every estimate where the two differ
+//
+//   The AFE4490 samples are decimated to 25 SPS as the firmware does and
+//   handed to both builds of spo2_stream and estimate_spo2 (spo2_path.h):
+//   the firmware's, with R in Q15, and one with SPO2_FIXED_POINT 0. For
+//   the streaming and batch estimates it reports how many there were, how
+//   many differ in SpO2, heart rate or validity, and the largest SpO2 and
+//   heart rate differences. Exits 1 if any estimate differs.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Recording.h"
+#include "spo2_path.h"
+#include "myAFE4490_Oximeter.h"
+#include "polyphase_decimator.h"
+
+typedef struct paths_Tally{
+  const char *name;
+  unsigned long estimates;
+  unsigned long spo2_differ;
+  unsigned long hr_differ;
+  unsigned long valid_differ;
+  int max_spo2_diff;
+  int max_hr_diff;
+}paths_tally;
+
+static void compare(paths_tally *tally, unsigned long sample, const spo2_path_estimate *q15,
+                    const spo2_path_estimate *fl, bool verbose)
+{
+    tally->estimates++;
+    int spo2_diff = abs(q15->spo2 - fl->spo2);
+    int hr_diff = abs(q15->heart_rate - fl->heart_rate);
+    if (spo2_diff)
+    {
+        tally->spo2_differ++;
+    }
+    if (hr_diff)
+    {
+        tally->hr_differ++;
+    }
+    if (q15->spo2_valid != fl->spo2_valid || q15->hr_valid != fl->hr_valid)
+    {
+        tally->valid_differ++;
+    }
+    if (spo2_diff > tally->max_spo2_diff)
+    {
+        tally->max_spo2_diff = spo2_diff;
+    }
+    if (hr_diff > tally->max_hr_diff)
+    {
+        tally->max_hr_diff = hr_diff;
+    }
+    if (verbose && (spo2_diff || hr_diff || q15->spo2_valid != fl->spo2_valid || q15->hr_valid != fl->hr_valid))
+    {
+        fprintf(stderr, "%s at 25 SPS sample %lu: q15 spo2 %d%s hr %d%s, float spo2 %d%s hr %d%s\n",
+                tally->name, sample,
+                q15->spo2, q15->spo2_valid ? "" : "(invalid)", q15->heart_rate, q15->hr_valid ? "" : "(invalid)",
+                fl->spo2, fl->spo2_valid ? "" : "(invalid)", fl->heart_rate, fl->hr_valid ? "" : "(invalid)");
+    }
+}
+
+static void report(const paths_tally *tally)
+{
+    printf("%-9s estimates %lu, SpO2 differs in %lu (largest %d), heart rate in %lu (largest %d), validity in %lu\n",
+           tally->name, tally->estimates, tally->spo2_differ, tally->max_spo2_diff,
+           tally->hr_differ, tally->max_hr_diff, tally->valid_differ);
+}
+
+int main(int argc, char **argv)
+{
+    const char *input = NULL;
+    bool capture = false;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--capture") == 0)
+        {
+            capture = true;
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else if (argv[i][0] != '-' && input == NULL)
+        {
+            input = argv[i];
+        }
+        else
+        {
+            input = NULL;
+            break;
+        }
+    }
+    if (input == NULL)
+    {
+        fprintf(stderr, "usage: %s [--capture] [-v] <recording>\n", argv[0]);
+        return 2;
+    }
+
+    Recording recording;
+    if (!recording.open(input, capture))
+    {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], input);
+        return 1;
+    }
+
+    polyphase_decimator ir_decimator, red_decimator;
+    ir_decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE);
+    red_decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE);
+    spo2_path *q15 = spo2_path_q15();
+    spo2_path *fl = spo2_path_float();
+    paths_tally stream_tally = { "streaming", 0, 0, 0, 0, 0, 0 };
+    paths_tally batch_tally = { "batch", 0, 0, 0, 0, 0, 0 };
+    unsigned long decimated = 0;
+
+    replay_event event;
+    while (recording.next(&event))
+    {
+        if (event.type != REPLAY_EVENT_PPG)
+        {
+            continue;
+        }
+        // As AFE4490::process_AFE4490_sample - 22 bit codes, filtered
+        // down to 25 SPS and truncated to 16 bits
+        int32_t ir_raw = (int32_t)((uint32_t)event.v1 << 10) >> 10;
+        int32_t red_raw = (int32_t)((uint32_t)event.v2 << 10) >> 10;
+        int32_t ir, red;
+        bool ir_ready = ir_decimator.push(ir_raw, &ir);
+        bool red_ready = red_decimator.push(red_raw, &red);
+        if (!ir_ready || !red_ready)
+        {
+            continue;
+        }
+        bool q15_stream_ready, q15_batch_ready, fl_stream_ready, fl_batch_ready;
+        spo2_path_estimate q15_stream, q15_batch, fl_stream, fl_batch;
+        q15->push((uint16_t)(ir >> 5), (uint16_t)(red >> 5), &q15_stream_ready, &q15_stream, &q15_batch_ready, &q15_batch);
+        fl->push((uint16_t)(ir >> 5), (uint16_t)(red >> 5), &fl_stream_ready, &fl_stream, &fl_batch_ready, &fl_batch);
+        // Beats come from the IR alone, so both builds publish together
+        if (q15_stream_ready != fl_stream_ready)
+        {
+            fprintf(stderr, "%s: streaming estimates out of step at sample %lu\n", argv[0], decimated);
+            return 1;
+        }
+        if (q15_stream_ready)
+        {
+            compare(&stream_tally, decimated, &q15_stream, &fl_stream, verbose);
+        }
+        if (q15_batch_ready && fl_batch_ready)
+        {
+            compare(&batch_tally, decimated, &q15_batch, &fl_batch, verbose);
+        }
+        decimated++;
+    }
+
+    printf("%s: %lu samples at 25 SPS (%.1f min), %s against %s\n", input, decimated,
+           decimated / 25.0 / 60.0, q15->name(), fl->name());
+    report(&stream_tally);
+    report(&batch_tally);
+    bool differ = stream_tally.spo2_differ || stream_tally.hr_differ || stream_tally.valid_differ ||
+                  batch_tally.spo2_differ || batch_tally.hr_differ || batch_tally.valid_differ;
+    return differ ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/***************************************************************
+//   Decoded frames as columns
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "FrameColumns.h"
+#include <string.h>
+
+static const char *const ecg_columns[] = {"ecg", "resp", "status"};
+static const char *const ppg_columns[] = {"ir", "red"};
+static const char *const vitals_columns[] = {"ecg_row", "temperature", "resp_rate", "spo2", "heart_rate",
+                                             "status"};
+static const char *const link_columns[] = {"ecg_row", "baud", "bytes_sent", "frames_sent", "frames_dropped",
+                                           "tx_full", "queue_peak", "queue_size", "ecg_decimation",
+                                           "ppg_decimation"};
+
+#define COLUMNS(c) c, (int)(sizeof(c) / sizeof(c[0]))
+
+ColumnTable::ColumnTable(const char *name, const char *const *columns, int width)
+    : total(0), _name(name), _columns(columns), _width(width)
+{
+}
+
+void ColumnTable::clear()
+{
+    for (int c = 0; c < _width; c++)
+    {
+        _data[c].clear();
+    }
+}
+
+FrameColumns::FrameColumns()
+    : bad_frames(0),
+      _ecg("ecg", COLUMNS(ecg_columns)),
+      _ppg("ppg", COLUMNS(ppg_columns)),
+      _vitals("vitals", COLUMNS(vitals_columns)),
+      _link("link", COLUMNS(link_columns)),
+      _have_last(false)
+{
+    _tables[FRAME_TABLE_ECG] = &_ecg;
+    _tables[FRAME_TABLE_PPG] = &_ppg;
+    _tables[FRAME_TABLE_VITALS] = &_vitals;
+    _tables[FRAME_TABLE_LINK] = &_link;
+    memset(&_last, 0, sizeof(_last));
+}
+
+size_t FrameColumns::pending() const
+{
+    size_t most = 0;
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        if (_tables[t]->rows() > most)
+        {
+            most = _tables[t]->rows();
+        }
+    }
+    return most;
+}
+
+void FrameColumns::ecgRow(int16_t ecg, int16_t resp, uint8_t status)
+{
+    _ecg.push(0, ecg);
+    _ecg.push(1, resp);
+    _ecg.push(2, status);
+    _ecg.total++;
+}
+
+void FrameColumns::ppgRow(int32_t ir, int32_t red)
+{
+    _ppg.push(0, ir);
+    _ppg.push(1, red);
+    _ppg.total++;
+}
+
+void FrameColumns::vitalsRow(const healthypi_vitals *v)
+{
+    _vitals.push(0, (int32_t)_ecg.total);
+    _vitals.push(1, v->temperature);
+    _vitals.push(2, v->resp_rate);
+    _vitals.push(3, v->spo2);
+    _vitals.push(4, v->heart_rate);
+    _vitals.push(5, v->status);
+    _vitals.total++;
+}
+
+bool FrameColumns::add(const frame_view *f)
+{
+    healthypi_vitals v;
+    switch (f->type)
+    {
+    case PACKET_TYPE_DATA:
+    {
+        if (!frame_vitals(f, &v))
+        {
+            break;
+        }
+        bool rows = false;
+        if (!_have_last || v.ecg != _last.ecg || v.resp != _last.resp)
+        {
+            ecgRow(v.ecg, v.resp, v.status);
+            rows = true;
+        }
+        if (!_have_last || v.ir != _last.ir || v.red != _last.red)
+        {
+            ppgRow(v.ir, v.red);
+            rows = true;
+        }
+        if (!_have_last || v.temperature != _last.temperature || v.resp_rate != _last.resp_rate
+            || v.spo2 != _last.spo2 || v.heart_rate != _last.heart_rate || v.status != _last.status)
+        {
+            vitalsRow(&v);
+            rows = true;
+        }
+        _last = v;
+        _have_last = true;
+        return rows;
+    }
+
+    case PACKET_TYPE_ECG:
+    {
+        healthypi_ecg e;
+        if (!frame_ecg(f, &e))
+        {
+            break;
+        }
+        ecgRow(e.ecg, e.resp, e.status);
+        return true;
+    }
+
+    case PACKET_TYPE_PPG:
+    {
+        healthypi_ppg p;
+        if (!frame_ppg(f, &p))
+        {
+            break;
+        }
+        ppgRow(p.ir, p.red);
+        return true;
+    }
+
+    case PACKET_TYPE_VITALS:
+        if (!frame_vitals(f, &v))
+        {
+            break;
+        }
+        vitalsRow(&v);
+        return true;
+
+    case PACKET_TYPE_BATCH:
+    case PACKET_TYPE_PACKED_BATCH:
+        if (!frame_batch(f, &_batch))
+        {
+            break;
+        }
+        for (int i = 0; i < _batch.ecg_count; i++)
+        {
+            ecgRow(_batch.ecg[i].ecg, _batch.ecg[i].resp, _batch.ecg[i].status);
+        }
+        for (int i = 0; i < _batch.ppg_count; i++)
+        {
+            ppgRow(_batch.ppg[i].ir, _batch.ppg[i].red);
+        }
+        // The vitals ride on the batch that ends the ECG they were
+        // worked out from
+        if (frame_vitals(f, &v))
+        {
+            vitalsRow(&v);
+        }
+        return true;
+
+    case PACKET_TYPE_STATUS:
+    {
+        healthypi_status s;
+        if (!frame_status(f, &s))
+        {
+            break;
+        }
+        _link.push(0, (int32_t)_ecg.total);
+        _link.push(1, (int32_t)s.baud);
+        _link.push(2, (int32_t)s.bytes_sent);
+        _link.push(3, (int32_t)s.frames_sent);
+        _link.push(4, (int32_t)s.frames_dropped);
+        _link.push(5, (int32_t)s.tx_full);
+        _link.push(6, s.queue_peak);
+        _link.push(7, s.queue_size);
+        _link.push(8, s.ecg_decimation);
+        _link.push(9, s.ppg_decimation);
+        _link.total++;
+        return true;
+    }
+
+    default:
+        // Baud and command answers and unknown types carry no rows
+        return false;
+    }
+    bad_frames++;
+    return false;
+}
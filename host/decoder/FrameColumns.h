@@ -0,0 +1,97 @@
+/***************************************************************
+//   Decoded frames as columns
+//
+//   Every stream mode comes out as the same four tables, one int32
+//   array per column:
+//     ecg     ecg, resp, status              125 SPS
+//     ppg     ir, red                        500 SPS
+//     vitals  ecg_row, temperature, resp_rate, spo2, heart_rate, status
+//     link    ecg_row, baud, bytes_sent, frames_sent, frames_dropped,
+//             tx_full, queue_peak, queue_size, ecg_decimation,
+//             ppg_decimation
+//   ecg_row is the number of ECG rows before the frame, which places
+//   the slow values on the sample clock.
+//
+//   The combined data frame carries one of each; like Recording, a
+//   new ECG or PPG row is only taken when its values change, and a
+//   vitals row when any vital changes. Batches give a row per sample.
+//
+//   Rows build up until the caller writes a table out and clears it.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef FrameColumns_h
+#define FrameColumns_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "HealthyPiFrames.h"
+
+#define FRAME_TABLE_ECG     0
+#define FRAME_TABLE_PPG     1
+#define FRAME_TABLE_VITALS  2
+#define FRAME_TABLE_LINK    3
+#define FRAME_TABLE_COUNT   4
+// Widest table
+#define FRAME_TABLE_MAX_COLUMNS 10
+
+class ColumnTable
+{
+  public:
+    ColumnTable(const char *name, const char *const *columns, int width);
+
+    const char *name() const { return _name; }
+    int width() const { return _width; }
+    const char *columnName(int c) const { return _columns[c]; }
+    size_t rows() const { return _data[0].size(); }
+    const int32_t *column(int c) const { return _data[c].data(); }
+    void clear();
+
+    // Row total over the whole run, including rows already cleared
+    uint64_t total;
+
+  private:
+    friend class FrameColumns;
+    void push(int c, int32_t value) { _data[c].push_back(value); }
+
+    const char *_name;
+    const char *const *_columns;
+    int _width;
+    std::vector<int32_t> _data[FRAME_TABLE_MAX_COLUMNS];
+};
+
+class FrameColumns
+{
+  public:
+    FrameColumns();
+    // Decode one frame into rows - false if it held none
+    bool add(const frame_view *f);
+
+    ColumnTable &table(int t) { return *_tables[t]; }
+    // Rows waiting in the fullest table
+    size_t pending() const;
+
+    // Frames of a known type that would not decode
+    uint32_t bad_frames;
+
+  private:
+    void ecgRow(int16_t ecg, int16_t resp, uint8_t status);
+    void ppgRow(int32_t ir, int32_t red);
+    void vitalsRow(const healthypi_vitals *v);
+
+    ColumnTable _ecg;
+    ColumnTable _ppg;
+    ColumnTable _vitals;
+    ColumnTable _link;
+    ColumnTable *_tables[FRAME_TABLE_COUNT];
+
+    // Last values of the combined data frame, to collapse repeats
+    healthypi_vitals _last;
+    bool _have_last;
+    healthypi_batch _batch;
+};
+
+#endif
@@ -0,0 +1,128 @@
+/***************************************************************
+//   Finds HealthyPi frames in large reads of a capture
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "FrameReader.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+FrameReader::FrameReader(size_t buffer_bytes)
+    : _buffer(buffer_bytes < 2 * (PACKET_MAX_PAYLOAD + PACKET_OVERHEAD)
+              ? 2 * (PACKET_MAX_PAYLOAD + PACKET_OVERHEAD) : buffer_bytes)
+{
+    reset();
+}
+
+void FrameReader::reset()
+{
+    bytes = 0;
+    frames = 0;
+    skipped_bytes = 0;
+    crc_errors = 0;
+    lost_batches = 0;
+    memset(&_sequence, 0, sizeof(_sequence));
+    _begin = 0;
+    _end = 0;
+}
+
+bool FrameReader::fill(int fd)
+{
+    if (_begin > 0)
+    {
+        memmove(&_buffer[0], &_buffer[_begin], _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+    }
+    for (;;)
+    {
+        ssize_t n = read(fd, &_buffer[_end], _buffer.size() - _end);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        _end += n;
+        bytes += n;
+        return true;
+    }
+}
+
+bool FrameReader::next(frame_view *out)
+{
+    const uint8_t *base = &_buffer[0];
+    for (;;)
+    {
+        const uint8_t *start = (const uint8_t *)memchr(base + _begin, PACKET_START_1, _end - _begin);
+        if (start == NULL)
+        {
+            skipped_bytes += _end - _begin;
+            _begin = _end;
+            return false;
+        }
+        size_t at = start - base;
+        skipped_bytes += at - _begin;
+        _begin = at;
+        size_t left = _end - at;
+        if (left < 2)
+        {
+            return false;
+        }
+        if (start[1] != PACKET_START_2)
+        {
+            skipped_bytes++;
+            _begin++;
+            continue;
+        }
+        if (left < 5)
+        {
+            return false;
+        }
+        uint16_t length = (uint16_t)(start[2] | start[3] << 8);
+        if (length > PACKET_MAX_PAYLOAD)
+        {
+            skipped_bytes++;
+            _begin++;
+            continue;
+        }
+        size_t size = length + PACKET_OVERHEAD;
+        if (left < size)
+        {
+            return false;
+        }
+        if (start[size - 2] != PACKET_STOP_1 || start[size - 1] != PACKET_STOP_2)
+        {
+            skipped_bytes++;
+            _begin++;
+            continue;
+        }
+        _begin += size;
+
+        out->type = start[4];
+        out->length = length;
+        out->payload = start + 5;
+        if (frame_is_batch(out))
+        {
+            if (!frame_check_batch(out, &_sequence))
+            {
+                crc_errors++;
+                continue;
+            }
+            lost_batches = _sequence.lost;
+        }
+        frames++;
+        return true;
+    }
+}
+
+void FrameReader::finish()
+{
+    skipped_bytes += _end - _begin;
+    _begin = _end;
+}
@@ -0,0 +1,60 @@
+/***************************************************************
+//   Finds HealthyPi frames in large reads of a capture
+//
+//   The bytes are read into one buffer and scanned there: memchr to
+//   the next 0x0A, then the start, length and stop bytes are checked
+//   in place. A frame that passes is handed out as a frame_view into
+//   the buffer - its payload is never copied. Only the unfinished
+//   frame at the end of a read (under PACKET_MAX_PAYLOAD +
+//   PACKET_OVERHEAD bytes) is moved to the front before the next one.
+//
+//   Anything that is not a frame is skipped and counted. After a
+//   broken frame - bad stop bytes or an impossible length - the scan
+//   starts again one byte past its 0x0A, so a real frame hidden behind
+//   a stray 0x0A (a newline in debug text) is still found. Batches
+//   with a bad CRC are skipped whole and counted, and sequence gaps
+//   counted as lost, as PacketScanner does.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef FrameReader_h
+#define FrameReader_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "HealthyPiFrames.h"
+
+#define FRAME_READER_BUFFER (1 << 20)
+
+class FrameReader
+{
+  public:
+    explicit FrameReader(size_t buffer_bytes = FRAME_READER_BUFFER);
+    void reset();
+
+    // Read more of the file - false at end of file or on an error.
+    // Views from next() are only good until the next fill().
+    bool fill(int fd);
+    // The next whole frame in what has been read - false when more
+    // must be read first
+    bool next(frame_view *out);
+    // At end of file, count what is left as skipped
+    void finish();
+
+    uint64_t bytes;
+    uint64_t frames;
+    uint64_t skipped_bytes;
+    uint32_t crc_errors;
+    uint32_t lost_batches;
+
+  private:
+    std::vector<uint8_t> _buffer;
+    size_t _begin;
+    size_t _end;
+    frame_sequence _sequence;
+};
+
+#endif
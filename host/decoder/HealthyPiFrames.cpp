@@ -0,0 +1,301 @@
+/***************************************************************
+//   HealthyPi serial frames - decoded on the host
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "HealthyPiFrames.h"
+#include <string.h>
+#include "crc16.h"
+#include "sample_codec.h"
+
+// Fixed part of a batch payload before the samples, and the CRC after
+#define BATCH_HEADER_BYTES  7
+#define PACKED_BATCH_HEADER_BYTES 8
+#define BATCH_CRC_BYTES     2
+#define BATCH_VITALS_BYTES  8
+
+// The firmware's crc16() goes a nibble at a time to save flash; here
+// it is most of the decoding time of a batch stream, so the same CRC
+// is taken eight bytes at a time from eight 256 entry tables
+static uint16_t crc_tables[8][256];
+
+static bool make_crc_tables()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (uint16_t)((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+        }
+        crc_tables[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            uint16_t crc = crc_tables[k - 1][i];
+            crc_tables[k][i] = (uint16_t)((crc << 8) ^ crc_tables[0][crc >> 8]);
+        }
+    }
+    return true;
+}
+
+static uint16_t frame_crc16(const uint8_t *p, size_t len)
+{
+    static const bool made = make_crc_tables();
+    (void)made;
+    uint16_t crc = CRC16_INIT;
+    for (; len >= 8; len -= 8, p += 8)
+    {
+        crc = crc_tables[7][p[0] ^ (crc >> 8)] ^ crc_tables[6][p[1] ^ (crc & 0xFF)]
+              ^ crc_tables[5][p[2]] ^ crc_tables[4][p[3]] ^ crc_tables[3][p[4]]
+              ^ crc_tables[2][p[5]] ^ crc_tables[1][p[6]] ^ crc_tables[0][p[7]];
+    }
+    for (; len > 0; len--, p++)
+    {
+        crc = (uint16_t)((crc << 8) ^ crc_tables[0][(crc >> 8) ^ *p]);
+    }
+    return crc;
+}
+
+static int32_t get_int24(const uint8_t *p)
+{
+    return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+}
+
+bool frame_check_batch(const frame_view *f, frame_sequence *sequence)
+{
+    if (f->length < BATCH_HEADER_BYTES + BATCH_CRC_BYTES)
+    {
+        return false;
+    }
+    const uint8_t *p = f->payload;
+    uint16_t crc = (uint16_t)(p[f->length - 2] | p[f->length - 1] << 8);
+    if (frame_crc16(p, f->length - BATCH_CRC_BYTES) != crc)
+    {
+        return false;
+    }
+    uint16_t number = (uint16_t)(p[1] | p[2] << 8);
+    if (sequence->have)
+    {
+        sequence->lost += (uint16_t)(number - sequence->next);
+    }
+    sequence->next = number + 1;
+    sequence->have = true;
+    return true;
+}
+
+// Four coded channels - ECG, resp, IR, RED - then the vitals and CRC
+static bool unpack_batch(const frame_view *f, healthypi_batch *out)
+{
+    int32_t channel[4][PACKET_BATCH_MAX_SAMPLES];
+    const uint8_t counts[4] = {out->ecg_count, out->ecg_count, out->ppg_count, out->ppg_count};
+    const uint8_t *p = f->payload;
+    uint8_t coder = p[7];
+    size_t end = f->length - BATCH_CRC_BYTES - ((out->flags & PACKET_BATCH_FLAG_VITALS) ? BATCH_VITALS_BYTES : 0);
+    size_t used = PACKED_BATCH_HEADER_BYTES;
+    for (int c = 0; c < 4; c++)
+    {
+        if (counts[c] == 0)
+        {
+            continue;
+        }
+        if (used >= end)
+        {
+            return false;
+        }
+        size_t bytes = sample_decode(coder, &p[used], end - used, channel[c], counts[c]);
+        if (bytes == 0)
+        {
+            return false;
+        }
+        used += bytes;
+    }
+    if (used != end)
+    {
+        return false;
+    }
+    for (int i = 0; i < out->ecg_count; i++)
+    {
+        out->ecg[i].ecg = (int16_t)channel[0][i];
+        out->ecg[i].resp = (int16_t)channel[1][i];
+        out->ecg[i].status = out->status;
+    }
+    for (int i = 0; i < out->ppg_count; i++)
+    {
+        out->ppg[i].ir = channel[2][i];
+        out->ppg[i].red = channel[3][i];
+    }
+    return true;
+}
+
+bool frame_batch(const frame_view *f, healthypi_batch *out)
+{
+    const uint8_t *p = f->payload;
+    if (!frame_is_batch(f) || f->length < PACKED_BATCH_HEADER_BYTES || p[0] != PACKET_BATCH_VERSION)
+    {
+        return false;
+    }
+    out->sequence = (uint16_t)(p[1] | p[2] << 8);
+    out->flags = p[3];
+    out->ecg_count = p[4];
+    out->ppg_count = p[5];
+    out->status = p[6];
+    if (f->type == PACKET_TYPE_PACKED_BATCH)
+    {
+        return unpack_batch(f, out);
+    }
+    size_t expected = BATCH_HEADER_BYTES + out->ecg_count * 4 + out->ppg_count * 6
+                      + ((out->flags & PACKET_BATCH_FLAG_VITALS) ? BATCH_VITALS_BYTES : 0) + BATCH_CRC_BYTES;
+    if (expected != f->length)
+    {
+        return false;
+    }
+    p += BATCH_HEADER_BYTES;
+    for (int i = 0; i < out->ecg_count; i++, p += 4)
+    {
+        memcpy(&out->ecg[i].ecg, &p[0], 2);
+        memcpy(&out->ecg[i].resp, &p[2], 2);
+        out->ecg[i].status = out->status;
+    }
+    for (int i = 0; i < out->ppg_count; i++, p += 6)
+    {
+        out->ppg[i].ir = get_int24(&p[0]);
+        out->ppg[i].red = get_int24(&p[3]);
+    }
+    return true;
+}
+
+bool frame_vitals(const frame_view *f, healthypi_vitals *out)
+{
+    // Slow values start 12 bytes into a data payload, at 0 in a vitals payload
+    const uint8_t *p = f->payload;
+    const uint8_t *slow;
+    if (f->type == PACKET_TYPE_DATA && f->length >= 20)
+    {
+        memcpy(&out->ecg, &p[0], 2);
+        memcpy(&out->resp, &p[2], 2);
+        memcpy(&out->ir, &p[4], 4);
+        memcpy(&out->red, &p[8], 4);
+        slow = &p[12];
+    }
+    else if (f->type == PACKET_TYPE_VITALS && f->length >= BATCH_VITALS_BYTES)
+    {
+        out->ecg = 0;
+        out->resp = 0;
+        out->ir = 0;
+        out->red = 0;
+        slow = &p[0];
+    }
+    else if (frame_is_batch(f) && f->length >= BATCH_HEADER_BYTES + BATCH_VITALS_BYTES + BATCH_CRC_BYTES
+             && p[0] == PACKET_BATCH_VERSION && (p[3] & PACKET_BATCH_FLAG_VITALS))
+    {
+        out->ecg = 0;
+        out->resp = 0;
+        out->ir = 0;
+        out->red = 0;
+        // Just before the CRC
+        slow = &p[f->length - BATCH_CRC_BYTES - BATCH_VITALS_BYTES];
+    }
+    else
+    {
+        return false;
+    }
+    memcpy(&out->temperature, &slow[0], 2);
+    out->resp_rate = slow[2];
+    out->spo2 = slow[3];
+    out->heart_rate = slow[4];
+    out->status = slow[7];
+    return true;
+}
+
+bool frame_ecg(const frame_view *f, healthypi_ecg *out)
+{
+    if (f->type != PACKET_TYPE_ECG || f->length < 5)
+    {
+        return false;
+    }
+    memcpy(&out->ecg, &f->payload[0], 2);
+    memcpy(&out->resp, &f->payload[2], 2);
+    out->status = f->payload[4];
+    return true;
+}
+
+bool frame_ppg(const frame_view *f, healthypi_ppg *out)
+{
+    if (f->type != PACKET_TYPE_PPG || f->length < 8)
+    {
+        return false;
+    }
+    memcpy(&out->ir, &f->payload[0], 4);
+    memcpy(&out->red, &f->payload[4], 4);
+    return true;
+}
+
+bool frame_status(const frame_view *f, healthypi_status *out)
+{
+    const uint8_t *p = f->payload;
+    if (f->type != PACKET_TYPE_STATUS || f->length < 22)
+    {
+        return false;
+    }
+    memcpy(&out->baud, &p[0], 4);
+    memcpy(&out->bytes_sent, &p[4], 4);
+    memcpy(&out->frames_sent, &p[8], 4);
+    memcpy(&out->frames_dropped, &p[12], 4);
+    memcpy(&out->tx_full, &p[16], 4);
+    out->queue_peak = p[20];
+    out->queue_size = p[21];
+    out->ecg_decimation = f->length >= 24 ? p[22] : 1;
+    out->ppg_decimation = f->length >= 24 ? p[23] : 1;
+    return true;
+}
+
+bool frame_baud(const frame_view *f, uint32_t *out)
+{
+    if (f->type != PACKET_TYPE_BAUD || f->length < 4)
+    {
+        return false;
+    }
+    memcpy(out, &f->payload[0], 4);
+    return true;
+}
+
+bool frame_ack(const frame_view *f, healthypi_ack *out)
+{
+    const uint8_t *p = f->payload;
+    if (f->type != PACKET_TYPE_ACK || f->length != 9
+        || frame_crc16(p, 7) != (uint16_t)(p[7] | p[8] << 8))
+    {
+        return false;
+    }
+    out->command = p[0];
+    out->tag = p[1];
+    out->result = p[2];
+    memcpy(&out->value, &p[3], 4);
+    return true;
+}
+
+void frame_command(uint8_t *out, uint8_t command, uint8_t tag, uint8_t target, uint8_t address,
+                   uint32_t value)
+{
+    uint8_t *p = out + 5;
+    out[0] = PACKET_START_1;
+    out[1] = PACKET_START_2;
+    out[2] = PACKET_COMMAND_BYTES;
+    out[3] = 0;
+    out[4] = PACKET_TYPE_COMMAND;
+    p[0] = command;
+    p[1] = tag;
+    p[2] = target;
+    p[3] = address;
+    memcpy(&p[4], &value, 4);
+    uint16_t crc = frame_crc16(p, 8);
+    p[8] = (uint8_t)crc;
+    p[9] = (uint8_t)(crc >> 8);
+    out[PACKET_COMMAND_FRAME_BYTES - 2] = PACKET_STOP_1;
+    out[PACKET_COMMAND_FRAME_BYTES - 1] = PACKET_STOP_2;
+}
@@ -0,0 +1,154 @@
+/***************************************************************
+//   HealthyPi serial frames - decoded on the host
+//
+//   Frames are 0x0A 0xFA, payload length LSB, length MSB, type,
+//   payload, 0x00 0x0B; the payload of each type is laid out in
+//   serial_frame.h. A frame_view points at a payload where it lies -
+//   in a scanner's buffer or straight in a read buffer - and the
+//   frame_* functions decode it into the structs below without any
+//   other copy of the bytes.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef HealthyPiFrames_h
+#define HealthyPiFrames_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PACKET_START_1      0x0A
+#define PACKET_START_2      0xFA
+#define PACKET_STOP_1       0x00
+#define PACKET_STOP_2       0x0B
+#define PACKET_TYPE_DATA    0x02
+#define PACKET_TYPE_ECG     0x03
+#define PACKET_TYPE_PPG     0x04
+#define PACKET_TYPE_VITALS  0x05
+#define PACKET_TYPE_BATCH   0x06
+#define PACKET_TYPE_PACKED_BATCH  0x07
+#define PACKET_TYPE_STATUS  0x08
+#define PACKET_TYPE_BAUD    0x09
+#define PACKET_TYPE_COMMAND 0x0C
+#define PACKET_TYPE_ACK     0x0D
+#define PACKET_BATCH_VERSION      1
+#define PACKET_BATCH_FLAG_VITALS  0x01
+#define PACKET_BATCH_MAX_SAMPLES  255
+#define PACKET_MAX_PAYLOAD  1024
+// Start, length, type, stop
+#define PACKET_OVERHEAD     7
+
+// Command channel - COMMAND_* in serial_frame.h
+#define PACKET_COMMAND_PING           0x01
+#define PACKET_COMMAND_READ_REGISTER  0x02
+#define PACKET_COMMAND_WRITE_REGISTER 0x03
+#define PACKET_COMMAND_STREAM_MODE    0x04
+#define PACKET_COMMAND_DECIMATION     0x05
+#define PACKET_TARGET_ADS1292R        0
+#define PACKET_TARGET_AFE4490         1
+#define PACKET_COMMAND_BYTES          10
+#define PACKET_COMMAND_FRAME_BYTES    (PACKET_COMMAND_BYTES + PACKET_OVERHEAD)
+
+// Decoded fields of the 20 byte CES_CMDIF_TYPE_DATA payload
+// A CES_CMDIF_TYPE_VITALS frame fills all but ecg/resp/ir/red
+typedef struct healthypi_Vitals{
+  int16_t ecg;
+  int16_t resp;
+  int32_t ir;
+  int32_t red;
+  int16_t temperature;  // degC * 100 + 100, as sent
+  uint8_t resp_rate;
+  uint8_t spo2;
+  uint8_t heart_rate;
+  uint8_t status;
+}healthypi_vitals;
+
+// CES_CMDIF_TYPE_ECG payload
+typedef struct healthypi_Ecg{
+  int16_t ecg;
+  int16_t resp;
+  uint8_t status;
+}healthypi_ecg;
+
+// CES_CMDIF_TYPE_PPG payload
+typedef struct healthypi_Ppg{
+  int32_t ir;
+  int32_t red;
+}healthypi_ppg;
+
+// CES_CMDIF_TYPE_BATCH or _PACKED_BATCH payload - frame_vitals(), when
+// flagged, gives the rest
+typedef struct healthypi_Batch{
+  uint16_t sequence;
+  uint8_t flags;
+  uint8_t status;
+  uint8_t ecg_count;
+  uint8_t ppg_count;
+  healthypi_ecg ecg[PACKET_BATCH_MAX_SAMPLES];
+  healthypi_ppg ppg[PACKET_BATCH_MAX_SAMPLES];
+}healthypi_batch;
+
+// CES_CMDIF_TYPE_STATUS payload - serial link counters
+typedef struct healthypi_Status{
+  uint32_t baud;
+  uint32_t bytes_sent;
+  uint32_t frames_sent;
+  uint32_t frames_dropped;
+  uint32_t tx_full;
+  uint8_t queue_peak;
+  uint8_t queue_size;
+  uint8_t ecg_decimation;   // 1 from firmware without the command channel
+  uint8_t ppg_decimation;
+}healthypi_status;
+
+// CES_CMDIF_TYPE_ACK payload - the answer to one command
+typedef struct healthypi_Ack{
+  uint8_t command;
+  uint8_t tag;
+  uint8_t result;           // 0, or COMMAND_ERROR_* in serial_frame.h
+  uint32_t value;
+}healthypi_ack;
+
+// One frame's payload, where it lies
+typedef struct frame_View{
+  uint8_t type;
+  uint16_t length;
+  const uint8_t *payload;
+}frame_view;
+
+// Batch sequence numbers seen so far - counts the gaps
+typedef struct frame_Sequence{
+  bool have;
+  uint16_t next;
+  uint32_t lost;
+}frame_sequence;
+
+inline bool frame_is_batch(const frame_view *f)
+{
+  return f->type == PACKET_TYPE_BATCH || f->type == PACKET_TYPE_PACKED_BATCH;
+}
+
+// Length and CRC of a batch, and its place in the sequence - false if
+// it is damaged, in which case the sequence is left alone
+bool frame_check_batch(const frame_view *f, frame_sequence *sequence);
+
+// Decode a frame of the matching type - false for any other type, or
+// if the payload is the wrong size
+// frame_vitals() takes data and vitals frames, and batches that carry them
+bool frame_vitals(const frame_view *f, healthypi_vitals *out);
+bool frame_ecg(const frame_view *f, healthypi_ecg *out);
+bool frame_ppg(const frame_view *f, healthypi_ppg *out);
+bool frame_batch(const frame_view *f, healthypi_batch *out);
+bool frame_status(const frame_view *f, healthypi_status *out);
+// Rate in a CES_CMDIF_TYPE_BAUD frame
+bool frame_baud(const frame_view *f, uint32_t *out);
+// Answer to a command - false also if its CRC does not match
+bool frame_ack(const frame_view *f, healthypi_ack *out);
+
+// A whole CES_CMDIF_TYPE_COMMAND frame, PACKET_COMMAND_FRAME_BYTES
+// long, ready to write to the port
+void frame_command(uint8_t *out, uint8_t command, uint8_t tag, uint8_t target, uint8_t address,
+                   uint32_t value);
+
+#endif
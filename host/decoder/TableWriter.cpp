@@ -0,0 +1,274 @@
+/***************************************************************
+//   Writes decoded column tables to files
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "TableWriter.h"
+#include <string.h>
+#include "sample_codec.h"
+
+// Longest int32 in decimal, with its sign and a separator
+#define CSV_VALUE_CHARS 12
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Two digits per step, written backwards from the end of a scratch
+// buffer and then moved into place
+static char *put_decimal(char *p, int32_t value)
+{
+    uint32_t u = (uint32_t)value;
+    if (value < 0)
+    {
+        *p++ = '-';
+        u = 0u - u;
+    }
+    char digits[10];
+    char *end = digits + sizeof(digits);
+    char *d = end;
+    while (u >= 100)
+    {
+        uint32_t pair = (u % 100) * 2;
+        u /= 100;
+        *--d = digit_pairs[pair + 1];
+        *--d = digit_pairs[pair];
+    }
+    if (u >= 10)
+    {
+        *--d = digit_pairs[u * 2 + 1];
+        *--d = digit_pairs[u * 2];
+    }
+    else
+    {
+        *--d = (char)('0' + u);
+    }
+    memcpy(p, d, end - d);
+    return p + (end - d);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+CsvWriter::CsvWriter(const char *prefix) : _prefix(prefix)
+{
+    memset(_files, 0, sizeof(_files));
+}
+
+CsvWriter::~CsvWriter()
+{
+    finish();
+}
+
+bool CsvWriter::write(const ColumnTable &table, int t)
+{
+    if (_files[t] == NULL)
+    {
+        std::string path = _prefix + "_" + table.name() + ".csv";
+        _files[t] = fopen(path.c_str(), "w");
+        if (_files[t] == NULL)
+        {
+            return false;
+        }
+        for (int c = 0; c < table.width(); c++)
+        {
+            fprintf(_files[t], "%s%s", c > 0 ? "," : "", table.columnName(c));
+        }
+        fputc('\n', _files[t]);
+    }
+
+    size_t rows = table.rows();
+    int width = table.width();
+    _text.resize(rows * width * CSV_VALUE_CHARS);
+    const int32_t *columns[FRAME_TABLE_MAX_COLUMNS];
+    for (int c = 0; c < width; c++)
+    {
+        columns[c] = table.column(c);
+    }
+    char *p = _text.data();
+    for (size_t r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < width; c++)
+        {
+            p = put_decimal(p, columns[c][r]);
+            *p++ = ',';
+        }
+        p[-1] = '\n';
+    }
+    size_t len = p - _text.data();
+    bytes += len;
+    return fwrite(_text.data(), 1, len, _files[t]) == len;
+}
+
+bool CsvWriter::finish()
+{
+    bool ok = true;
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        if (_files[t] != NULL)
+        {
+            ok = (fclose(_files[t]) == 0) && ok;
+            _files[t] = NULL;
+        }
+    }
+    return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+ColumnWriter::ColumnWriter(const char *prefix) : _prefix(prefix)
+{
+}
+
+ColumnWriter::~ColumnWriter()
+{
+    finish();
+}
+
+bool ColumnWriter::write(const ColumnTable &table, int t)
+{
+    if (_files[t].empty())
+    {
+        for (int c = 0; c < table.width(); c++)
+        {
+            std::string path = _prefix + "_" + table.name() + "_" + table.columnName(c) + ".i32";
+            FILE *file = fopen(path.c_str(), "wb");
+            if (file == NULL)
+            {
+                return false;
+            }
+            _files[t].push_back(file);
+        }
+    }
+    // The host is little endian, like the stream
+    size_t rows = table.rows();
+    for (int c = 0; c < table.width(); c++)
+    {
+        if (fwrite(table.column(c), sizeof(int32_t), rows, _files[t][c]) != rows)
+        {
+            return false;
+        }
+        bytes += rows * sizeof(int32_t);
+    }
+    return true;
+}
+
+bool ColumnWriter::finish()
+{
+    bool ok = true;
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        for (size_t c = 0; c < _files[t].size(); c++)
+        {
+            ok = (fclose(_files[t][c]) == 0) && ok;
+        }
+        _files[t].clear();
+    }
+    return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+ChunkWriter::ChunkWriter(const char *prefix, uint8_t coder)
+    : _path(std::string(prefix) + ".hpck"), _file(NULL), _coder(coder)
+{
+    memset(_tables, 0, sizeof(_tables));
+}
+
+ChunkWriter::~ChunkWriter()
+{
+    finish();
+}
+
+bool ChunkWriter::put(const void *data, size_t len)
+{
+    bytes += len;
+    return fwrite(data, 1, len, _file) == len;
+}
+
+bool ChunkWriter::write(const ColumnTable &table, int t)
+{
+    if (_file == NULL)
+    {
+        _file = fopen(_path.c_str(), "wb");
+        uint8_t version = CHUNK_FILE_VERSION;
+        if (_file == NULL || !put("HPCK", 4) || !put(&version, 1))
+        {
+            return false;
+        }
+    }
+    _tables[t] = &table;
+
+    size_t rows = table.rows();
+    for (size_t first = 0; first < rows; first += CHUNK_MAX_ROWS)
+    {
+        uint16_t n = (uint16_t)(rows - first < CHUNK_MAX_ROWS ? rows - first : CHUNK_MAX_ROWS);
+        // Worst case is an escaped Rice value per sample
+        _coded.resize(n * 6 + 16);
+        for (int c = 0; c < table.width(); c++)
+        {
+            size_t len = sample_encode(_coder, table.column(c) + first, n, _coded.data(), _coded.size());
+            chunk_entry entry = {(uint8_t)t, (uint8_t)c, _coder, n, bytes, (uint32_t)len};
+            if (len == 0 || !put(_coded.data(), len))
+            {
+                return false;
+            }
+            _chunks.push_back(entry);
+        }
+    }
+    return true;
+}
+
+bool ChunkWriter::finish()
+{
+    if (_file == NULL)
+    {
+        return true;
+    }
+    std::vector<uint8_t> footer;
+    uint8_t tables = 0;
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        tables += (_tables[t] != NULL);
+    }
+    // Tables that never had rows are left out, so their indexes keep
+    // their FRAME_TABLE_* values and the names say which is which
+    footer.push_back(tables);
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        if (_tables[t] == NULL)
+        {
+            continue;
+        }
+        const char *name = _tables[t]->name();
+        footer.push_back((uint8_t)t);
+        footer.push_back((uint8_t)strlen(name));
+        footer.insert(footer.end(), name, name + strlen(name));
+        footer.push_back((uint8_t)_tables[t]->width());
+        for (int c = 0; c < _tables[t]->width(); c++)
+        {
+            const char *column = _tables[t]->columnName(c);
+            footer.push_back((uint8_t)strlen(column));
+            footer.insert(footer.end(), column, column + strlen(column));
+        }
+    }
+    uint32_t count = _chunks.size();
+    footer.insert(footer.end(), (uint8_t *)&count, (uint8_t *)&count + 4);
+    for (size_t i = 0; i < _chunks.size(); i++)
+    {
+        const chunk_entry &e = _chunks[i];
+        footer.push_back(e.table);
+        footer.push_back(e.column);
+        footer.push_back(e.coder);
+        footer.insert(footer.end(), (const uint8_t *)&e.rows, (const uint8_t *)&e.rows + 2);
+        footer.insert(footer.end(), (const uint8_t *)&e.offset, (const uint8_t *)&e.offset + 8);
+        footer.insert(footer.end(), (const uint8_t *)&e.bytes, (const uint8_t *)&e.bytes + 4);
+    }
+    uint32_t length = footer.size();
+    bool ok = put(footer.data(), footer.size()) && put(&length, 4) && put("HPCK", 4);
+    ok = (fclose(_file) == 0) && ok;
+    _file = NULL;
+    return ok;
+}
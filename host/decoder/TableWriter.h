@@ -0,0 +1,116 @@
+/***************************************************************
+//   Writes decoded column tables to files
+//
+//   write() is called with each table whenever enough rows have built
+//   up, and finish() once at the end. Three formats:
+//
+//   CsvWriter     <prefix>_<table>.csv, a header line then one row per
+//                 line. The numbers are formatted by hand into a large
+//                 buffer - printf would cost more than the decoding.
+//   ColumnWriter  <prefix>_<table>_<column>.i32 per column, the int32
+//                 values little endian and nothing else, ready for
+//                 numpy.fromfile or a memory map.
+//   ChunkWriter   <prefix>.hpck, one file in row groups: each write()
+//                 adds a chunk per column, coded with sample_codec
+//                 (first value, then zig-zag differences). A footer at
+//                 the end lists the tables, their columns and every
+//                 chunk, so a reader can go straight to one column:
+//
+//     "HPCK" version(1)
+//     chunk data ...
+//     footer:
+//       table count(1), then per table: FRAME_TABLE_* index(1)
+//         name length(1) name
+//         column count(1), then per column: name length(1) name
+//       chunk count(4), then per chunk: table(1) column(1) coder(1)
+//         rows(2) offset(8) bytes(4)
+//     footer length(4) "HPCK"
+//
+//   Numbers are little endian. A chunk holds at most 65535 rows.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef TableWriter_h
+#define TableWriter_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "FrameColumns.h"
+
+#define CHUNK_FILE_VERSION  1
+#define CHUNK_MAX_ROWS      65535
+
+class TableWriter
+{
+  public:
+    virtual ~TableWriter() {}
+    virtual bool write(const ColumnTable &table, int t) = 0;
+    virtual bool finish() = 0;
+    // Bytes written so far
+    uint64_t bytes;
+
+  protected:
+    TableWriter() : bytes(0) {}
+};
+
+class CsvWriter : public TableWriter
+{
+  public:
+    explicit CsvWriter(const char *prefix);
+    ~CsvWriter();
+    bool write(const ColumnTable &table, int t);
+    bool finish();
+
+  private:
+    std::string _prefix;
+    FILE *_files[FRAME_TABLE_COUNT];
+    std::vector<char> _text;
+};
+
+class ColumnWriter : public TableWriter
+{
+  public:
+    explicit ColumnWriter(const char *prefix);
+    ~ColumnWriter();
+    bool write(const ColumnTable &table, int t);
+    bool finish();
+
+  private:
+    std::string _prefix;
+    std::vector<FILE *> _files[FRAME_TABLE_COUNT];
+};
+
+class ChunkWriter : public TableWriter
+{
+  public:
+    ChunkWriter(const char *prefix, uint8_t coder);
+    ~ChunkWriter();
+    bool write(const ColumnTable &table, int t);
+    bool finish();
+
+  private:
+    typedef struct chunk_Entry{
+      uint8_t table;
+      uint8_t column;
+      uint8_t coder;
+      uint16_t rows;
+      uint64_t offset;
+      uint32_t bytes;
+    }chunk_entry;
+
+    bool put(const void *data, size_t len);
+
+    std::string _path;
+    FILE *_file;
+    uint8_t _coder;
+    std::vector<chunk_entry> _chunks;
+    std::vector<uint8_t> _coded;
+    // Names, kept from the first write of each table
+    const ColumnTable *_tables[FRAME_TABLE_COUNT];
+};
+
+#endif
@@ -0,0 +1,209 @@
+/***************************************************************
+//   healthypi_decode - convert a serial capture to tables
+//
+//   usage: healthypi_decode [options] <capture>
+//     <capture>        raw bytes from the serial port, in any stream
+//                      mode; - reads stdin
+//     --format <f>     csv (default), columns or chunks - see
+//                      TableWriter.h
+//     -o <prefix>      output files start with this (default: the
+//                      capture's name without its extension)
+//     --chunk-rows <n> rows gathered before a table is written, and
+//                      so the row group size of a chunk file
+//                      (default 65535)
+//     --coder <n>      sample coder for chunk files, SAMPLE_CODER_* in
+//                      sample_codec.h (default varint)
+//     --count          decode only, write nothing - the decoder's own
+//                      speed
+//
+//   Tables and columns are listed in FrameColumns.h. A summary with
+//   the rows of each table, the frames skipped, damaged or lost and
+//   the rate in MB/s of capture is printed to stderr.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include "FrameReader.h"
+#include "FrameColumns.h"
+#include "TableWriter.h"
+#include "sample_codec.h"
+
+static bool flush_tables(FrameColumns *columns, TableWriter *writer, size_t at_least)
+{
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        ColumnTable &table = columns->table(t);
+        if (table.rows() == 0 || table.rows() < at_least)
+        {
+            continue;
+        }
+        if (writer != NULL && !writer->write(table, t))
+        {
+            return false;
+        }
+        table.clear();
+    }
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--format csv|columns|chunks] [-o prefix] [--chunk-rows n] [--coder n] "
+                    "[--count] <capture>\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *format = "csv";
+    const char *input = NULL;
+    std::string prefix;
+    unsigned long chunk_rows = CHUNK_MAX_ROWS;
+    int coder = SAMPLE_CODER_VARINT;
+    bool count_only = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            format = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "--chunk-rows") == 0 && i + 1 < argc)
+        {
+            chunk_rows = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--coder") == 0 && i + 1 < argc)
+        {
+            coder = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--count") == 0)
+        {
+            count_only = true;
+        }
+        else if (input == NULL && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0))
+        {
+            input = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (input == NULL)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (chunk_rows == 0 || chunk_rows > CHUNK_MAX_ROWS)
+    {
+        fprintf(stderr, "--chunk-rows must be 1 to %d\n", CHUNK_MAX_ROWS);
+        return 2;
+    }
+    if (coder < 0 || coder >= SAMPLE_CODER_COUNT)
+    {
+        fprintf(stderr, "unknown coder %d\n", coder);
+        return 2;
+    }
+    if (prefix.empty())
+    {
+        prefix = strcmp(input, "-") == 0 ? "capture" : input;
+        size_t dot = prefix.rfind('.');
+        if (dot != std::string::npos && prefix.find('/', dot) == std::string::npos)
+        {
+            prefix.erase(dot);
+        }
+    }
+
+    TableWriter *writer = NULL;
+    if (count_only)
+    {
+        writer = NULL;
+    }
+    else if (strcmp(format, "csv") == 0)
+    {
+        writer = new CsvWriter(prefix.c_str());
+    }
+    else if (strcmp(format, "columns") == 0)
+    {
+        writer = new ColumnWriter(prefix.c_str());
+    }
+    else if (strcmp(format, "chunks") == 0)
+    {
+        writer = new ChunkWriter(prefix.c_str(), (uint8_t)coder);
+    }
+    else
+    {
+        fprintf(stderr, "unknown format %s\n", format);
+        return 2;
+    }
+
+    int fd = strcmp(input, "-") == 0 ? 0 : open(input, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot open %s\n", input);
+        return 1;
+    }
+
+    FrameReader reader;
+    FrameColumns columns;
+    frame_view frame;
+    bool ok = true;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (ok && reader.fill(fd))
+    {
+        while (reader.next(&frame))
+        {
+            columns.add(&frame);
+        }
+        // Views are only good until the next fill, but the rows are copies
+        if (columns.pending() >= chunk_rows)
+        {
+            ok = flush_tables(&columns, writer, chunk_rows);
+        }
+    }
+    reader.finish();
+    ok = ok && flush_tables(&columns, writer, 0);
+    if (writer != NULL)
+    {
+        ok = writer->finish() && ok;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (fd != 0)
+    {
+        close(fd);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "error writing %s files\n", format);
+    }
+
+    fprintf(stderr, "%llu bytes, %llu frames in %.3f s - %.1f MB/s\n", (unsigned long long)reader.bytes,
+            (unsigned long long)reader.frames, seconds, seconds > 0 ? reader.bytes / seconds / 1e6 : 0.0);
+    fprintf(stderr, "rows: ");
+    for (int t = 0; t < FRAME_TABLE_COUNT; t++)
+    {
+        fprintf(stderr, "%s %llu%s", columns.table(t).name(), (unsigned long long)columns.table(t).total,
+                t + 1 < FRAME_TABLE_COUNT ? ", " : "\n");
+    }
+    fprintf(stderr, "skipped %llu bytes, %lu bad CRC, %lu batches lost, %lu frames not decoded\n",
+            (unsigned long long)reader.skipped_bytes, (unsigned long)reader.crc_errors,
+            (unsigned long)reader.lost_batches, (unsigned long)columns.bad_frames);
+    if (writer != NULL)
+    {
+        fprintf(stderr, "%s: %llu bytes written\n", format, (unsigned long long)writer->bytes);
+        delete writer;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/***************************************************************
+//   healthypi_command - send one command to a running device
+//
+//   usage: healthypi_command [--timeout ms] <port> <command>
+//     ping                      protocol version
+//     read ads|afe <reg>        register value
+//     write ads|afe <reg> <v>   write, then the value read back
+//     mode <n> [coder]          STREAM_MODE_* in packet_scheduler.h,
+//                               SAMPLE_CODER_* in sample_codec.h
+//     decimate <ecg> <ppg>      samples averaged into each one sent
+//   Numbers may be decimal or 0x hex.
+//
+//   <port> is the board's serial port or healthypi_device's pty. The
+//   command goes out as a CES_CMDIF_TYPE_COMMAND frame with a fresh
+//   tag, and the answer is the CES_CMDIF_TYPE_ACK frame with the same
+//   tag among the stream; everything else is passed over. With no
+//   answer in time the command is sent again, up to three times.
+//   Prints the value and exits 0 if the device answered COMMAND_OK.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+#include <chrono>
+#include "PacketScanner.h"
+
+#define COMMAND_TRIES 3
+
+static const char *const result_names[] = {"ok", "damaged", "unknown command", "bad argument", "busy",
+                                           "register access failed"};
+
+static bool parse_target(const char *s, uint8_t *target)
+{
+    if (strcmp(s, "ads") == 0)
+    {
+        *target = PACKET_TARGET_ADS1292R;
+        return true;
+    }
+    if (strcmp(s, "afe") == 0)
+    {
+        *target = PACKET_TARGET_AFE4490;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_number(const char *s, uint32_t *out)
+{
+    char *end;
+    *out = (uint32_t)strtoul(s, &end, 0);
+    return *s != 0 && *end == 0;
+}
+
+// The frame for the command line, false if it makes no sense
+static bool parse_command(int argc, char **argv, uint8_t tag, uint8_t *frame)
+{
+    uint8_t target = 0;
+    uint32_t address = 0, value = 0, extra = 0;
+    if (argc == 1 && strcmp(argv[0], "ping") == 0)
+    {
+        frame_command(frame, PACKET_COMMAND_PING, tag, 0, 0, 0);
+        return true;
+    }
+    if (argc == 3 && strcmp(argv[0], "read") == 0 && parse_target(argv[1], &target)
+        && parse_number(argv[2], &address) && address <= 0xFF)
+    {
+        frame_command(frame, PACKET_COMMAND_READ_REGISTER, tag, target, (uint8_t)address, 0);
+        return true;
+    }
+    if (argc == 4 && strcmp(argv[0], "write") == 0 && parse_target(argv[1], &target)
+        && parse_number(argv[2], &address) && address <= 0xFF && parse_number(argv[3], &value))
+    {
+        frame_command(frame, PACKET_COMMAND_WRITE_REGISTER, tag, target, (uint8_t)address, value);
+        return true;
+    }
+    if ((argc == 2 || argc == 3) && strcmp(argv[0], "mode") == 0 && parse_number(argv[1], &value)
+        && (argc == 2 || (parse_number(argv[2], &extra) && extra <= 0xFF)))
+    {
+        // The coder defaults to Rice, as the firmware's
+        frame_command(frame, PACKET_COMMAND_STREAM_MODE, tag, 0, argc == 3 ? (uint8_t)extra : 1, value);
+        return true;
+    }
+    if (argc == 3 && strcmp(argv[0], "decimate") == 0 && parse_number(argv[1], &value) && value <= 0xFF
+        && parse_number(argv[2], &extra) && extra <= 0xFF)
+    {
+        frame_command(frame, PACKET_COMMAND_DECIMATION, tag, 0, 0, value | extra << 8);
+        return true;
+    }
+    return false;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--timeout ms] <port> ping | read ads|afe <reg> | write ads|afe <reg> <value> "
+                    "| mode <n> [coder] | decimate <ecg> <ppg>\n", name);
+}
+
+// Wait for the answer with this tag - false if it does not come in time
+static bool wait_ack(int fd, uint8_t tag, int timeout_ms, PacketScanner *scanner, healthypi_ack *ack)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+                                                + std::chrono::milliseconds(timeout_ms);
+    uint8_t buffer[1024];
+    for (;;)
+    {
+        int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                       end - std::chrono::steady_clock::now()).count();
+        struct pollfd p = {fd, POLLIN, 0};
+        if (left <= 0 || poll(&p, 1, left) <= 0)
+        {
+            return false;
+        }
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            return false;
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (scanner->push(buffer[i]) && scanner->ack(ack) && ack->tag == tag)
+            {
+                return true;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int timeout_ms = 500;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "--timeout") == 0)
+    {
+        timeout_ms = atoi(argv[2]);
+        first = 3;
+    }
+    if (argc - first < 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *port = argv[first];
+
+    // Tags only need to differ from the last few commands
+    uint8_t tag = (uint8_t)(time(NULL) ^ getpid());
+    uint8_t frame[PACKET_COMMAND_FRAME_BYTES];
+    if (!parse_command(argc - first - 1, argv + first + 1, tag, frame))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = open(port, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot open %s\n", port);
+        return 1;
+    }
+    // Raw, and at whatever rate the port is already running
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    PacketScanner scanner;
+    healthypi_ack ack;
+    bool answered = false;
+    for (int attempt = 0; attempt < COMMAND_TRIES && !answered; attempt++)
+    {
+        if (write(fd, frame, sizeof(frame)) != (ssize_t)sizeof(frame))
+        {
+            fprintf(stderr, "cannot write to %s\n", port);
+            close(fd);
+            return 1;
+        }
+        answered = wait_ack(fd, tag, timeout_ms, &scanner, &ack);
+    }
+    close(fd);
+    if (!answered)
+    {
+        fprintf(stderr, "no answer from %s\n", port);
+        return 1;
+    }
+    if (ack.result != 0)
+    {
+        const char *name = ack.result < sizeof(result_names) / sizeof(result_names[0])
+                           ? result_names[ack.result] : "unknown error";
+        fprintf(stderr, "error %u: %s\n", ack.result, name);
+        return 1;
+    }
+    printf("%lu 0x%06lx\n", (unsigned long)ack.value, (unsigned long)ack.value);
+    return 0;
+}
@@ -0,0 +1,228 @@
+/***************************************************************
+//   healthypi_device - the sketch as a serial device on a Linux pty
+//
+//   usage: healthypi_device [options] <recording>
+//     --capture        recording is a raw serial packet capture
+//                      (default: sample text, see Recording.h)
+//     --once           stop at the end of the recording rather than
+//                      starting it again
+//     --link <path>    also make a symlink to the port here
+//     --packets <file> also write the serial stream the sketch produced
+//
+//   The sketch runs through SketchReplay as in healthypi_replay, but in
+//   real time: samples are fed at their own rates against the wall
+//   clock, everything the sketch writes goes to the pty, and everything
+//   written to the pty comes back in through Serial. Any host program -
+//   healthypi_command, a viewer, a logger - can open the port printed
+//   on stderr as if it were the board's USB serial port, change the
+//   baud rate and send commands (command_channel.h).
+//
+//   As from the board's USB bridge, output nobody reads is lost once
+//   the pty's buffer is full; the count is printed at exit.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <termios.h>
+#include <chrono>
+#include <thread>
+#include "SketchReplay.h"
+#include "HostShim.h"
+
+// Wall clock time fed at once before the device sleeps
+#define DEVICE_STEP_US  10000
+
+static volatile sig_atomic_t stop_requested = 0;
+static unsigned long dropped_bytes = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void pty_sink(const uint8_t *data, size_t len, void *ctx)
+{
+    int fd = *(int *)ctx;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0)
+        {
+            dropped_bytes += len;
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static bool open_pty(int *master, int *slave)
+{
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0)
+    {
+        return false;
+    }
+    // Held open so the port survives clients coming and going
+    *slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+    if (*slave < 0)
+    {
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    fcntl(*master, F_SETFL, fcntl(*master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--capture] [--once] [--link path] [--packets stream.bin] <recording>\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *input = NULL;
+    const char *link_path = NULL;
+    const char *packets_path = NULL;
+    bool capture = false;
+    bool once = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--capture") == 0)
+        {
+            capture = true;
+        }
+        else if (strcmp(argv[i], "--once") == 0)
+        {
+            once = true;
+        }
+        else if (strcmp(argv[i], "--link") == 0 && i + 1 < argc)
+        {
+            link_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc)
+        {
+            packets_path = argv[++i];
+        }
+        else if (input == NULL && argv[i][0] != '-')
+        {
+            input = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (input == NULL)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Recording recording;
+    if (!recording.open(input, capture))
+    {
+        fprintf(stderr, "cannot open %s\n", input);
+        return 1;
+    }
+    FILE *packets = NULL;
+    if (packets_path != NULL && (packets = fopen(packets_path, "wb")) == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", packets_path);
+        return 1;
+    }
+    int master, slave;
+    if (!open_pty(&master, &slave))
+    {
+        fprintf(stderr, "cannot open a pty\n");
+        return 1;
+    }
+    if (link_path != NULL)
+    {
+        unlink(link_path);
+        if (symlink(ptsname(master), link_path) != 0)
+        {
+            fprintf(stderr, "cannot link %s\n", link_path);
+            return 1;
+        }
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    SketchReplay replay;
+    replay.begin();
+    // setup() chatter is not sent - a board's would be long gone before
+    // a host opened the port
+    replay.onSerial(pty_sink, &master);
+    replay.captureTo(packets);
+    fprintf(stderr, "healthypi_device: %s\n", link_path != NULL ? link_path : ptsname(master));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long fed_us = 0;
+    unsigned long ppg_samples = 0;
+    replay_event event;
+    while (!stop_requested)
+    {
+        uint8_t in[256];
+        ssize_t n = read(master, in, sizeof(in));
+        if (n > 0)
+        {
+            hostSerialInject(in, n);
+        }
+
+        // Samples up to DEVICE_STEP_US ahead of the wall clock
+        unsigned long now_us = (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - start).count();
+        while (fed_us < now_us + DEVICE_STEP_US && !stop_requested)
+        {
+            if (!recording.next(&event))
+            {
+                // A recording without PPG samples never moves the clock on
+                if (once || ppg_samples == 0)
+                {
+                    stop_requested = 1;
+                    break;
+                }
+                ppg_samples = 0;
+                recording.close();
+                recording.open(input, capture);
+                continue;
+            }
+            replay.feed(&event);
+            if (event.type == REPLAY_EVENT_PPG)
+            {
+                ppg_samples++;
+                fed_us += REPLAY_PPG_PERIOD_US;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(DEVICE_STEP_US / 2));
+    }
+    replay.finish();
+
+    fprintf(stderr, "%lu s, %lu packets, %lu bytes, %lu bytes nobody read\n", millis() / 1000,
+            replay.packets, replay.serial_bytes, dropped_bytes);
+    if (link_path != NULL)
+    {
+        unlink(link_path);
+    }
+    if (packets != NULL)
+    {
+        fclose(packets);
+    }
+    close(slave);
+    close(master);
+    return 0;
+}
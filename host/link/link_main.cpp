@@ -0,0 +1,392 @@
+/***************************************************************
+//   healthypi_link - sustained serial throughput at each baud rate
+//
+//   usage: healthypi_link [options]
+//     --rates <list>   comma separated baud rates to try
+//                      (default 115200 up to 3000000)
+//     --seconds <s>    stream time at each rate, default 5
+//     --period-us <us> time between output passes, default 1000 - the
+//                      output task's one tick sleep when the FIFO is full
+//     --min-line <pc>  least share of the line rate a rate must sustain,
+//                      default 95 percent
+//
+//   The firmware's packet_scheduler and serial_transport run against
+//   the host UART model (HardwareSerial.h), which drains the TX FIFO
+//   at the line rate in virtual time. Their output goes into a Linux
+//   pty; a reader thread on the other side does what a host program
+//   does: opens the port at 115200, asks for the rate with a
+//   CES_CMDIF_TYPE_BAUD frame, sets its side to the rate it is given
+//   and decodes everything that follows with PacketScanner.
+//
+//   Batches are offered as fast as the queue takes them, so the link is
+//   always the bottleneck. For each rate it reports the rate achieved
+//   against the line rate (baud / 10 bytes per second), the frames
+//   dropped and the output passes that found the FIFO full, and checks
+//   that every byte written arrived with no bad CRC and no sequence
+//   gap, and that the rate achieved is at least --min-line of the line
+//   rate. A rate the firmware refuses (it answers with 115200 and keeps
+//   streaming at that) is reported as refused and measured at 115200.
+//   Exits 1 if any rate fails.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "HostShim.h"
+#include "packet_scheduler.h"
+#include "serial_transport.h"
+#include "PacketScanner.h"
+
+#define LINK_START_BAUD 115200
+
+typedef struct link_Reader{
+  int fd;
+  uint32_t baud;
+  std::atomic<bool> done;
+  std::atomic<bool> switched;
+  unsigned long bytes;
+  uint32_t answer;
+  PacketScanner scanner;
+}link_reader;
+
+typedef struct link_Result{
+  uint32_t baud;
+  uint32_t answer;
+  double line_bytes_per_s;
+  double bytes_per_s;
+  unsigned long frames;
+  unsigned long dropped;
+  unsigned long tx_full;
+  unsigned long sent;
+  unsigned long received;
+  uint32_t crc_errors;
+  uint32_t lost;
+  bool ok;
+}link_result;
+
+static int pty_master = -1;
+
+// The master is non-blocking for reads, so wait here when the pty is full
+static void master_sink(const uint8_t *data, size_t len, void *ctx)
+{
+    (void)ctx;
+    while (len > 0)
+    {
+        ssize_t n = write(pty_master, data, len);
+        if (n < 0 && errno == EAGAIN)
+        {
+            struct pollfd p = {pty_master, POLLOUT, 0};
+            poll(&p, 1, 100);
+            continue;
+        }
+        if (n <= 0)
+        {
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static speed_t termios_speed(uint32_t baud)
+{
+    switch (baud)
+    {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 3000000: return B3000000;
+    }
+    return B115200;
+}
+
+static void set_speed(int fd, uint32_t baud)
+{
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, termios_speed(baud));
+    cfsetospeed(&tio, termios_speed(baud));
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+// The host program's side of the pty
+static void reader_thread(link_reader *r)
+{
+    set_speed(r->fd, LINK_START_BAUD);
+    uint8_t request[] = {PACKET_START_1, PACKET_START_2, 4, 0, PACKET_TYPE_BAUD,
+                         (uint8_t)r->baud, (uint8_t)(r->baud >> 8), (uint8_t)(r->baud >> 16),
+                         (uint8_t)(r->baud >> 24), PACKET_STOP_1, PACKET_STOP_2};
+    if (write(r->fd, request, sizeof(request)) != (ssize_t)sizeof(request))
+    {
+        return;
+    }
+
+    uint8_t buffer[4096];
+    for (;;)
+    {
+        struct pollfd p = {r->fd, POLLIN, 0};
+        if (poll(&p, 1, 20) <= 0)
+        {
+            if (r->done)
+            {
+                return;
+            }
+            continue;
+        }
+        ssize_t n = read(r->fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            return;
+        }
+        r->bytes += n;
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (!r->scanner.push(buffer[i]) || r->switched)
+            {
+                continue;
+            }
+            uint32_t answer;
+            if (r->scanner.baud(&answer))
+            {
+                r->answer = answer;
+                set_speed(r->fd, answer);
+                // Count the stream at the new rate from scratch
+                r->scanner.reset();
+                r->switched = true;
+            }
+        }
+    }
+}
+
+static bool open_pty(int *master, int *slave)
+{
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0)
+    {
+        return false;
+    }
+    *slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+    if (*slave < 0)
+    {
+        return false;
+    }
+    set_speed(*master, LINK_START_BAUD);
+    return true;
+}
+
+static void offer_samples(packet_scheduler *scheduler)
+{
+    static uint32_t n = 0;
+    while (scheduler->waiting() < PACKET_QUEUE_SIZE - PACKET_QUEUE_RESERVED - 1)
+    {
+        scheduler->ecg_sample((int16_t)(n * 37), (int16_t)(n * 11), 0);
+        for (int i = 0; i < BATCH_PPG_SAMPLES / BATCH_ECG_SAMPLES; i++)
+        {
+            scheduler->ppg_sample((int32_t)(100000 + n * 3 + i), (int32_t)(80000 + n + i));
+        }
+        n++;
+    }
+}
+
+static bool run_rate(uint32_t baud, double seconds, unsigned long period_us, double min_line,
+                     link_result *result)
+{
+    int slave;
+    if (!open_pty(&pty_master, &slave))
+    {
+        fprintf(stderr, "cannot open a pty\n");
+        return false;
+    }
+    hostReset();
+    hostSetSerialSink(master_sink, NULL);
+
+    packet_scheduler device_scheduler;
+    serial_transport device_transport;
+    packet_scheduler *scheduler = &device_scheduler;
+    serial_transport *transport = &device_transport;
+    scheduler->set_mode(STREAM_MODE_BATCHED);
+    transport->begin(LINK_START_BAUD);
+
+    link_reader *reader = new link_reader();
+    reader->fd = slave;
+    reader->baud = baud;
+    reader->done = false;
+    reader->switched = false;
+    reader->bytes = 0;
+    reader->answer = 0;
+    std::thread thread(reader_thread, reader);
+
+    // Device side - stream, and feed the pty's input to Serial
+    unsigned long start_bytes = 0, start_us = 0, end_us = 0, end_bytes = 0;
+    unsigned long start_dropped = 0, start_full = 0;
+    bool switched = false;
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+    for (;;)
+    {
+        uint8_t in[64];
+        ssize_t n = read(pty_master, in, sizeof(in));
+        if (n > 0)
+        {
+            hostSerialInject(in, n);
+        }
+        if (!switched && transport->baud_changes > 0)
+        {
+            switched = true;
+            start_bytes = transport->bytes_sent;
+            start_dropped = scheduler->dropped();
+            start_full = transport->tx_full;
+            start_us = micros();
+        }
+        if (switched && micros() - start_us >= (unsigned long)(seconds * 1e6))
+        {
+            end_us = micros();
+            end_bytes = transport->bytes_sent;
+            break;
+        }
+        if (!switched && micros() > 5000000UL)
+        {
+            fprintf(stderr, "%lu: no answer to the baud request\n", (unsigned long)baud);
+            break;
+        }
+        offer_samples(scheduler);
+        status_payload link;
+        transport->link_status(&link);
+        scheduler->set_link_status(&link);
+        scheduler->update(millis(), true);
+        transport->service(scheduler);
+        hostAdvanceMicros(period_us);
+        if (!switched)
+        {
+            // Give the reader time to write its request
+            usleep(100);
+        }
+    }
+    // Let the line drain into the pty, then stop the reader
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) & ~O_NONBLOCK);
+    while (scheduler->waiting() > 0)
+    {
+        transport->service(scheduler);
+        hostAdvanceMicros(period_us);
+    }
+    transport->service(scheduler);
+    tcdrain(pty_master);
+    usleep(50000);
+    reader->done = true;
+    thread.join();
+
+    double elapsed = (end_us - start_us) / 1e6;
+    result->baud = baud;
+    result->answer = reader->answer;
+    result->line_bytes_per_s = reader->answer / 10.0;
+    result->bytes_per_s = elapsed > 0 ? (end_bytes - start_bytes) / elapsed : 0;
+    result->frames = transport->frames_sent;
+    result->dropped = scheduler->dropped() - start_dropped;
+    result->tx_full = transport->tx_full - start_full;
+    result->sent = transport->bytes_sent;
+    result->received = reader->bytes;
+    result->crc_errors = reader->scanner.crc_errors;
+    result->lost = reader->scanner.lost_batches;
+    // Every byte written, at either rate, arrived, and the rate given
+    // was kept up
+    result->ok = switched && (reader->answer == baud || reader->answer == LINK_START_BAUD)
+                 && result->crc_errors == 0 && result->lost == 0
+                 && result->dropped == 0 && result->received == result->sent
+                 && result->bytes_per_s >= min_line / 100.0 * result->line_bytes_per_s;
+
+    hostSetSerialSink(NULL, NULL);
+    delete reader;
+    close(slave);
+    close(pty_master);
+    pty_master = -1;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> rates;
+    double seconds = 5;
+    unsigned long period_us = 1000;
+    double min_line = 95;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--rates") == 0 && i + 1 < argc)
+        {
+            char *p = argv[++i];
+            while (*p != 0)
+            {
+                rates.push_back(strtoul(p, &p, 10));
+                if (*p == ',')
+                {
+                    p++;
+                }
+                else if (*p != 0)
+                {
+                    break;
+                }
+            }
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--period-us") == 0 && i + 1 < argc)
+        {
+            period_us = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--min-line") == 0 && i + 1 < argc)
+        {
+            min_line = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--rates r1,r2,...] [--seconds s] [--period-us us] [--min-line percent]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (rates.empty())
+    {
+        const uint32_t defaults[] = {115200, 230400, 460800, 921600, 1000000, 1500000, 2000000, 3000000};
+        rates.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+    }
+    if (period_us == 0)
+    {
+        period_us = 1;
+    }
+
+    bool all_ok = true;
+    printf("%10s %12s %12s %7s %9s %8s %9s %5s %5s  %s\n", "baud", "line B/s", "sent B/s", "% line",
+           "frames", "dropped", "FIFO full", "CRC", "lost", "result");
+    for (size_t i = 0; i < rates.size(); i++)
+    {
+        link_result r;
+        if (!run_rate(rates[i], seconds, period_us, min_line, &r))
+        {
+            return 1;
+        }
+        all_ok = all_ok && r.ok;
+        printf("%10lu %12.0f %12.0f %7.1f %9lu %8lu %9lu %5lu %5lu  %s\n", (unsigned long)r.baud,
+               r.line_bytes_per_s, r.bytes_per_s, 100.0 * r.bytes_per_s / r.line_bytes_per_s,
+               r.frames, r.dropped, r.tx_full, (unsigned long)r.crc_errors, (unsigned long)r.lost,
+               !r.ok ? "FAIL" : r.answer != r.baud ? "refused" : "ok");
+        fflush(stdout);
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/***************************************************************
+//   Finds HealthyPi packets in a serial byte stream
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "PacketScanner.h"
+#include <string.h>
+
+enum
+{
+    SCAN_START_1,
+    SCAN_START_2,
+    SCAN_LEN_LSB,
+    SCAN_LEN_MSB,
+    SCAN_TYPE,
+    SCAN_PAYLOAD,
+    SCAN_STOP_1,
+    SCAN_STOP_2
+};
+
+PacketScanner::PacketScanner()
+{
+    reset();
+}
+
+void PacketScanner::reset()
+{
+    packets = 0;
+    skipped_bytes = 0;
+    crc_errors = 0;
+    lost_batches = 0;
+    memset(&_sequence, 0, sizeof(_sequence));
+    _state = SCAN_START_1;
+    _type = 0;
+    _length = 0;
+    _index = 0;
+}
+
+bool PacketScanner::push(uint8_t c)
+{
+    switch (_state)
+    {
+    case SCAN_START_1:
+        if (c == PACKET_START_1)
+        {
+            _state = SCAN_START_2;
+        }
+        else
+        {
+            skipped_bytes++;
+        }
+        return false;
+
+    case SCAN_START_2:
+        if (c == PACKET_START_2)
+        {
+            _state = SCAN_LEN_LSB;
+        }
+        else
+        {
+            // 0x0A is also a newline in debug text - look again from here
+            skipped_bytes++;
+            _state = (c == PACKET_START_1) ? SCAN_START_2 : SCAN_START_1;
+            if (c != PACKET_START_1)
+            {
+                skipped_bytes++;
+            }
+        }
+        return false;
+
+    case SCAN_LEN_LSB:
+        _length = c;
+        _state = SCAN_LEN_MSB;
+        return false;
+
+    case SCAN_LEN_MSB:
+        _length |= (uint16_t)c << 8;
+        if (_length > PACKET_MAX_PAYLOAD)
+        {
+            skipped_bytes += 4;
+            _state = SCAN_START_1;
+        }
+        else
+        {
+            _state = SCAN_TYPE;
+        }
+        return false;
+
+    case SCAN_TYPE:
+        _type = c;
+        _index = 0;
+        _state = (_length > 0) ? SCAN_PAYLOAD : SCAN_STOP_1;
+        return false;
+
+    case SCAN_PAYLOAD:
+        _payload[_index++] = c;
+        if (_index == _length)
+        {
+            _state = SCAN_STOP_1;
+        }
+        return false;
+
+    case SCAN_STOP_1:
+        if (c == PACKET_STOP_1)
+        {
+            _state = SCAN_STOP_2;
+        }
+        else
+        {
+            skipped_bytes += 5 + _length + 1;
+            _state = (c == PACKET_START_1) ? SCAN_START_2 : SCAN_START_1;
+        }
+        return false;
+
+    case SCAN_STOP_2:
+        if (c == PACKET_STOP_2)
+        {
+            _state = SCAN_START_1;
+            frame_view f = view();
+            if (frame_is_batch(&f))
+            {
+                if (!frame_check_batch(&f, &_sequence))
+                {
+                    crc_errors++;
+                    return false;
+                }
+                lost_batches = _sequence.lost;
+            }
+            packets++;
+            return true;
+        }
+        skipped_bytes += 5 + _length + 2;
+        _state = (c == PACKET_START_1) ? SCAN_START_2 : SCAN_START_1;
+        return false;
+    }
+    _state = SCAN_START_1;
+    return false;
+}
+
+frame_view PacketScanner::view() const
+{
+    frame_view f;
+    f.type = _type;
+    f.length = _length;
+    f.payload = _payload;
+    return f;
+}
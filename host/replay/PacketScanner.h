@@ -0,0 +1,66 @@
+/***************************************************************
+//   Finds HealthyPi packets in a serial byte stream
+//
+//   Packets are 0x0A 0xFA, length LSB, length MSB, type, payload,
+//   0x00 0x0B - see serial_frame.h.
+//   Anything else on the line (debug text from Serial.println) is
+//   skipped and counted, and the scanner resynchronises on the next
+//   start bytes. Batch packets, raw or packed, whose CRC does not match
+//   are dropped and counted, and gaps in their sequence numbers are
+//   counted as lost.
+//
+//   It takes one byte at a time, for a live port; FrameReader
+//   (host/decoder) does the same over whole buffers of a capture. Both
+//   decode with the frame_* functions in HealthyPiFrames.h.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef PacketScanner_h
+#define PacketScanner_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HealthyPiFrames.h"
+
+class PacketScanner
+{
+  public:
+    PacketScanner();
+    void reset();
+    // Feed one byte - true when a complete packet has just been found
+    bool push(uint8_t c);
+
+    uint8_t type() const { return _type; }
+    uint16_t length() const { return _length; }
+    const uint8_t *payload() const { return _payload; }
+    // Decode the last packet if it is of the matching type
+    // vitals() takes data and vitals packets, and batches that carry them
+    bool vitals(healthypi_vitals *out) const { frame_view f = view(); return frame_vitals(&f, out); }
+    bool ecg(healthypi_ecg *out) const { frame_view f = view(); return frame_ecg(&f, out); }
+    bool ppg(healthypi_ppg *out) const { frame_view f = view(); return frame_ppg(&f, out); }
+    bool batch(healthypi_batch *out) const { frame_view f = view(); return frame_batch(&f, out); }
+    bool status(healthypi_status *out) const { frame_view f = view(); return frame_status(&f, out); }
+    // Rate in a CES_CMDIF_TYPE_BAUD packet
+    bool baud(uint32_t *out) const { frame_view f = view(); return frame_baud(&f, out); }
+    // Answer to a command
+    bool ack(healthypi_ack *out) const { frame_view f = view(); return frame_ack(&f, out); }
+    // The last packet, for the frame_* functions
+    frame_view view() const;
+
+    uint32_t packets;
+    uint32_t skipped_bytes;
+    uint32_t crc_errors;
+    uint32_t lost_batches;
+
+  private:
+    uint8_t _state;
+    uint8_t _type;
+    uint16_t _length;
+    uint16_t _index;
+    uint8_t _payload[PACKET_MAX_PAYLOAD];
+    frame_sequence _sequence;
+};
+
+#endif
@@ -0,0 +1,222 @@
+/***************************************************************
+//   Reads recorded sensor data for replay through the sketch
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "Recording.h"
+#include <stdlib.h>
+#include <string.h>
+
+Recording::Recording()
+    : lines(0), bad_lines(0), _file(NULL), _capture(false), _have_last(false),
+      _last_temperature(0), _have_temperature(false),
+      _pending_count(0), _pending_index(0)
+{
+}
+
+Recording::~Recording()
+{
+    close();
+}
+
+bool Recording::open(const char *path, bool capture)
+{
+    close();
+    _file = fopen(path, capture ? "rb" : "r");
+    _capture = capture;
+    _scanner.reset();
+    _have_last = false;
+    _have_temperature = false;
+    _pending_count = 0;
+    _pending_index = 0;
+    lines = 0;
+    bad_lines = 0;
+    return _file != NULL;
+}
+
+void Recording::close()
+{
+    if (_file != NULL)
+    {
+        fclose(_file);
+        _file = NULL;
+    }
+}
+
+bool Recording::next(replay_event *event)
+{
+    if (_file == NULL)
+    {
+        return false;
+    }
+    return _capture ? nextFromCapture(event) : nextSample(event);
+}
+
+bool Recording::nextSample(replay_event *event)
+{
+    char line[256];
+    while (fgets(line, sizeof(line), _file) != NULL)
+    {
+        lines++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+        // Accept commas or white space between fields
+        for (char *p = line; *p; p++)
+        {
+            if (*p == ',')
+            {
+                *p = ' ';
+            }
+        }
+        char type = 0;
+        double a = 0, b = 0, c = 0;
+        int n = sscanf(line, " %c %lf %lf %lf", &type, &a, &b, &c);
+        if (n <= 0)
+        {
+            continue;
+        }
+
+        memset(event, 0, sizeof(*event));
+        event->type = type;
+        if (type == REPLAY_EVENT_ECG && n >= 3)
+        {
+            event->v1 = (long)a;
+            event->v2 = (long)b;
+            event->lead_off = (n >= 4) ? (uint8_t)c : 0;
+            return true;
+        }
+        if (type == REPLAY_EVENT_PPG && n >= 3)
+        {
+            event->v1 = (long)a;
+            event->v2 = (long)b;
+            return true;
+        }
+        if (type == REPLAY_EVENT_TEMP && n >= 2)
+        {
+            event->temperature = a;
+            return true;
+        }
+        bad_lines++;
+    }
+    return false;
+}
+
+bool Recording::nextFromCapture(replay_event *event)
+{
+    while (_pending_index >= _pending_count)
+    {
+        int c = fgetc(_file);
+        if (c == EOF)
+        {
+            return false;
+        }
+        if (!_scanner.push((uint8_t)c))
+        {
+            continue;
+        }
+        _pending_count = 0;
+        _pending_index = 0;
+
+        healthypi_ecg ecg;
+        healthypi_ppg ppg;
+        healthypi_vitals v;
+        if (_scanner.batch(&_batch))
+        {
+            if (_scanner.vitals(&v))
+            {
+                pendingTemperature(v.temperature);
+            }
+            // Interleave the two streams in proportion to their counts
+            int e = 0, p = 0;
+            while (e < _batch.ecg_count || p < _batch.ppg_count)
+            {
+                if (e < _batch.ecg_count && (p >= _batch.ppg_count || e * _batch.ppg_count <= p * _batch.ecg_count))
+                {
+                    pendingEcg(_batch.ecg[e].ecg, _batch.ecg[e].resp, _batch.ecg[e].status);
+                    e++;
+                }
+                else
+                {
+                    pendingPpg(_batch.ppg[p].ir, _batch.ppg[p].red);
+                    p++;
+                }
+            }
+            if (_pending_count == 0)
+            {
+                continue;
+            }
+        }
+        else if (_scanner.ecg(&ecg))
+        {
+            pendingEcg(ecg.ecg, ecg.resp, ecg.status);
+        }
+        else if (_scanner.ppg(&ppg))
+        {
+            pendingPpg(ppg.ir, ppg.red);
+        }
+        else if (_scanner.vitals(&v))
+        {
+            pendingTemperature(v.temperature);
+            // Data packets repeat the last samples until new ones arrive
+            if (_scanner.type() == PACKET_TYPE_DATA)
+            {
+                if (!_have_last || v.ecg != _last.ecg || v.resp != _last.resp)
+                {
+                    // Last byte of the payload is the ADS1292R lead off status
+                    pendingEcg(v.ecg, v.resp, v.status);
+                }
+                if (!_have_last || v.ir != _last.ir || v.red != _last.red)
+                {
+                    pendingPpg(v.ir, v.red);
+                }
+                _last = v;
+                _have_last = true;
+            }
+        }
+        else
+        {
+            continue;
+        }
+        lines++;
+    }
+    *event = _pending[_pending_index++];
+    return true;
+}
+
+void Recording::pendingEcg(int16_t ecg, int16_t resp, uint8_t status)
+{
+    replay_event *e = &_pending[_pending_count++];
+    memset(e, 0, sizeof(*e));
+    e->type = REPLAY_EVENT_ECG;
+    e->v1 = (long)ecg * 256;
+    e->v2 = (long)resp * 256;
+    e->lead_off = status & 0x1f;
+}
+
+void Recording::pendingPpg(int32_t ir, int32_t red)
+{
+    replay_event *e = &_pending[_pending_count++];
+    memset(e, 0, sizeof(*e));
+    e->type = REPLAY_EVENT_PPG;
+    e->v1 = ir;
+    e->v2 = red;
+}
+
+void Recording::pendingTemperature(int16_t temperature)
+{
+    if (_have_temperature && temperature == _last_temperature)
+    {
+        return;
+    }
+    replay_event *e = &_pending[_pending_count++];
+    memset(e, 0, sizeof(*e));
+    e->type = REPLAY_EVENT_TEMP;
+    e->temperature = (temperature - 100) / 100.0;
+    _last_temperature = temperature;
+    _have_temperature = true;
+}
@@ -0,0 +1,82 @@
+/***************************************************************
+//   Reads recorded sensor data for replay through the sketch
+//
+//   Two input formats are accepted.
+//
+//   Sample text - one sample per line, comma or space separated,
+//   '#' starts a comment:
+//     E <raw_ecg> <raw_resp> [lead_off]   ADS1292R, 24 bit codes, 125 SPS
+//     P <ir> <red>                        AFE4490, 22 bit codes, 500 SPS
+//     T <degrees C>                       MLX90614 object temperature
+//
+//   Packet capture - the raw byte stream from the serial port.
+//   ECG, PPG and vitals frames give one event each (vitals only when
+//   the temperature changes), batch frames one per sample they hold. The combined data frame repeats the last
+//   samples until new ones arrive, so repeated values are collapsed: a
+//   new ECG sample is taken when ECG/resp change, a new PPG sample when
+//   IR/RED change. ECG arrives as raw_ecg >> 8 and is scaled back up.
+//
+//   The file is read incrementally so hours of data need little memory.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef Recording_h
+#define Recording_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "PacketScanner.h"
+
+#define REPLAY_EVENT_ECG   'E'
+#define REPLAY_EVENT_PPG   'P'
+#define REPLAY_EVENT_TEMP  'T'
+
+typedef struct replay_Event{
+  char type;
+  long v1;          // raw_ecg, IR
+  long v2;          // raw_resp, RED
+  uint8_t lead_off;
+  double temperature;
+}replay_event;
+
+class Recording
+{
+  public:
+    Recording();
+    ~Recording();
+    // capture selects the packet capture format
+    bool open(const char *path, bool capture);
+    void close();
+    // Next event in file order - false at end of file
+    bool next(replay_event *event);
+
+    // Packet counts of a capture
+    const PacketScanner &scanner() const { return _scanner; }
+
+    uint32_t lines;
+    uint32_t bad_lines;
+
+  private:
+    bool nextSample(replay_event *event);
+    bool nextFromCapture(replay_event *event);
+    void pendingEcg(int16_t ecg, int16_t resp, uint8_t status);
+    void pendingPpg(int32_t ir, int32_t red);
+    void pendingTemperature(int16_t temperature);
+
+    FILE *_file;
+    bool _capture;
+    PacketScanner _scanner;
+    healthypi_vitals _last;
+    bool _have_last;
+    int16_t _last_temperature;
+    bool _have_temperature;
+    healthypi_batch _batch;
+    // Events decoded from one packet not yet handed out
+    replay_event _pending[2 * PACKET_BATCH_MAX_SAMPLES + 1];
+    int _pending_count;
+    int _pending_index;
+};
+
+#endif
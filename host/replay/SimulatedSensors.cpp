@@ -0,0 +1,233 @@
+/***************************************************************
+//   Simulated HealthyPi V4 peripherals for the host build
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "SimulatedSensors.h"
+#include "ADS1292r.h"
+
+// AFE4490 registers the simulation cares about
+#define SIM_AFE_CONTROL0   0x00
+#define SIM_AFE_LED2VAL    0x2a
+#define SIM_AFE_LED1VAL    0x2c
+#define SIM_AFE_LAST_REG   0x30
+
+#define SIM_ADS_ID         0x73    // ADS1292R
+#define SIM_ADS_LOFF_STAT  0x08
+
+#define SIM_MLX_ADDR       0x5A
+#define SIM_MLX_TA         0x06
+#define SIM_MLX_TOBJ1      0x07
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ADS1292R
+
+// Powers up in RDATAC mode, registers at their reset values
+SimADS1292R::SimADS1292R() : frames_read(0), commands(0), index(0), opcode(0), continuous(true)
+{
+    static const uint8_t reset[12] = {SIM_ADS_ID, 0x02, 0x80, 0x10, 0, 0, 0, 0, 0, 0x02, 0x01, 0x0C};
+    memcpy(registers, reset, sizeof(registers));
+    setSample(0, 0, 0);
+}
+
+void SimADS1292R::setSample(long raw_ecg, long raw_resp, uint8_t lead_off)
+{
+    // Status word is 1100 + LOFF_STAT[4:0] + GPIO[1:0] + 13 zeros
+    uint32_t status = 0xC00000 | ((uint32_t)(lead_off & 0x1f) << 15);
+    frame[0] = (uint8_t)(status >> 16);
+    frame[1] = (uint8_t)(status >> 8);
+    frame[2] = (uint8_t)status;
+    frame[3] = (uint8_t)(raw_resp >> 16);
+    frame[4] = (uint8_t)(raw_resp >> 8);
+    frame[5] = (uint8_t)raw_resp;
+    frame[6] = (uint8_t)(raw_ecg >> 16);
+    frame[7] = (uint8_t)(raw_ecg >> 8);
+    frame[8] = (uint8_t)raw_ecg;
+    registers[SIM_ADS_LOFF_STAT] = lead_off & 0x1f;
+}
+
+void SimADS1292R::select(bool selected)
+{
+    if (selected)
+    {
+        index = 0;
+    }
+}
+
+uint8_t SimADS1292R::transfer(uint8_t data, uint8_t data_mode)
+{
+    (void)data_mode;
+    // Data read - dummy bytes clock out the latest conversion
+    if (continuous && data == CONFIG_SPI_MASTER_DUMMY)
+    {
+        uint8_t out = (index < sizeof(frame)) ? frame[index] : 0;
+        index++;
+        if (index == sizeof(frame))
+        {
+            frames_read++;
+        }
+        return out;
+    }
+    // Opcode - register writes follow in the same transaction
+    uint8_t out = 0;
+    if (index == 0)
+    {
+        commands++;
+        opcode = data;
+        if (data == RDATAC)
+        {
+            continuous = true;
+        }
+        else if (data == SDATAC)
+        {
+            continuous = false;
+        }
+    }
+    else if (index >= 2 && !continuous && (opcode & 0xE0) != 0 && (opcode & 0xE0) <= WREG)
+    {
+        // RREG/WREG, then the register count less one, then the data
+        uint8_t address = (uint8_t)((opcode & 0x1f) + index - 2);
+        if (address < sizeof(registers))
+        {
+            if ((opcode & 0xE0) == RREG)
+            {
+                out = registers[address];
+            }
+            else if (address != 0 && address != SIM_ADS_LOFF_STAT)
+            {
+                registers[address] = data;
+            }
+        }
+    }
+    index++;
+    return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// AFE4490
+
+SimAFE4490::SimAFE4490() : reads(0), writes(0), address(0), index(0), shift(0)
+{
+    memset(registers, 0, sizeof(registers));
+}
+
+void SimAFE4490::setSample(long ir, long red)
+{
+    registers[SIM_AFE_LED1VAL] = (uint32_t)ir & 0x3FFFFF;
+    registers[SIM_AFE_LED2VAL] = (uint32_t)red & 0x3FFFFF;
+}
+
+void SimAFE4490::select(bool selected)
+{
+    if (selected)
+    {
+        index = 0;
+        shift = 0;
+    }
+}
+
+uint8_t SimAFE4490::transfer(uint8_t data, uint8_t data_mode)
+{
+    (void)data_mode;
+    if (index == 0)
+    {
+        address = data;
+        index++;
+        return 0;
+    }
+
+    uint8_t out = 0;
+    bool spi_read = (registers[SIM_AFE_CONTROL0] & 0x01) != 0;
+    if (address <= SIM_AFE_LAST_REG && spi_read && address != SIM_AFE_CONTROL0)
+    {
+        out = (uint8_t)(registers[address] >> (8 * (3 - index)));
+    }
+    shift = (shift << 8) | data;
+    index++;
+
+    if (index == 4)
+    {
+        if (spi_read && address != SIM_AFE_CONTROL0)
+        {
+            reads++;
+        }
+        else if (address <= SIM_AFE_LAST_REG)
+        {
+            writes++;
+            // SW_RST clears the configuration but not the sample registers
+            if (address == SIM_AFE_CONTROL0 && (shift & 0x08))
+            {
+                uint32_t led1 = registers[SIM_AFE_LED1VAL];
+                uint32_t led2 = registers[SIM_AFE_LED2VAL];
+                memset(registers, 0, sizeof(registers));
+                registers[SIM_AFE_LED1VAL] = led1;
+                registers[SIM_AFE_LED2VAL] = led2;
+            }
+            else if (address != SIM_AFE_LED1VAL && address != SIM_AFE_LED2VAL)
+            {
+                registers[address] = shift & 0xFFFFFF;
+            }
+        }
+        index = 0;
+        shift = 0;
+    }
+    return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MLX90614
+
+// SMBus PEC - CRC-8, polynomial x^8 + x^2 + x + 1
+static uint8_t sim_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+SimMLX90614::SimMLX90614() : reg(0)
+{
+    setTemperature(36.6);
+    ambient_raw = (uint16_t)((25.0 + 273.15) / 0.02);
+}
+
+void SimMLX90614::setTemperature(double celsius)
+{
+    object_raw = (uint16_t)((celsius + 273.15) / 0.02 + 0.5);
+}
+
+void SimMLX90614::receive(const uint8_t *data, size_t len)
+{
+    if (len > 0)
+    {
+        reg = data[0];
+    }
+}
+
+size_t SimMLX90614::request(uint8_t *data, size_t len)
+{
+    uint16_t value = 0;
+    if (reg == SIM_MLX_TOBJ1)
+    {
+        value = object_raw;
+    }
+    else if (reg == SIM_MLX_TA)
+    {
+        value = ambient_raw;
+    }
+    uint8_t pec_data[5] = {SIM_MLX_ADDR << 1, reg, (SIM_MLX_ADDR << 1) | 1,
+                           (uint8_t)value, (uint8_t)(value >> 8)};
+    uint8_t reply[3] = {pec_data[3], pec_data[4], sim_crc8(pec_data, 5)};
+    size_t n = (len < sizeof(reply)) ? len : sizeof(reply);
+    memcpy(data, reply, n);
+    return n;
+}
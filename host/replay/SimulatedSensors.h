@@ -0,0 +1,81 @@
+/***************************************************************
+//   Simulated HealthyPi V4 peripherals for the host build
+//
+//   Each class answers the SPI or I2C traffic the real driver code
+//   generates, returning whatever sample the replay engine last
+//   loaded. They do not model register side effects beyond what
+//   ADS1292r.cpp, myAFE4490_Oximeter.cpp and MLX90614.cpp rely on.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef SimulatedSensors_h
+#define SimulatedSensors_h
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+
+// ADS1292R ECG/respiration front end
+// In RDATAC mode every read returns 3 status bytes then
+// channel 1 (respiration) and channel 2 (ECG), 24 bits MSB first.
+// Out of it, RREG and WREG read and write the 12 registers
+class SimADS1292R : public HostSPIDevice
+{
+  public:
+    SimADS1292R();
+    // 24 bit ADC codes and LOFF_STAT bits 0-4 (0 = all leads on)
+    void setSample(long raw_ecg, long raw_resp, uint8_t lead_off);
+    void select(bool selected);
+    uint8_t transfer(uint8_t data, uint8_t data_mode);
+
+    uint32_t frames_read;
+    uint32_t commands;
+
+  private:
+    uint8_t frame[9];
+    uint8_t registers[12];
+    uint8_t index;
+    uint8_t opcode;
+    bool continuous;
+};
+
+// AFE4490 pulse oximeter front end
+// Each transaction is an address byte then 24 bits of data.
+// LED1VAL holds IR and LED2VAL holds RED, 22 bit 2s complement
+class SimAFE4490 : public HostSPIDevice
+{
+  public:
+    SimAFE4490();
+    void setSample(long ir, long red);
+    void select(bool selected);
+    uint8_t transfer(uint8_t data, uint8_t data_mode);
+
+    uint32_t reads;
+    uint32_t writes;
+
+  private:
+    uint32_t registers[0x31];
+    uint8_t address;
+    uint8_t index;
+    uint32_t shift;
+};
+
+// MLX90614 IR thermometer on I2C
+// Register reads return the 16 bit value (0.02 K/LSB) and a PEC byte
+class SimMLX90614 : public HostI2CDevice
+{
+  public:
+    SimMLX90614();
+    void setTemperature(double celsius);
+    void receive(const uint8_t *data, size_t len);
+    size_t request(uint8_t *data, size_t len);
+
+  private:
+    uint16_t object_raw;
+    uint16_t ambient_raw;
+    uint8_t reg;
+};
+
+#endif
@@ -0,0 +1,198 @@
+/***************************************************************
+//   Drives the sketch's setup() and loop() from recorded samples
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "SketchReplay.h"
+#include <HostShim.h>
+#include <unistd.h>
+#include "sensor_acquisition.h"
+#include "pipeline_tasks.h"
+#include "packet_scheduler.h"
+
+#define REPLAY_MLX90614_ADDR 0x5A
+
+// Samples the processing task may fall behind by in threaded mode -
+// small enough that one pass cannot fill the packet queue
+#define REPLAY_THREADED_ECG_BACKLOG 4
+#define REPLAY_THREADED_PPG_BACKLOG 16
+
+// From the sketch (host/sketch.cpp)
+void setup();
+void loop();
+extern bool pipeline_tasks_enabled;
+extern sensor_acquisition acquisition;
+extern packet_scheduler scheduler;
+
+SketchReplay::SketchReplay()
+    : loop_passes(0), ecg_samples(0), ppg_samples(0), packets(0), serial_bytes(0), skipped_bytes(0),
+      crc_errors(0), lost_batches(0),
+      _loop_period_us(0), _last_loop_us(0), _threaded(false), _callback(NULL), _callback_ctx(NULL),
+      _serial(NULL), _serial_ctx(NULL), _capture(NULL)
+{
+}
+
+void SketchReplay::onPacket(ReplayPacketCallback callback, void *ctx)
+{
+    _callback = callback;
+    _callback_ctx = ctx;
+}
+
+void SketchReplay::onSerial(ReplaySerialCallback callback, void *ctx)
+{
+    _serial = callback;
+    _serial_ctx = ctx;
+}
+
+void SketchReplay::captureTo(FILE *file)
+{
+    _capture = file;
+}
+
+void SketchReplay::setThreaded(bool threaded)
+{
+    _threaded = threaded;
+}
+
+void SketchReplay::begin()
+{
+    hostReset();
+    SPI.hostAttach(REPLAY_ADS1292_CS_PIN, &_ads);
+    SPI.hostAttach(REPLAY_AFE4490_CS_PIN, &_afe);
+    Wire.hostAttach(REPLAY_MLX90614_ADDR, &_mlx);
+    hostSetSerialSink(serialSink, this);
+    _scanner.reset();
+
+    pipeline_tasks_enabled = _threaded;
+    setup();
+
+    // Data ready lines idle high until the first conversion
+    hostSetPin(REPLAY_ADS1292_DRDY_PIN, HIGH);
+    hostSetPin(REPLAY_AFE4490_DRDY_PIN, LOW);
+    hostSetMicros(0);
+    loop_passes = 0;
+    ecg_samples = 0;
+    ppg_samples = 0;
+    packets = 0;
+    serial_bytes = 0;
+    _last_loop_us = 0;
+}
+
+void SketchReplay::setLoopPeriod(unsigned long period_us)
+{
+    _loop_period_us = period_us;
+}
+
+void SketchReplay::feed(const replay_event *event)
+{
+    switch (event->type)
+    {
+    case REPLAY_EVENT_ECG:
+        _ads.setSample(event->v1, event->v2, event->lead_off);
+        ecg_samples++;
+        hostSetMicros(sampleTime());
+        // DRDY pulses low when a conversion is ready
+        hostSetPin(REPLAY_ADS1292_DRDY_PIN, LOW);
+        hostSetPin(REPLAY_ADS1292_DRDY_PIN, HIGH);
+        break;
+
+    case REPLAY_EVENT_PPG:
+        _afe.setSample(event->v1, event->v2);
+        ppg_samples++;
+        hostSetMicros(sampleTime());
+        hostSetPin(REPLAY_AFE4490_DRDY_PIN, HIGH);
+        hostSetPin(REPLAY_AFE4490_DRDY_PIN, LOW);
+        if (_threaded)
+        {
+            waitForPipeline(REPLAY_THREADED_ECG_BACKLOG, REPLAY_THREADED_PPG_BACKLOG);
+        }
+        else if (sampleTime() - _last_loop_us >= _loop_period_us)
+        {
+            runLoop();
+        }
+        break;
+
+    case REPLAY_EVENT_TEMP:
+        _mlx.setTemperature(event->temperature);
+        break;
+    }
+}
+
+void SketchReplay::finish()
+{
+    if (_threaded)
+    {
+        waitForPipeline(0, 0);
+        // Let the tasks finish with the last samples, then run the
+        // stages once more from here for anything they left queued
+        usleep(10000);
+        pipeline_task_stop_all();
+        pipeline_tasks_enabled = false;
+    }
+    runLoop();
+}
+
+// Hold the sensors back until the processing and output tasks catch up
+// (on the board the samples come no faster than they can be sent)
+// Once the UART FIFO is full the line is what holds the frames up, as
+// on the board, so the sensors carry on
+void SketchReplay::waitForPipeline(uint32_t ecg_limit, uint32_t ppg_limit)
+{
+    uint32_t packet_limit = ppg_limit > 0 ? PACKET_QUEUE_SIZE / 2 : 0;
+    while (acquisition.ecg_waiting() > ecg_limit || acquisition.ppg_waiting() > ppg_limit
+           || (scheduler.waiting() > packet_limit && Serial.availableForWrite() > 0))
+    {
+        usleep(100);
+    }
+}
+
+// Clock follows whichever stream is further ahead
+unsigned long SketchReplay::sampleTime() const
+{
+    unsigned long long ecg_time = (unsigned long long)ecg_samples * REPLAY_ECG_PERIOD_US;
+    unsigned long long ppg_time = (unsigned long long)ppg_samples * REPLAY_PPG_PERIOD_US;
+    return (unsigned long)(ecg_time > ppg_time ? ecg_time : ppg_time);
+}
+
+void SketchReplay::runLoop()
+{
+    hostSetMicros(sampleTime());
+    loop();
+    loop_passes++;
+    _last_loop_us = sampleTime();
+}
+
+void SketchReplay::serialSink(const uint8_t *data, size_t len, void *ctx)
+{
+    SketchReplay *replay = (SketchReplay *)ctx;
+    replay->serial_bytes += len;
+    if (replay->_capture != NULL)
+    {
+        fwrite(data, 1, len, replay->_capture);
+    }
+    if (replay->_serial != NULL)
+    {
+        replay->_serial(data, len, replay->_serial_ctx);
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!replay->_scanner.push(data[i]))
+        {
+            continue;
+        }
+        replay->packets++;
+        healthypi_vitals vitals;
+        if (replay->_scanner.vitals(&vitals))
+        {
+            if (replay->_callback != NULL)
+            {
+                replay->_callback(millis(), &vitals, replay->_callback_ctx);
+            }
+        }
+    }
+    replay->skipped_bytes = replay->_scanner.skipped_bytes;
+    replay->crc_errors = replay->_scanner.crc_errors;
+    replay->lost_batches = replay->_scanner.lost_batches;
+}
@@ -0,0 +1,101 @@
+/***************************************************************
+//   Drives the sketch's setup() and loop() from recorded samples
+//
+//   The simulated ADS1292R, AFE4490 and MLX90614 are attached to the
+//   host SPI/I2C buses, so every recorded sample goes through the same
+//   driver reads, decimation, SpO2/HR estimation and packet framing as
+//   on the board. Everything the sketch writes to Serial is scanned
+//   for packets and handed back to the caller.
+//
+//   Timing: the AFE4490 (500 SPS) and ADS1292R (125 SPS) data ready
+//   interrupts are raised for each sample, and sensor_acquisition reads
+//   it into its ring buffer. loop() is run after every AFE4490 sample,
+//   or at most once per setLoopPeriod() to mimic a loop held up by the
+//   serial port or I2C. The virtual clock follows the sample count, so
+//   millis() matches the recording, but no time passes on the host -
+//   replay runs as fast as the CPU allows.
+//
+//   With setThreaded() the sketch starts its pipeline tasks as on the
+//   board (pthreads here) and loop() is never run; feed() only raises
+//   the interrupts, holding back while the processing or output task
+//   has more than a few samples or half the packet queue to catch up on. Packet timing then
+//   depends on the host scheduler, so the output is not repeatable
+//   from run to run.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef SketchReplay_h
+#define SketchReplay_h
+
+#include <stdio.h>
+#include "SimulatedSensors.h"
+#include "PacketScanner.h"
+#include "Recording.h"
+
+// Pins from HealthyPiCAACSerialOnly.ino - keep in step with the sketch
+#define REPLAY_ADS1292_DRDY_PIN 26
+#define REPLAY_ADS1292_CS_PIN   13
+#define REPLAY_AFE4490_CS_PIN   21
+#define REPLAY_AFE4490_DRDY_PIN 39
+
+#define REPLAY_ECG_PERIOD_US    8000    // 125 SPS
+#define REPLAY_PPG_PERIOD_US    2000    // 500 SPS
+
+// Called for every data or vitals packet the sketch sends
+typedef void (*ReplayPacketCallback)(unsigned long t_ms, const healthypi_vitals *vitals, void *ctx);
+// Called with every byte the sketch writes to Serial
+typedef void (*ReplaySerialCallback)(const uint8_t *data, size_t len, void *ctx);
+
+class SketchReplay
+{
+  public:
+    SketchReplay();
+    // Run the sketch's pipeline tasks on threads - call before begin()
+    void setThreaded(bool threaded);
+    // Reset the shim, attach the simulated sensors and run setup()
+    void begin();
+    // Load one recorded sample, running loop() as the timing requires
+    void feed(const replay_event *event);
+    // Run a last pass for samples still waiting in the rings
+    // (threaded: wait for the tasks to catch up, then stop them)
+    void finish();
+    // Run loop() no more often than this, 0 for every AFE4490 sample
+    void setLoopPeriod(unsigned long period_us);
+
+    void onPacket(ReplayPacketCallback callback, void *ctx);
+    void onSerial(ReplaySerialCallback callback, void *ctx);
+    // Copy everything written to Serial to a file
+    void captureTo(FILE *file);
+
+    unsigned long loop_passes;
+    unsigned long ecg_samples;
+    unsigned long ppg_samples;
+    unsigned long packets;
+    unsigned long serial_bytes;
+    unsigned long skipped_bytes;
+    unsigned long crc_errors;
+    unsigned long lost_batches;
+
+  private:
+    static void serialSink(const uint8_t *data, size_t len, void *ctx);
+    void runLoop();
+    void waitForPipeline(uint32_t ecg_limit, uint32_t ppg_limit);
+    unsigned long sampleTime() const;
+
+    SimADS1292R _ads;
+    SimAFE4490 _afe;
+    SimMLX90614 _mlx;
+    PacketScanner _scanner;
+    unsigned long _loop_period_us;
+    unsigned long _last_loop_us;
+    bool _threaded;
+    ReplayPacketCallback _callback;
+    void *_callback_ctx;
+    ReplaySerialCallback _serial;
+    void *_serial_ctx;
+    FILE *_capture;
+};
+
+#endif
@@ -0,0 +1,234 @@
+/***************************************************************
+//   healthypi_replay - run recorded sensor data through the sketch
+//
+//   usage: healthypi_replay [options] <recording>
+//     --capture        recording is a raw serial packet capture
+//                      (default: sample text, see Recording.h)
+//     -o <file>        write vitals as CSV (default stdout)
+//     --packets <file> write the serial stream the sketch produced
+//     --all            one CSV row per packet rather than per change
+//     --loop-period <ms>  run loop() at most this often, as if it were
+//                      held up - sensor reads still happen on time
+//     --threads        run the sketch's pipeline tasks on threads
+//                      instead of loop() (output varies run to run)
+//     --stream-mode <n>  serial stream mode, STREAM_MODE_* in
+//                      packet_scheduler.h (default: the sketch's)
+//     --coder <n>      sample coder for the compressed stream,
+//                      SAMPLE_CODER_* in sample_codec.h
+//     --baud <rate>    ask the sketch for this serial rate, as a host
+//                      would, once setup() is done (default 115200)
+//
+//   CSV columns: t_ms,heart_rate,spo2,resp_rate,temperature_c
+//   A summary with the replay speed and the sensor_acquisition counters
+//   is printed to stderr.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "SketchReplay.h"
+#include "sensor_acquisition.h"
+#include "packet_scheduler.h"
+#include "serial_transport.h"
+#include "HostShim.h"
+
+// From the sketch (host/sketch.cpp)
+extern sensor_acquisition acquisition;
+extern packet_scheduler scheduler;
+extern serial_transport transport;
+
+typedef struct replay_Output{
+  FILE *file;
+  bool all_packets;
+  bool have_last;
+  healthypi_vitals last;
+  unsigned long rows;
+}replay_output;
+
+static void write_vitals(unsigned long t_ms, const healthypi_vitals *v, void *ctx)
+{
+    replay_output *out = (replay_output *)ctx;
+    if (!out->all_packets && out->have_last &&
+        v->heart_rate == out->last.heart_rate &&
+        v->spo2 == out->last.spo2 &&
+        v->resp_rate == out->last.resp_rate &&
+        v->temperature == out->last.temperature)
+    {
+        return;
+    }
+    fprintf(out->file, "%lu,%u,%u,%u,%.2f\n", t_ms, v->heart_rate, v->spo2,
+            v->resp_rate, (v->temperature - 100) / 100.0);
+    out->last = *v;
+    out->have_last = true;
+    out->rows++;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--capture] [-o vitals.csv] [--packets stream.bin] [--all] [--loop-period ms] [--threads] [--stream-mode n] [--coder n] [--baud rate] <recording>\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *input = NULL;
+    const char *csv_path = NULL;
+    const char *packets_path = NULL;
+    bool capture = false;
+    bool all_packets = false;
+    bool threaded = false;
+    double loop_period_ms = 0;
+    int stream_mode = -1;
+    int coder = -1;
+    unsigned long baud = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--capture") == 0)
+        {
+            capture = true;
+        }
+        else if (strcmp(argv[i], "--all") == 0)
+        {
+            all_packets = true;
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            threaded = true;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            csv_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--loop-period") == 0 && i + 1 < argc)
+        {
+            loop_period_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stream-mode") == 0 && i + 1 < argc)
+        {
+            stream_mode = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+        {
+            baud = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--coder") == 0 && i + 1 < argc)
+        {
+            coder = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc)
+        {
+            packets_path = argv[++i];
+        }
+        else if (argv[i][0] != '-' && input == NULL)
+        {
+            input = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (input == NULL)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Recording recording;
+    if (!recording.open(input, capture))
+    {
+        fprintf(stderr, "cannot open %s\n", input);
+        return 1;
+    }
+
+    replay_output out;
+    memset(&out, 0, sizeof(out));
+    out.file = stdout;
+    out.all_packets = all_packets;
+    if (csv_path != NULL && (out.file = fopen(csv_path, "w")) == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", csv_path);
+        return 1;
+    }
+    FILE *packets = NULL;
+    if (packets_path != NULL && (packets = fopen(packets_path, "wb")) == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", packets_path);
+        return 1;
+    }
+
+    SketchReplay replay;
+    replay.setThreaded(threaded);
+    replay.begin();
+    if (stream_mode >= 0)
+    {
+        scheduler.set_mode((uint8_t)stream_mode);
+    }
+    if (coder >= 0)
+    {
+        scheduler.set_coder((uint8_t)coder);
+    }
+    if (baud != 0)
+    {
+        uint8_t request[] = {PACKET_START_1, PACKET_START_2, 4, 0, PACKET_TYPE_BAUD,
+                             (uint8_t)baud, (uint8_t)(baud >> 8), (uint8_t)(baud >> 16), (uint8_t)(baud >> 24),
+                             PACKET_STOP_1, PACKET_STOP_2};
+        hostSerialInject(request, sizeof(request));
+    }
+    replay.setLoopPeriod((unsigned long)(loop_period_ms * 1000.0));
+    // Start of the replay proper - setup() chatter is not captured
+    replay.captureTo(packets);
+    replay.onPacket(write_vitals, &out);
+    fprintf(out.file, "t_ms,heart_rate,spo2,resp_rate,temperature_c\n");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    replay_event event;
+    while (recording.next(&event))
+    {
+        replay.feed(&event);
+    }
+    replay.finish();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double recorded = millis() / 1000.0;
+    fprintf(stderr, "ecg samples %lu, ppg samples %lu, loop passes %lu, packets %lu, rows %lu\n",
+            replay.ecg_samples, replay.ppg_samples, replay.loop_passes, replay.packets, out.rows);
+    fprintf(stderr, "acquired ecg %lu, ppg %lu frames, overruns ecg %lu, ppg %lu\n",
+            (unsigned long)acquisition.ecg_frames(), (unsigned long)acquisition.ppg_frames(),
+            (unsigned long)acquisition.ecg_overruns(), (unsigned long)acquisition.ppg_overruns());
+    fprintf(stderr, "serial %lu bytes (%.0f bytes/s), frames queued %lu, dropped %lu\n",
+            replay.serial_bytes, recorded > 0 ? replay.serial_bytes / recorded : 0.0,
+            (unsigned long)scheduler.frames(), (unsigned long)scheduler.dropped());
+    fprintf(stderr, "uart %lu baud, %lu rate changes, TX FIFO full on %lu output passes\n",
+            transport.baud(), (unsigned long)transport.baud_changes, (unsigned long)transport.tx_full);
+    if (replay.crc_errors > 0 || replay.lost_batches > 0)
+    {
+        fprintf(stderr, "batches with bad CRC %lu, lost %lu\n", replay.crc_errors, replay.lost_batches);
+    }
+    if (capture && (recording.scanner().crc_errors > 0 || recording.scanner().lost_batches > 0))
+    {
+        fprintf(stderr, "capture batches with bad CRC %lu, lost %lu\n",
+                (unsigned long)recording.scanner().crc_errors, (unsigned long)recording.scanner().lost_batches);
+    }
+    if (recording.bad_lines > 0)
+    {
+        fprintf(stderr, "skipped %lu unreadable lines\n", (unsigned long)recording.bad_lines);
+    }
+    fprintf(stderr, "replayed %.1f s of data in %.3f s (%.0fx real time)\n",
+            recorded, wall, wall > 0 ? recorded / wall : 0.0);
+
+    if (out.file != stdout)
+    {
+        fclose(out.file);
+    }
+    if (packets != NULL)
+    {
+        fclose(packets);
+    }
+    return 0;
+}
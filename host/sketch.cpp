@@ -0,0 +1,34 @@
+/***************************************************************
+//   Host (Linux) build of the HealthyPi sketch
+//
+//   The Arduino builder joins the .ino tabs into one translation unit
+//   (main tab first, the rest in alphabetical order) and generates
+//   prototypes for the functions they define. Do the same here so
+//   setup() and loop() run unchanged against the host shim.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include <Arduino.h>
+#include "ADS1292r.h"
+#include "myAFE4490_Oximeter.h"
+#include "serial_frame.h"
+
+// Prototypes the Arduino builder would generate
+void setup();
+void loop();
+void push_button_intr_handler();
+void slideswitch_intr_handler();
+bool dsp_step();
+bool output_step();
+bool temperature_step();
+void printPacket(const data_frame *frame);
+void printOximeterVariables(afe44xx_data *data);
+void printECGVariables(ads1292r_data *data);
+void printspO2variables(afe44xx_Internal *data);
+void print_buffer(uint16_t buffer[]);
+void print_locations_buffer(uint16_t buffer[]);
+
+#include "../HealthyPiCAACSerialOnly.ino"
+#include "../JSerialRoutines.ino"
@@ -29,6 +29,34 @@ void IRAM_ATTR afe4490_interrupt_handler(void)
 // Instance of O2 calculation algorithm in oximeter_algorithm.h
 spo2_algorithm Spo2;
 
+// Anti-alias filter for the 500 -> 25 SPS decimation
+// 240 tap Hamming windowed sinc, cut off 9 Hz at 500 SPS, Q15 with unity DC gain
+// Flat to within 0.11 dB up to 6 Hz, -54.7 dB or less from 12.5 Hz (output Nyquist) up,
+// the worst at 21.7 Hz
+// Delay 119.5 input samples = 0.24 sec
+const int16_t PPG_DecimatorCoeffs[PPG_DECIMATOR_TAPS] = {
+      6,     5,     5,     4,     4,     3,     2,     1,     0,    -1,    -2,    -3,
+     -4,    -5,    -7,    -8,    -9,   -11,   -12,   -13,   -14,   -16,   -17,   -17,
+    -18,   -19,   -19,   -19,   -18,   -17,   -16,   -15,   -13,   -10,    -7,    -4,
+     -1,     3,     8,    12,    17,    22,    28,    33,    38,    43,    48,    53,
+     57,    61,    64,    66,    67,    68,    68,    66,    64,    60,    55,    49,
+     41,    32,    22,    11,    -1,   -14,   -28,   -42,   -57,   -73,   -88,  -104,
+   -119,  -134,  -148,  -160,  -172,  -181,  -189,  -195,  -198,  -199,  -197,  -192,
+   -184,  -172,  -157,  -138,  -115,   -89,   -60,   -26,    11,    51,    94,   140,
+    189,   241,   294,   349,   406,   463,   522,   580,   638,   695,   751,   805,
+    857,   906,   953,   996,  1035,  1070,  1101,  1127,  1148,  1164,  1175,  1184,
+   1184,  1175,  1164,  1148,  1127,  1101,  1070,  1035,   996,   953,   906,   857,
+    805,   751,   695,   638,   580,   522,   463,   406,   349,   294,   241,   189,
+    140,    94,    51,    11,   -26,   -60,   -89,  -115,  -138,  -157,  -172,  -184,
+   -192,  -197,  -199,  -198,  -195,  -189,  -181,  -172,  -160,  -148,  -134,  -119,
+   -104,   -88,   -73,   -57,   -42,   -28,   -14,    -1,    11,    22,    32,    41,
+     49,    55,    60,    64,    66,    68,    68,    67,    66,    64,    61,    57,
+     53,    48,    43,    38,    33,    28,    22,    17,    12,     8,     3,    -1,
+     -4,    -7,   -10,   -13,   -15,   -16,   -17,   -18,   -19,   -19,   -19,   -18,
+    -17,   -17,   -16,   -14,   -13,   -12,   -11,    -9,    -8,    -7,    -5,    -4,
+     -3,    -2,    -1,     0,     1,     2,     3,     4,     4,     5,     5,     6
+};
+
 
  // Constructor 
 AFE4490 :: AFE4490()
@@ -36,15 +64,18 @@ AFE4490 :: AFE4490()
     // Initialize struct to hold internal data to pass to spO2/resp/HR routine
     internal_data.n_spo2 = 10;
     internal_data.n_heart_rate = 10;
-    internal_data.n_resp_rate = 10;
-    internal_data.buffer_length = BUFFER_LENGTH;
+    internal_data.n_resp_rate = 0;
+    internal_data.buffer_length = dec_buffer_length;
     internal_data.ch_spo2_valid = false;
     internal_data.ch_hr_valid = false;
     internal_data.ch_resp_valid = false;
     internal_data.test1 = 0;   
     internal_data.test2 = 0;     
-    dec = 0;
     dec_buffer_count = 0;
+    ir_decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE);
+    red_decimator.init(PPG_DecimatorCoeffs, PPG_DECIMATOR_TAPS, DECIMATE);
+    pulse_spectrum.init(500.0 / DECIMATE, 1, PULSE_SPECTRUM_LENGTH, PULSE_SPECTRUM_LO_HZ, PULSE_SPECTRUM_HI_HZ);
+    pulse_rate = 0;
     afe4490_intr_flag = false;
     
 }
@@ -59,8 +90,9 @@ AFE4490 :: AFE4490()
  */ 
 bool AFE4490 :: get_AFE4490_data_if_available  (afe44xx_data *afe44xx_raw_data,const int chip_select)
 {
-    if (afe4490_intr_flag = true)
+    if (afe4490_intr_flag)
     {
+        afe4490_intr_flag = false;
 
         // Enable SPI READ (Disabled on reset)
         afe44xxWrite(CONTROL0, 0x000001,chip_select);
@@ -74,55 +106,7 @@ bool AFE4490 :: get_AFE4490_data_if_available  (afe44xx_data *afe44xx_raw_data,c
         afe44xxWrite(CONTROL0, 0x000001,chip_select);  
         REDtemp = afe44xxRead(LED2VAL,chip_select);
         
-        // Discard top 10 bits (22 bits only from ADC)
-        // get a smoother display if we read at 500SPS
-        IRtemp = (long) (IRtemp << 10);
-        IRtemp = (long) (IRtemp >> 10);
-        afe44xx_raw_data->IR_data = (signed long) (IRtemp);
-        
-        REDtemp = (long) (REDtemp << 10);
-        REDtemp = (long) (REDtemp >> 10);  
-        afe44xx_raw_data->RED_data = (signed long) (REDtemp);
-        
-        // decimate data 
-        // if dec = 10 and sample rate is 500 samples/sec
-        // aun buffers will be updated at 50 samples/sec
-        // Hence 256 samples is approx 5 sec worth  
-        if (dec == DECIMATE)
-          {
-              // Decimate and truncate to 16 bits
-              aun_ir_buffer[dec_buffer_count] = (uint16_t) ((afe44xx_raw_data->IR_data) >> 5);  // ? should this be >>6 22 bits to 16 
-              aun_red_buffer[dec_buffer_count] = (uint16_t) ((afe44xx_raw_data->RED_data) >> 5);
-              dec_buffer_count++;
-              dec = 0;
-          }
-        
-        dec++;
-         
-        // When Buffer has approx 5 seconds of data 
-        //dec_buffer_count = 130;
-        if (dec_buffer_count > BUFFER_LENGTH-1)
-        {
-            // Call Routine to estimate spO2 and heart rate 
-            // Pass to routine:
-            // Note passing arrays dont pass address 
-            // Passing struct - pass address  
-            Spo2.estimate_spo2(aun_ir_buffer, aun_red_buffer, &internal_data);
-            dec_buffer_count = 0;
-            afe44xx_raw_data->spO2_data_ready = internal_data.spO2_calc_done;
-            internal_data.spO2_calc_done = false; 
-        }
-        
-        // move data into the struct afe44xx_raw_data
-        afe44xx_raw_data->spo2 = internal_data.n_spo2;
-        afe44xx_raw_data->heart_rate = internal_data.n_heart_rate;
-        // Debugging stuff
-        afe44xx_raw_data->test1 = internal_data.test1;
-        afe44xx_raw_data->test2 = internal_data.test2;
-        afe44xx_raw_data->test3 = internal_data.test3; 
-        //internal_data.testbuffer[30] = 44444;               
-        afe4490_intr_flag = false;
-        return true; 
+        return process_AFE4490_sample(IRtemp, REDtemp, afe44xx_raw_data);
     }
     else
     {
@@ -130,38 +114,104 @@ bool AFE4490 :: get_AFE4490_data_if_available  (afe44xx_data *afe44xx_raw_data,c
     }
 }
 
-// Set up AFE4490
-bool AFE4490 :: afe44xxInit (const int chip_select,const int power_down_pin)
+/**
+ * Process one raw LED1VAL (IR) / LED2VAL (RED) pair
+ * read by get_AFE4490_data_if_available or sensor_acquisition
+ */ 
+bool AFE4490 :: process_AFE4490_sample (unsigned long ir_raw, unsigned long red_raw, afe44xx_data *afe44xx_raw_data)
 {
-  // In fact this is a power down pin 
-  // (Original code was calling it a reset)
-  digitalWrite(power_down_pin, LOW);
-  // Power down when pin low - chip enable
-  digitalWrite(power_down_pin, HIGH);
-  
-  // Software reset pulse to CONTROL0
-  // D3 High resets all internal registers 
-  // D3 then self clears to 0
-  afe44xxWrite(CONTROL0, 0x000000,chip_select);
-  afe44xxWrite(CONTROL0, 0x000008,chip_select);
-  delay(50);
+    // Discard top 10 bits (22 bits only from ADC)
+    // Sign extend through a 32 bit int - a long is wider off the ESP32
+    afe44xx_raw_data->IR_data = (signed long) ((int32_t)((uint32_t)ir_raw << 10) >> 10);
+    afe44xx_raw_data->RED_data = (signed long) ((int32_t)((uint32_t)red_raw << 10) >> 10);
+    
+    // Filter and decimate 500 -> 25 samples/sec
+    // 128 samples is approx 5 sec worth
+    int32_t IR_decimated, RED_decimated;
+    bool ir_ready = ir_decimator.push((int32_t)afe44xx_raw_data->IR_data, &IR_decimated);
+    bool red_ready = red_decimator.push((int32_t)afe44xx_raw_data->RED_data, &RED_decimated);
+    if (ir_ready && red_ready)
+      {
+          // Truncate to 16 bits
+          aun_ir_buffer[dec_buffer_count] = (uint16_t) (IR_decimated >> 5);  // ? should this be >>6 22 bits to 16 
+          aun_red_buffer[dec_buffer_count] = (uint16_t) (RED_decimated >> 5);
+#if SPO2_STREAMING
+          if (beat_estimator.push(aun_ir_buffer[dec_buffer_count], aun_red_buffer[dec_buffer_count]))
+          {
+              internal_data.n_spo2 = beat_estimator.spo2;
+              internal_data.n_heart_rate = beat_estimator.heart_rate;
+              internal_data.ch_spo2_valid = beat_estimator.spo2_valid;
+              internal_data.ch_hr_valid = beat_estimator.hr_valid;
+              internal_data.sample_max = beat_estimator.sample_max;
+              internal_data.sample_min = beat_estimator.sample_min;
+              internal_data.threshold = beat_estimator.threshold;
+              afe44xx_raw_data->spO2_data_ready = true;
+          }
+#endif
+          if (resp_estimator.push(IR_decimated, internal_data.ch_hr_valid ? internal_data.n_heart_rate : 0))
+          {
+              internal_data.n_resp_rate = resp_estimator.rate;
+              internal_data.ch_resp_valid = resp_estimator.valid;
+          }
+          pulse_spectrum.push(IR_decimated);
+          pulse_rate = pulse_spectrum.rate(PULSE_SPECTRUM_MIN_SHARE, PULSE_SPECTRUM_MIN_AMPLITUDE);
+          dec_buffer_count++;
+      }
+     
+    // When Buffer has approx 5 seconds of data 
+    //dec_buffer_count = 130;
+    if (dec_buffer_count > dec_buffer_length-1)
+    {
+#if !SPO2_STREAMING
+        // Call Routine to estimate spO2 and heart rate 
+        // Pass to routine:
+        // Note passing arrays dont pass address 
+        // Passing struct - pass address  
+        Spo2.estimate_spo2(aun_ir_buffer, aun_red_buffer, &internal_data);
+        afe44xx_raw_data->spO2_data_ready = internal_data.spO2_calc_done;
+        internal_data.spO2_calc_done = false; 
+#endif
+        dec_buffer_count = 0;
+    }
+    
+    // move data into the struct afe44xx_raw_data
+    afe44xx_raw_data->spo2 = internal_data.n_spo2;
+    // A clear pulse band peak of real pulsatile amplitude stands in for a
+    // beat rate that is missing or over a quarter away from it - above
+    // 164 /min the window holds more beats than are counted
+    afe44xx_raw_data->heart_rate = internal_data.n_heart_rate;
+    if (pulse_rate > 0 && (!internal_data.ch_hr_valid || 4 * abs(pulse_rate - internal_data.n_heart_rate) > pulse_rate))
+    {
+        afe44xx_raw_data->heart_rate = pulse_rate;
+    }
+    afe44xx_raw_data->resp = internal_data.n_resp_rate;
+    // Debugging stuff
+    afe44xx_raw_data->test1 = internal_data.test1;
+    afe44xx_raw_data->test2 = internal_data.test2;
+    afe44xx_raw_data->test3 = internal_data.test3; 
+    //internal_data.testbuffer[30] = 44444;               
+    return true; 
+}
+
+// Start up configuration, written in this order after the software reset
+static const afe44xx_register afe44xx_config[] = {
   // Transimpedance amplifier Gain Register  
   // Gain stage 2 = 0dB 
   // Filter component for first stage Cf= 5pF
   // Feedback resistor sets Photodiode current RF = 500K
   // (Default settings)
-  afe44xxWrite(TIAGAIN, 0x000000,chip_select);
+  { TIAGAIN, 0x000000 },
 
   // Transimpedance Amplifier and Ambient Cancellation Stage Gain Register 
   // Ambient DAC 0uA Ambient Filter corner freq 500Hz
   // LED2 Stage 2 amp 0dB Filter Cf = 5pf Feedback resistor Rf = 250K
-  afe44xxWrite(TIA_AMB_GAIN, 0x000001,chip_select);
+  { TIA_AMB_GAIN, 0x000001 },
 
   // LEDCNTRL register sets LED currents 
   // Full scale 150mA (default) 
   // LED1 and LED2 current (20/256)*150mA ie approx 11.7mA
   // Original comment LED_RANGE=100mA, LED=50mA ?? this is not correct by my reading
-  afe44xxWrite(LEDCNTRL, 0x001414,chip_select);
+  { LEDCNTRL, 0x001414 },
 
   // CONTROL2 Various functions 
   // 0.75V reference voltage to ADC
@@ -173,73 +223,123 @@ bool AFE4490 :: afe44xxInit (const int chip_select,const int power_down_pin)
   // Crystal oscillator enabled 
   // Fast Diagnostics mode
   // TX, RX and AFE powered up   
-  afe44xxWrite(CONTROL2, 0x000000,chip_select);
+  { CONTROL2, 0x000000 },
   
   // CONTROL1
   // Timers ON, some Clocks to ALM pins, average 7 samples ADC  ?Should be 0x000F03 
   // Original comment said 3 samples  
-  afe44xxWrite(CONTROL1, 0x000F07,chip_select); 
+  { CONTROL1, 0x000F07 },
   
   // PRPCOUNT register sets up Pulse repetition rate which determines samples/sec
   // value here is 0x001F3F which is 7999
   // Change to 1F40 or 8000
   // equivalent to 500 reps/sec with a 4MHz clock ie 4000000/8000
-  afe44xxWrite(PRPCOUNT, 0X001F40,chip_select);  
+  { PRPCOUNT, 0x001F40 },
   
   // Timing of various actions - LEDs on and off, conversions etc
   // Can be set with these registers 
-  afe44xxWrite(LED2STC, 0X001770,chip_select);
-  afe44xxWrite(LED2ENDC, 0X001F3E,chip_select);
-  afe44xxWrite(LED2LEDSTC, 0X001770,chip_select);
-  afe44xxWrite(LED2LEDENDC, 0X001F3F,chip_select);
-  afe44xxWrite(ALED2STC, 0X000000,chip_select);
-  afe44xxWrite(ALED2ENDC, 0X0007CE,chip_select);
-  afe44xxWrite(LED2CONVST, 0X000002,chip_select);
-  afe44xxWrite(LED2CONVEND, 0X0007CF,chip_select);
-  afe44xxWrite(ALED2CONVST, 0X0007D2,chip_select);
-  afe44xxWrite(ALED2CONVEND, 0X000F9F,chip_select);
-  afe44xxWrite(LED1STC, 0X0007D0,chip_select);
-  afe44xxWrite(LED1ENDC, 0X000F9E,chip_select);
-  afe44xxWrite(LED1LEDSTC, 0X0007D0,chip_select);
-  afe44xxWrite(LED1LEDENDC, 0X000F9F,chip_select);
-  afe44xxWrite(ALED1STC, 0X000FA0,chip_select);
-  afe44xxWrite(ALED1ENDC, 0X00176E,chip_select);
-  afe44xxWrite(LED1CONVST, 0X000FA2,chip_select);
-  afe44xxWrite(LED1CONVEND, 0X00176F,chip_select);
-  afe44xxWrite(ALED1CONVST, 0X001772,chip_select);
-  afe44xxWrite(ALED1CONVEND, 0X001F3F,chip_select);
-  afe44xxWrite(ADCRSTCNT0, 0X000000,chip_select);
-  afe44xxWrite(ADCRSTENDCT0, 0X000000,chip_select);
-  afe44xxWrite(ADCRSTCNT1, 0X0007D0,chip_select);
-  afe44xxWrite(ADCRSTENDCT1, 0X0007D0,chip_select);
-  afe44xxWrite(ADCRSTCNT2, 0X000FA0,chip_select);
-  afe44xxWrite(ADCRSTENDCT2, 0X000FA0,chip_select);
-  afe44xxWrite(ADCRSTCNT3, 0X001770,chip_select);
-  afe44xxWrite(ADCRSTENDCT3, 0X001770,chip_select);
-  delay(10);
-  return true;
+  { LED2STC, 0x001770 },
+  { LED2ENDC, 0x001F3E },
+  { LED2LEDSTC, 0x001770 },
+  { LED2LEDENDC, 0x001F3F },
+  { ALED2STC, 0x000000 },
+  { ALED2ENDC, 0x0007CE },
+  { LED2CONVST, 0x000002 },
+  { LED2CONVEND, 0x0007CF },
+  { ALED2CONVST, 0x0007D2 },
+  { ALED2CONVEND, 0x000F9F },
+  { LED1STC, 0x0007D0 },
+  { LED1ENDC, 0x000F9E },
+  { LED1LEDSTC, 0x0007D0 },
+  { LED1LEDENDC, 0x000F9F },
+  { ALED1STC, 0x000FA0 },
+  { ALED1ENDC, 0x00176E },
+  { LED1CONVST, 0x000FA2 },
+  { LED1CONVEND, 0x00176F },
+  { ALED1CONVST, 0x001772 },
+  { ALED1CONVEND, 0x001F3F },
+  { ADCRSTCNT0, 0x000000 },
+  { ADCRSTENDCT0, 0x000000 },
+  { ADCRSTCNT1, 0x0007D0 },
+  { ADCRSTENDCT1, 0x0007D0 },
+  { ADCRSTCNT2, 0x000FA0 },
+  { ADCRSTENDCT2, 0x000FA0 },
+  { ADCRSTCNT3, 0x001770 },
+  { ADCRSTENDCT3, 0x001770 },
+};
+
+// Set up AFE4490
+// The configuration goes out back to back and is read back to check it.
+// If it did not take the reset is repeated with the original 50 ms wait
+bool AFE4490 :: afe44xxInit (const int chip_select,const int power_down_pin)
+{
+  // In fact this is a power down pin 
+  // (Original code was calling it a reset)
+  digitalWrite(power_down_pin, LOW);
+  // Power down when pin low - chip enable
+  digitalWrite(power_down_pin, HIGH);
+  
+  for (int attempt = 0; attempt < AFE4490_CONFIG_TRIES; attempt++)
+  {
+    // Software reset pulse to CONTROL0
+    // D3 High resets all internal registers 
+    // D3 then self clears to 0
+    afe44xxWrite(CONTROL0, 0x000000,chip_select);
+    afe44xxWrite(CONTROL0, 0x000008,chip_select);
+    if (attempt == 0)
+    {
+      delayMicroseconds(AFE4490_RESET_WAIT_US);
+    }
+    else
+    {
+      delay(AFE4490_RESET_RETRY_MS);
+    }
+    if (afe44xxWriteTable(afe44xx_config, sizeof(afe44xx_config) / sizeof(afe44xx_config[0]), chip_select))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Write each register of the table, then read them all back
+// The AFE4490 has no multi-register transfer, so a register is one 32 bit
+// transaction - but they follow each other with nothing in between
+bool AFE4490 :: afe44xxWriteTable (const afe44xx_register *table, int count, const int chip_select)
+{
+  for (int i = 0; i < count; i++)
+  {
+    afe44xxWrite(table[i].address, table[i].value, chip_select);
+  }
+  // Registers only read back with SPI_READ set
+  afe44xxWrite(CONTROL0, 0x000001, chip_select);
+  bool matched = true;
+  for (int i = 0; i < count && matched; i++)
+  {
+    matched = afe44xxRead(table[i].address, chip_select) == (table[i].value & 0xFFFFFF);
+  }
+  afe44xxWrite(CONTROL0, 0x000000, chip_select);
+  return matched;
 }
 
 void AFE4490 :: afe44xxWrite (uint8_t address, uint32_t data,const int chip_select)
 {
+  // Address then 24 bits of data, MSB first, in one transfer
+  uint8_t frame[4] = { address, (uint8_t)(data >> 16), (uint8_t)(data >> 8), (uint8_t)data };
   digitalWrite (chip_select, LOW); // enable device for writing data
-  SPI.transfer (address); // send address to device
-  SPI.transfer ((data >> 16) & 0xFF); // write top 8 bits
-  SPI.transfer ((data >> 8) & 0xFF); // write middle 8 bits
-  SPI.transfer (data & 0xFF); // write bottom 8 bits
+  SPI.writeBytes (frame, sizeof(frame));
   digitalWrite (chip_select, HIGH); // disable device for writing 
 }
 
 unsigned long AFE4490 :: afe44xxRead (uint8_t address,const int chip_select)
 {
-  unsigned long data = 0;
+  uint8_t frame[4] = { address, 0, 0, 0 };
+  uint8_t data[4];
   digitalWrite (chip_select, LOW); // enable device for transfer
-  SPI.transfer (address); // send address to device
-  data |= ((unsigned long)SPI.transfer (0) << 16); // read top 8 bits data
-  data |= ((unsigned long)SPI.transfer (0) << 8); // read middle 8 bits  data
-  data |= SPI.transfer (0); // read bottom 8 bits data
+  SPI.transferBytes (frame, data, sizeof(frame));
   digitalWrite (chip_select, HIGH); // disable device
-  return data; // return with 24 bits of read data
+  // return with 24 bits of read data
+  return ((unsigned long)data[1] << 16) | ((unsigned long)data[2] << 8) | data[3];
 }
 
 
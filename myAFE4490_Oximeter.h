@@ -25,6 +25,10 @@
 #include <SPI.h>
 #include <string.h>
 #include <math.h>
+#include "polyphase_decimator.h"
+#include "spo2_stream.h"
+#include "ppg_resp_rate.h"
+#include "sliding_dft.h"
 
 // AFE4490 Register map
 #define CONTROL0      0x00
@@ -82,9 +86,38 @@
 // AFE4490 setup at 500 samples/sec in init function 
 // decimate 1:20 => 25 samples/sec 
 #define DECIMATE      20
+// Anti-alias filter length - a multiple of DECIMATE
+#define PPG_DECIMATOR_TAPS 240
+extern const int16_t PPG_DecimatorCoeffs[PPG_DECIMATOR_TAPS];
 // at 25 samples/sec 5 sec of data is 125 samples
 // make buffer length a multiple of 2 to allow rapid division by bit shift  
 #define BUFFER_LENGTH 128
+// Pulse band of the decimated IR kept by pulse_spectrum - 10.24 s,
+// bins 0.098 Hz (5.9 /min) apart, 30 to 210 /min
+#define PULSE_SPECTRUM_LENGTH 256
+#define PULSE_SPECTRUM_LO_HZ  0.5
+#define PULSE_SPECTRUM_HI_HZ  3.5
+// Percent of the band's power the peak needs to stand in for the heart
+// rate from the beats - white noise reaches 60, a pulse with its second
+// harmonic in the band about 45
+#define PULSE_SPECTRUM_MIN_SHARE 65
+// and the least amplitude, in 22 bit IR counts, of the sine wave it
+// stands for - 0.01% of full scale peak to peak, a weak pulse has a few
+// times that. With the probe off the band holds ambient noise and
+// flicker of a few counts, which can still make up most of its power
+#define PULSE_SPECTRUM_MIN_AMPLITUDE 100
+// 1 updates SpO2 and heart rate at every beat (spo2_stream.h),
+// 0 recomputes them over each full buffer with estimate_spo2
+#ifndef SPO2_STREAMING
+#define SPO2_STREAMING 1
+#endif
+
+// Start up - wait after the software reset before the registers are
+// written (SW_RST clears in a few 4 MHz clocks), and the original wait
+// used when a first configuration did not read back as written
+#define AFE4490_RESET_WAIT_US   10
+#define AFE4490_RESET_RETRY_MS  50
+#define AFE4490_CONFIG_TRIES    2
 
 // Data Ready interrupt handler
 void afe4490_interrupt_handler(void);
@@ -103,6 +136,12 @@ typedef struct afe44xx_Record{
   uint16_t test3 = 0;        
 }afe44xx_data;
 
+// One register of a configuration table
+typedef struct afe44xx_Register{
+  uint8_t address;
+  uint32_t value;
+}afe44xx_register;
+
 // To hold internal data to pass to spO2/resp/HR routine
 typedef struct afe44xx_Internal{
     int16_t n_spo2;
@@ -130,9 +169,12 @@ class AFE4490
   public:
     AFE4490();  
     bool afe44xxInit (const int chip_select, const int power_down);
+    // Write the registers in table order and read them back - false on a mismatch
+    bool afe44xxWriteTable (const afe44xx_register *table, int count, const int chip_select);
     void afe44xxWrite (uint8_t address, uint32_t data,const int chip_select);
     unsigned long afe44xxRead (uint8_t address,const int chip_select);
     bool get_AFE4490_data_if_available (afe44xx_data *afe44xx_raw_data,const int chip_select);
+    bool process_AFE4490_sample (unsigned long ir_raw, unsigned long red_raw, afe44xx_data *afe44xx_raw_data);
     static void afe4490_interrupt_handler(void);
       
     // Internal Data struct
@@ -140,10 +182,22 @@ class AFE4490
     //infrared and red LED sensor data post decimation and bit cleaning
     uint16_t aun_ir_buffer[BUFFER_LENGTH]; 
     uint16_t aun_red_buffer[BUFFER_LENGTH];
+    // Spectrum of the pulse band of the decimated IR, at every sample
+    sliding_dft pulse_spectrum;
+    // Its peak per minute, 0 if not clear enough
+    int16_t pulse_rate;
       
   private:
+    // Buffer length fixed here
+    static const int16_t dec_buffer_length = BUFFER_LENGTH;
      // Data length of decimated IR and red buffers 
-    int dec_buffer_count, dec; 
+    int dec_buffer_count; 
+    // 500 -> 25 samples/sec anti-alias filters
+    polyphase_decimator ir_decimator, red_decimator;
+    // SpO2 and heart rate at each beat
+    spo2_stream beat_estimator;
+    // Respiration rate from the baseline of the decimated IR
+    ppg_resp_rate resp_estimator;
     // 22 bit raw data numbers from AFE4490
     // numbers are in 2s complement
     long IRtemp,REDtemp;
@@ -29,6 +29,19 @@
 #include "myoximeter_algorithm.h"
 #include <math.h>
 
+// Lookup table for O2 sats %
+// See quadratic function in the header
+const uint8_t spo2_algorithm::uch_spo2_table[SPO2_TABLE_SIZE]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 99, 99, 99, 99,
+                                    99, 99, 99, 99, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+                                   100, 100, 100, 100, 99, 99, 99, 99, 99, 99, 99, 99, 98, 98, 98, 98, 98, 98, 97, 97,
+                                    97, 97, 96, 96, 96, 96, 95, 95, 95, 94, 94, 94, 93, 93, 93, 92, 92, 92, 91, 91,
+                                    90, 90, 89, 89, 89, 88, 88, 87, 87, 86, 86, 85, 85, 84, 84, 83, 82, 82, 81, 81,
+                                    80, 80, 79, 78, 78, 77, 76, 76, 75, 74, 74, 73, 72, 72, 71, 70, 69, 69, 68, 67,
+                                    66, 66, 65, 64, 63, 62, 62, 61, 60, 59, 58, 57, 56, 56, 55, 54, 53, 52, 51, 50,
+                                    49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29,
+                                    28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5,
+                                    3,   2,  1  };
+
 // Constructor
 spo2_algorithm::spo2_algorithm()
 {
@@ -104,13 +117,13 @@ typedef struct afe44xx_Internal{
   // but doesnt deal with last 4 data points 
   // 4 points are eccentric - does this matter?
   // This routine does seem to improve output accuracy 
-  for(k=0; k< BUFFER_LENGTH-3; k++)
+  for(k=0; k< SPO2_BUFFER_LENGTH-3; k++)
   {
     // Use right shift to divide again
     an_x[k] = ((an_x[k]+an_x[k+1]+ an_x[k+2]+ an_x[k+3])>>2);
   }
   // deal with these last 4 points
-  for(k=BUFFER_LENGTH; k>= BUFFER_LENGTH-3; k--)
+  for(k=SPO2_BUFFER_LENGTH; k>= SPO2_BUFFER_LENGTH-3; k--)
   {
     // Use right shift to divide again
     an_x[k] = ((an_x[k]+an_x[k-1]+ an_x[k-2]+ an_x[k-3])>>2);
@@ -136,74 +149,75 @@ typedef struct afe44xx_Internal{
     {
       n_peak_interval_sum += (an_ir_valley_locs[k] - an_ir_valley_locs[k-1]) ;
     }
-    av_peak_interval = (float)n_peak_interval_sum/(n_npks-1);
     // SF_spO2 is the sampling frequency for oximeter #DEFINE in spo2_algorithm.h 
     // Set at 25 (?samples/sec)
+#if SPO2_FIXED_POINT
+    // 60*SF/(sum/(n-1)) rearranged to one integer division
+    pn_heart_rate = (SF_spo2*60*(n_npks-1))/n_peak_interval_sum;
+#else
+    av_peak_interval = (float)n_peak_interval_sum/(n_npks-1);
     float HR =(float)((SF_spo2*60)/av_peak_interval);
     pn_heart_rate = int(HR);
+#endif
     pch_hr_valid  = true;
   }
   else
   {
-    pn_heart_rate = -999; // unable to calculate because # of peaks are too small
+    pn_heart_rate = 0; // unable to calculate because # of peaks are too small
     pch_hr_valid  = false;
   }
 
-  //  load raw value again for SPO2 calculation : RED(=y) and IR(=x)
-  // Do we need to do this?
-  
-  for (k=0 ; k < buffer_length ; k++ )
-  {
-      an_x[k] =  pun_ir_buffer[k] ;
-      an_y[k] =  pun_red_buffer[k] ;
-  }
-
-  // Choose a threshold crossing point and iterate forwards to the next crossing point
-  // to find the minimum and maximum points for that cycle for the IR buffer
-  local_maxIR = 0;
-  local_minIR = sample_max;
-  for (k = an_ir_valley_locs[1]; k < an_ir_valley_locs[2]; k++)
+  // Ratio of ratios for every cycle between threshold crossings, in one
+  // pass over the raw values: RED(=y) and IR(=x) at each cycle's IR minimum
+  // and maximum. A single cycle swings by several percent, so they are
+  // combined as the mean of those near the median
+  n_ratios = 0;
+  AC_RED = 0;
+  DC_RED = 0;
+  if (n_npks > 1)
   {
-      if (an_x[k] < local_minIR)
+    j = 1;
+    local_maxIR = 0;
+    local_minIR = sample_max;
+    for (k = an_ir_valley_locs[0]; k <= an_ir_valley_locs[n_npks-1] && k < buffer_length; k++)
+    {
+      // A crossing ends one cycle and starts the next
+      if (k == an_ir_valley_locs[j])
       {
-          local_minIR = an_x[k];
-          local_minRED = an_y[k];
+        AC_IR = local_maxIR - local_minIR;
+        DC_IR = local_minIR;
+        AC_RED = local_maxRED - local_minRED;
+        DC_RED = local_minRED;
+        spo2_ratio cycle_R = cycle_ratio(AC_IR, DC_IR, AC_RED, DC_RED);
+        if (cycle_R >= 0)
+        {
+          cycle_ratios[n_ratios++] = cycle_R;
+        }
+        j++;
+        local_maxIR = 0;
+        local_minIR = sample_max;
       }
-      if (an_x[k] > local_maxIR)
+      if (pun_ir_buffer[k] < local_minIR)
       {
-          local_maxIR = an_x[k];
-          local_maxRED = an_y[k];
+          local_minIR = pun_ir_buffer[k];
+          local_minRED = pun_red_buffer[k];
       }
-  }
-  // Using a single interval - would probably be improved by using several and choosing the median 
-   
-  AC_IR = local_maxIR - local_minIR;
-  DC_IR = local_minIR;
-  AC_RED = local_maxRED - local_minRED;
-  DC_RED = local_minRED;
-  
-  // Intermediate Variable - if any 0 then error 
-  if (AC_IR != 0 && DC_IR !=0 && AC_RED != 0 && DC_RED !=0)
-  {
-      float red = float(AC_RED)/float(DC_RED);
-      float ir = float(AC_IR)/float(DC_IR);
-      
-      // scale R to lookup table 100 seems to give a reasonable accuracy 
-      R = (red/ir)*100;
-      
-      // Lookup table is based on this quadratic - see above  
-      //R =  -45.060*R*R/10000 + 30.354 *R/100 + 94.845 ;
-  }
-  else 
-  {
-      // Invalid easurement 
-      R = 200;
+      if (pun_ir_buffer[k] > local_maxIR)
+      {
+          local_maxIR = pun_ir_buffer[k];
+          local_maxRED = pun_red_buffer[k];
+      }
+    }
   }
   
-  lookup = int(R);
+  // Lookup table is based on this quadratic - see above  
+  //R =  -45.060*R*R/10000 + 30.354 *R/100 + 94.845 ;
+  R = combine_ratios(cycle_ratios, n_ratios);
+  // Invalid measurement if negative
+  lookup = (R < 0) ? SPO2_TABLE_SIZE : ratio_index(R);
   
   // Lookup table
-   if(lookup > 1 && lookup <184)
+   if(lookup > 1 && lookup <SPO2_TABLE_SIZE)
   {
     n_spo2_calc= uch_spo2_table[lookup] ;
     pn_spo2 = n_spo2_calc ;
@@ -221,7 +235,7 @@ typedef struct afe44xx_Internal{
     internal_data->ch_spo2_valid = pch_spo2_valid;
     internal_data->ch_hr_valid = pch_hr_valid;
     internal_data->spO2_calc_done = true;
-    internal_data-> test1 = R;
+    internal_data-> test1 = lookup;
     internal_data->test2 = AC_RED;
     internal_data->test3 = DC_RED;
 
@@ -235,6 +249,120 @@ typedef struct afe44xx_Internal{
  
 }
 
+// R scaled by 100 to index the lookup table - 100 seems to give a
+// reasonable accuracy. -1 if any part is 0
+float spo2_algorithm :: ratio_of_ratios(int ac_ir, int dc_ir, int ac_red, int dc_red)
+{
+  if (ac_ir == 0 || dc_ir == 0 || ac_red == 0 || dc_red == 0)
+  {
+    return -1;
+  }
+  float red = float(ac_red)/float(dc_red);
+  float ir = float(ac_ir)/float(dc_ir);
+  return (red/ir)*100;
+}
+
+// R = (ACred/DCred)/(ACir/DCir) = (ACred*DCir)/(DCred*ACir) in Q15
+// The products are up to 32 bits, so the division is done in 64
+int32_t spo2_algorithm :: ratio_of_ratios_q15(int ac_ir, int dc_ir, int ac_red, int dc_red)
+{
+  if (ac_ir <= 0 || dc_ir <= 0 || ac_red <= 0 || dc_red <= 0)
+  {
+    return -1;
+  }
+  uint64_t num = ((uint64_t)ac_red * (uint64_t)dc_ir) << SPO2_R_SHIFT;
+  uint64_t den = (uint64_t)dc_red * (uint64_t)ac_ir;
+  uint64_t r = num / den;
+  return (r > INT32_MAX) ? INT32_MAX : (int32_t)r;
+}
+
+spo2_ratio spo2_algorithm :: cycle_ratio(int ac_ir, int dc_ir, int ac_red, int dc_red)
+{
+#if SPO2_FIXED_POINT
+  return ratio_of_ratios_q15(ac_ir, dc_ir, ac_red, dc_red);
+#else
+  return ratio_of_ratios(ac_ir, dc_ir, ac_red, dc_red);
+#endif
+}
+
+int spo2_algorithm :: ratio_index(float ratio)
+{
+  return int(ratio);
+}
+
+int spo2_algorithm :: ratio_index(int32_t ratio)
+{
+  return (int)(((int64_t)ratio * 100) >> SPO2_R_SHIFT);
+}
+
+// Sort the ratios (a handful - insertion sort), take the median and drop
+// any further than SPO2_RATIO_SPREAD of it away - motion, or a crossing
+// missed so that two cycles ran together. The rest are averaged
+float spo2_algorithm :: combine_ratios(float *ratios, int count)
+{
+  if (count <= 0)
+  {
+    return -1;
+  }
+  for (int a = 1; a < count; a++)
+  {
+    float r = ratios[a];
+    int b = a;
+    for (; b > 0 && ratios[b-1] > r; b--)
+    {
+      ratios[b] = ratios[b-1];
+    }
+    ratios[b] = r;
+  }
+  float median = (count & 1) ? ratios[count/2] : (ratios[count/2 - 1] + ratios[count/2]) / 2;
+  float sum = 0;
+  int kept = 0;
+  for (int a = 0; a < count; a++)
+  {
+    if (fabsf(ratios[a] - median) <= SPO2_RATIO_SPREAD * median)
+    {
+      sum += ratios[a];
+      kept++;
+    }
+  }
+  // With an even count the median is between two values that may both
+  // be outside the spread
+  return (kept > 0) ? sum / kept : median;
+}
+
+// As above in integers - the spread test multiplied out
+int32_t spo2_algorithm :: combine_ratios(int32_t *ratios, int count)
+{
+  if (count <= 0)
+  {
+    return -1;
+  }
+  for (int a = 1; a < count; a++)
+  {
+    int32_t r = ratios[a];
+    int b = a;
+    for (; b > 0 && ratios[b-1] > r; b--)
+    {
+      ratios[b] = ratios[b-1];
+    }
+    ratios[b] = r;
+  }
+  int64_t median = (count & 1) ? ratios[count/2]
+                               : ((int64_t)ratios[count/2 - 1] + ratios[count/2]) / 2;
+  int64_t sum = 0;
+  int kept = 0;
+  for (int a = 0; a < count; a++)
+  {
+    int64_t off = ratios[a] - median;
+    if ((off < 0 ? -off : off) * 100 <= median * SPO2_SPREAD_PERCENT)
+    {
+      sum += ratios[a];
+      kept++;
+    }
+  }
+  return (int32_t)((kept > 0) ? sum / kept : median);
+}
+
 // My (naive) peak finding routine seems to work quite well!
 int spo2_algorithm :: my_find_peaks(uint16_t *AC_data_buffer, int16_t *peaks_buffer, afe44xx_internal_data *internal_data)
 {
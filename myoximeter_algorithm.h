@@ -19,14 +19,31 @@
  * DCred is the DC offset of the red signal 
  * ACir is the AC amplitude of the ir (Infrared) signal 
  * DCir is the DC offset of the ir signal  
- */ 
+ *
+ * With SPO2_FIXED_POINT no float is used: R is held as a Q15 int32,
+ * worked out as (ACred*DCir << 15) / (DCred*ACir) - one 64 bit integer
+ * division, no reciprocals - and heart rate is an integer division too.
+ * A cycle's R differs from the float one by under 1/32768, so the table
+ * index (R*100) can differ by one - one table step, at most 2% SpO2 -
+ * when R*100 lands within 0.003 of a whole number. build/healthypi_spo2_paths
+ * runs both builds on a recording and counts the estimates that differ.
+ * On 30 minutes of synthetic PPG, heart rate swept over 30-90 /min and
+ * SpO2 over 85-100% (1851 streaming and 351 batch estimates), none did;
+ * it has not been run on recorded patient data yet.
+ */
 
 #ifndef myoximeter_algorithm_h
 #define myoximeter_algorithm_h
 
+#include "spo2_ratio.h"
+
 #define SF_spo2          25    //sampling frequency
-#define BUFFER_LENGTH  255
+#define SPO2_BUFFER_LENGTH 255  // an_x/an_y - room for more than the 128 samples given
 #define MA4_SIZE         4     // 4 point moving average
+#define SPO2_TABLE_SIZE  184
+#define SPO2_MAX_CYCLES  16    // more than the crossings my_find_peaks keeps
+#define SPO2_RATIO_SPREAD 0.15f // cycles with R further than this from the median are dropped
+#define SPO2_SPREAD_PERCENT 15  // the same for the fixed point R
 #define min(x,y) ((x) < (y) ? (x) : (y)) // If x<y return x else return y
 
 class spo2_algorithm
@@ -37,25 +54,31 @@ class spo2_algorithm
    
     // My peak finding routine
     int my_find_peaks(uint16_t *AC_data_buffer, int16_t *peaks_buffer, afe44xx_internal_data *internal_data);
+
+    // R*100 for one cycle's AC and DC values, -1 if any is 0
+    static float ratio_of_ratios(int ac_ir, int dc_ir, int ac_red, int dc_red);
+    // R in Q15, -1 if any is 0
+    static int32_t ratio_of_ratios_q15(int ac_ir, int dc_ir, int ac_red, int dc_red);
+    // Whichever of the two SPO2_FIXED_POINT selects
+    static spo2_ratio cycle_ratio(int ac_ir, int dc_ir, int ac_red, int dc_red);
+    // Mean of the per cycle R values near their median, -1 if there are
+    // none. Sorts ratios in place
+    static float combine_ratios(float *ratios, int count);
+    static int32_t combine_ratios(int32_t *ratios, int count);
+    // R*100 - the lookup table index
+    static int ratio_index(float ratio);
+    static int ratio_index(int32_t ratio);
+
+    // Lookup table for O2 sats % indexed by R*100 - shared with spo2_stream
+    // See quadratic function above 
+    static const uint8_t uch_spo2_table[SPO2_TABLE_SIZE];
     
   private:
     // IR buffer for intermediate calculations - will hold buffer - DC offset 
-    uint16_t an_x[BUFFER_LENGTH];
+    uint16_t an_x[SPO2_BUFFER_LENGTH];
     // Red buffer for intermediate calculations
-    uint16_t an_y[BUFFER_LENGTH];
+    uint16_t an_y[SPO2_BUFFER_LENGTH];
     
-    // Lookup table for O2 sats %
-    // See quadratic function above 
-    const uint8_t uch_spo2_table[184]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 99, 99, 99, 99,
-                                    99, 99, 99, 99, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
-                                   100, 100, 100, 100, 99, 99, 99, 99, 99, 99, 99, 99, 98, 98, 98, 98, 98, 98, 97, 97,
-                                    97, 97, 96, 96, 96, 96, 95, 95, 95, 94, 94, 94, 93, 93, 93, 92, 92, 92, 91, 91,
-                                    90, 90, 89, 89, 89, 88, 88, 87, 87, 86, 86, 85, 85, 84, 84, 83, 82, 82, 81, 81,
-                                    80, 80, 79, 78, 78, 77, 76, 76, 75, 74, 74, 73, 72, 72, 71, 70, 69, 69, 68, 67,
-                                    66, 66, 65, 64, 63, 62, 62, 61, 60, 59, 58, 57, 56, 56, 55, 54, 53, 52, 51, 50,
-                                    49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29,
-                                    28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5,
-                                    3,   2,  1  };
                                     
     // Variables from main function 
     uint16_t sample_max, sample_min, threshold; 
@@ -70,8 +93,11 @@ class spo2_algorithm
     int local_minIR, local_maxIR, local_minRED, local_maxRED;
     int AC_IR, AC_RED, DC_IR, DC_RED;
     
+    // R of each cycle in the buffer
+    spo2_ratio cycle_ratios[SPO2_MAX_CYCLES];
+    int n_ratios;
     // intermediate variable for lookup table 
-    float R = 0.0;
+    spo2_ratio R = 0;
     int lookup;
     uint16_t n_spo2_calc;
     
@@ -0,0 +1,381 @@
+/***************************************************************
+//   Packet scheduler for the serial stream
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "packet_scheduler.h"
+#include "crc16.h"
+#include "sample_codec.h"
+
+packet_scheduler::packet_scheduler()
+  : mode(STREAM_MODE_SCHEDULED), coder(SAMPLE_CODER_RICE), last_ecg(0), last_resp(0), last_ir(0), last_red(0),
+    vitals_ever_sent(false), vitals_sent_ms(0), waveform_dropped(0),
+    ecg_factor(1), ppg_factor(1), ecg_summed(0), ppg_summed(0),
+    batch_ecg_count(0), batch_ppg_count(0), batch_status(0), batch_sequence(0),
+    status_sent_ms(0), queue_peak(0)
+{
+  memset(&vitals, 0, sizeof(vitals));
+  memset(&vitals_sent, 0, sizeof(vitals_sent));
+  memset(&link, 0, sizeof(link));
+  memset(ecg_sum, 0, sizeof(ecg_sum));
+  memset(ppg_sum, 0, sizeof(ppg_sum));
+}
+
+// A batch already begun goes out in the old mode, so a change while
+// streaming loses no samples
+void packet_scheduler::set_mode(uint8_t stream_mode)
+{
+  if (batching() && (batch_ecg_count > 0 || batch_ppg_count > 0))
+  {
+    flush_batch(false);
+  }
+  mode = stream_mode;
+  // First vitals frame of the new mode goes out straight away
+  vitals_ever_sent = false;
+  batch_ecg_count = 0;
+  batch_ppg_count = 0;
+}
+
+serial_packet *packet_scheduler::begin_frame(uint8_t type, uint16_t frame_size)
+{
+  serial_packet *packet = queue.write_slot();
+  if (packet != NULL)
+  {
+    serial_frame_init(packet, type, frame_size);
+  }
+  return packet;
+}
+
+void packet_scheduler::commit()
+{
+  queue.commit();
+  uint32_t waiting = queue.size();
+  if (waiting > queue_peak)
+  {
+    queue_peak = waiting;
+  }
+}
+
+serial_packet *packet_scheduler::begin_waveform_frame(uint8_t type, uint16_t frame_size)
+{
+  if (queue.size() >= PACKET_QUEUE_SIZE - PACKET_QUEUE_RESERVED)
+  {
+    waveform_dropped++;
+    return NULL;
+  }
+  return begin_frame(type, frame_size);
+}
+
+// Partial sums are dropped, so the next sample sent is a whole mean
+void packet_scheduler::set_decimation(uint8_t ecg_decimation, uint8_t ppg_decimation)
+{
+  ecg_factor = ecg_decimation > 0 ? ecg_decimation : 1;
+  ppg_factor = ppg_decimation > 0 ? ppg_decimation : 1;
+  ecg_summed = 0;
+  ppg_summed = 0;
+  memset(ecg_sum, 0, sizeof(ecg_sum));
+  memset(ppg_sum, 0, sizeof(ppg_sum));
+}
+
+void packet_scheduler::ecg_sample(int16_t ecg, int16_t resp, uint8_t status)
+{
+  if (ecg_factor > 1)
+  {
+    ecg_sum[0] += ecg;
+    ecg_sum[1] += resp;
+    if (++ecg_summed < ecg_factor)
+    {
+      return;
+    }
+    ecg = (int16_t)(ecg_sum[0] / ecg_factor);
+    resp = (int16_t)(ecg_sum[1] / ecg_factor);
+    ecg_summed = 0;
+    ecg_sum[0] = ecg_sum[1] = 0;
+  }
+  queue_ecg(ecg, resp, status);
+}
+
+void packet_scheduler::ppg_sample(int32_t ir, int32_t red)
+{
+  if (ppg_factor > 1)
+  {
+    ppg_sum[0] += ir;
+    ppg_sum[1] += red;
+    if (++ppg_summed < ppg_factor)
+    {
+      return;
+    }
+    ir = ppg_sum[0] / ppg_factor;
+    red = ppg_sum[1] / ppg_factor;
+    ppg_summed = 0;
+    ppg_sum[0] = ppg_sum[1] = 0;
+  }
+  queue_ppg(ir, red);
+}
+
+void packet_scheduler::queue_ecg(int16_t ecg, int16_t resp, uint8_t status)
+{
+  last_ecg = ecg;
+  last_resp = resp;
+  if (batching())
+  {
+    batch_ecg[0][batch_ecg_count] = ecg;
+    batch_ecg[1][batch_ecg_count] = resp;
+    batch_status = status;
+    if (++batch_ecg_count == BATCH_ECG_SAMPLES)
+    {
+      flush_batch(false);
+    }
+    return;
+  }
+  if (mode != STREAM_MODE_SCHEDULED)
+  {
+    return;
+  }
+  serial_packet *packet = begin_waveform_frame(CES_CMDIF_TYPE_ECG, sizeof(ecg_frame));
+  if (packet == NULL)
+  {
+    return;
+  }
+  packet->ecg.ecg = ecg;
+  packet->ecg.resp = resp;
+  packet->ecg.status = status;
+  commit();
+}
+
+void packet_scheduler::queue_ppg(int32_t ir, int32_t red)
+{
+  last_ir = ir;
+  last_red = red;
+  if (batching())
+  {
+    batch_ppg[0][batch_ppg_count] = ir;
+    batch_ppg[1][batch_ppg_count] = red;
+    if (++batch_ppg_count == BATCH_PPG_SAMPLES)
+    {
+      flush_batch(false);
+    }
+    return;
+  }
+  if (mode != STREAM_MODE_SCHEDULED)
+  {
+    return;
+  }
+  serial_packet *packet = begin_waveform_frame(CES_CMDIF_TYPE_PPG, sizeof(ppg_frame));
+  if (packet == NULL)
+  {
+    return;
+  }
+  packet->ppg.ir = ir;
+  packet->ppg.red = red;
+  commit();
+}
+
+void packet_scheduler::set_vitals(const vitals_payload *latest)
+{
+  vitals = *latest;
+}
+
+bool packet_scheduler::queue_vitals()
+{
+  serial_packet *packet = begin_frame(CES_CMDIF_TYPE_VITALS, sizeof(vitals_frame));
+  if (packet == NULL)
+  {
+    return false;
+  }
+  packet->vitals.vitals = vitals;
+  commit();
+  return true;
+}
+
+void packet_scheduler::set_link_status(const status_payload *latest)
+{
+  link = *latest;
+}
+
+// The output stage's counters from set_link_status(), with the queue's
+bool packet_scheduler::queue_status()
+{
+  serial_packet *packet = begin_frame(CES_CMDIF_TYPE_STATUS, sizeof(status_frame));
+  if (packet == NULL)
+  {
+    return false;
+  }
+  packet->status.status = link;
+  packet->status.status.frames_dropped = dropped();
+  packet->status.status.queue_peak = (uint8_t)queue_peak;
+  packet->status.status.queue_size = PACKET_QUEUE_SIZE;
+  packet->status.status.ecg_decimation = ecg_factor;
+  packet->status.status.ppg_decimation = ppg_factor;
+  commit();
+  queue_peak = queue.size();
+  return true;
+}
+
+bool packet_scheduler::queue_ack(const ack_payload *ack)
+{
+  serial_packet *packet = begin_frame(CES_CMDIF_TYPE_ACK, sizeof(ack_frame));
+  if (packet == NULL)
+  {
+    return false;
+  }
+  packet->ack.ack = *ack;
+  commit();
+  return true;
+}
+
+void packet_scheduler::update(uint32_t now_ms, bool new_samples)
+{
+  if (mode == STREAM_MODE_COMBINED)
+  {
+    if (!new_samples)
+    {
+      return;
+    }
+    serial_packet *packet = begin_frame(CES_CMDIF_TYPE_DATA, sizeof(data_frame));
+    if (packet == NULL)
+    {
+      return;
+    }
+    packet->data.ecg = last_ecg;
+    packet->data.resp = last_resp;
+    packet->data.ir = last_ir;
+    packet->data.red = last_red;
+    packet->data.vitals = vitals;
+    commit();
+    return;
+  }
+
+  if (vitals_due(now_ms))
+  {
+    bool queued = batching() ? flush_batch(true) : queue_vitals();
+    if (queued)
+    {
+      vitals_sent = vitals;
+      vitals_sent_ms = now_ms;
+      vitals_ever_sent = true;
+    }
+  }
+  if (now_ms - status_sent_ms >= STATUS_FRAME_INTERVAL_MS && queue_status())
+  {
+    status_sent_ms = now_ms;
+  }
+}
+
+bool packet_scheduler::vitals_due(uint32_t now_ms) const
+{
+  uint32_t since = now_ms - vitals_sent_ms;
+  bool changed = memcmp(&vitals, &vitals_sent, sizeof(vitals)) != 0;
+  return !vitals_ever_sent || since >= VITALS_FRAME_INTERVAL_MS
+         || (changed && since >= VITALS_MIN_INTERVAL_MS);
+}
+
+static uint8_t *put_int16(uint8_t *p, int16_t value)
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)((uint16_t)value >> 8);
+  return p + 2;
+}
+
+static uint8_t *put_int24(uint8_t *p, int32_t value)
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)((uint32_t)value >> 8);
+  p[2] = (uint8_t)((uint32_t)value >> 16);
+  return p + 3;
+}
+
+// The four channels of the batch as 0x07 blocks - bytes written, or 0
+// if they need max bytes or more
+uint16_t packet_scheduler::pack_batch(uint8_t *out, uint16_t max)
+{
+  const int32_t *channels[4] = {batch_ecg[0], batch_ecg[1], batch_ppg[0], batch_ppg[1]};
+  const uint8_t counts[4] = {batch_ecg_count, batch_ecg_count, batch_ppg_count, batch_ppg_count};
+  uint16_t used = 0;
+  for (uint8_t c = 0; c < 4; c++)
+  {
+    if (counts[c] == 0)
+    {
+      continue;
+    }
+    size_t bytes = sample_encode(coder, channels[c], counts[c], out + used, max - used);
+    if (bytes == 0 || used + bytes >= max)
+    {
+      return 0;
+    }
+    used += bytes;
+  }
+  return used;
+}
+
+// Queue what has been gathered as one batch frame and start the next
+// The sequence number moves on even if the queue is full, so the
+// receiver sees the gap. Only a batch carrying the vitals may take the
+// last PACKET_QUEUE_RESERVED slots, as with the other waveform frames
+bool packet_scheduler::flush_batch(bool with_vitals)
+{
+  uint16_t sample_bytes = batch_ecg_count * BATCH_ECG_SAMPLE_BYTES
+                          + batch_ppg_count * BATCH_PPG_SAMPLE_BYTES;
+  uint16_t sequence = batch_sequence++;
+  serial_packet *packet = NULL;
+  if (!with_vitals && queue.size() >= PACKET_QUEUE_SIZE - PACKET_QUEUE_RESERVED)
+  {
+    waveform_dropped++;
+  }
+  else
+  {
+    packet = queue.write_slot();
+  }
+  if (packet != NULL)
+  {
+    uint8_t *payload = &packet->bytes[sizeof(frame_header)];
+    uint8_t type = CES_CMDIF_TYPE_BATCH;
+    uint8_t *p = payload;
+    *p++ = BATCH_FRAME_VERSION;
+    p = put_int16(p, (int16_t)sequence);
+    *p++ = with_vitals ? BATCH_FLAG_VITALS : 0;
+    *p++ = batch_ecg_count;
+    *p++ = batch_ppg_count;
+    *p++ = batch_status;
+    // Coded straight into the slot; the raw samples are written over
+    // it if they come out no smaller
+    uint16_t packed = 0;
+    if (mode == STREAM_MODE_COMPRESSED && sample_bytes > 0)
+    {
+      packed = pack_batch(p + 1, sample_bytes - 1);
+    }
+    if (packed > 0)
+    {
+      type = CES_CMDIF_TYPE_PACKED_BATCH;
+      *p++ = coder;
+      p += packed;
+    }
+    else
+    {
+      for (uint8_t i = 0; i < batch_ecg_count; i++)
+      {
+        p = put_int16(p, (int16_t)batch_ecg[0][i]);
+        p = put_int16(p, (int16_t)batch_ecg[1][i]);
+      }
+      for (uint8_t i = 0; i < batch_ppg_count; i++)
+      {
+        p = put_int24(p, batch_ppg[0][i]);
+        p = put_int24(p, batch_ppg[1][i]);
+      }
+    }
+    if (with_vitals)
+    {
+      memcpy(p, &vitals, sizeof(vitals));
+      p += sizeof(vitals);
+    }
+    uint16_t crc = crc16(payload, p - payload);
+    p = put_int16(p, (int16_t)crc);
+    serial_frame_init(packet, type, (p - packet->bytes) + sizeof(frame_footer));
+    commit();
+  }
+  batch_ecg_count = 0;
+  batch_ppg_count = 0;
+  return packet != NULL;
+}
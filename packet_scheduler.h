@@ -0,0 +1,149 @@
+/***************************************************************
+//   Packet scheduler for the serial stream
+//
+//   Decides which frames go out and when, and queues them for the
+//   output stage. In STREAM_MODE_SCHEDULED each value goes out at its
+//   own rate:
+//   - an ECG frame for every ADS1292R sample (125 SPS)
+//   - a PPG frame for every AFE4490 sample (500 SPS)
+//   - a vitals frame (temperature, resp rate, SpO2, heart rate, lead
+//     status) every VITALS_FRAME_INTERVAL_MS, or sooner when one of
+//     them changes, but never more often than VITALS_MIN_INTERVAL_MS
+//   so no sample is sent twice and values that change once a second
+//   or less are not repeated 500 times a second.
+//
+//   STREAM_MODE_BATCHED gathers BATCH_ECG_SAMPLES / BATCH_PPG_SAMPLES
+//   samples (40 ms) into one sequence numbered, CRC checked batch frame,
+//   sent as soon as either stream has filled its share. The vitals ride
+//   in the batch when they are due, by the same rule as above, sending
+//   the batch early if need be.
+//
+//   STREAM_MODE_COMPRESSED is STREAM_MODE_BATCHED with the samples
+//   delta coded in a 0x07 frame, by the coder set_coder() picks.
+//
+//   STREAM_MODE_COMBINED sends the original 0x02 frame, every value in
+//   every frame, after each processing pass that read new samples -
+//   for viewers that only know that frame.
+//
+//   Other than in STREAM_MODE_COMBINED a status frame with the serial
+//   link counters goes out every STATUS_FRAME_INTERVAL_MS.
+//
+//   set_decimation() thins either waveform for a slower link: each
+//   sample queued is the mean of that many read, in every mode. Answers
+//   to host commands (command_channel.h) are queued with queue_ack(),
+//   in order with the frames around them.
+//
+//   Frames are built in place in the queue (see serial_frame.h); the
+//   processing stage calls the producer side, the output stage next()
+//   and sent(). A frame that finds the queue full is dropped and
+//   counted. Waveform frames leave the last PACKET_QUEUE_RESERVED slots
+//   free, so when the port falls behind it is samples that are lost and
+//   the vitals still get through.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef packet_scheduler_h
+#define packet_scheduler_h
+
+#include "Arduino.h"
+#include "serial_frame.h"
+#include "spsc_ring.h"
+
+#define STREAM_MODE_COMBINED        0
+#define STREAM_MODE_SCHEDULED       1
+#define STREAM_MODE_BATCHED         2
+#define STREAM_MODE_COMPRESSED      3
+
+#define VITALS_FRAME_INTERVAL_MS    1000
+#define VITALS_MIN_INTERVAL_MS      100
+#define STATUS_FRAME_INTERVAL_MS    1000
+
+// Frames waiting for the serial port - 64 ms of PPG frames, or
+// 1.28 s of batches
+#define PACKET_QUEUE_SIZE           32
+// Left to the vitals batch or frame, the status frame and a command ack
+#define PACKET_QUEUE_RESERVED       3
+
+class packet_scheduler
+{
+  public:
+    packet_scheduler();
+    void set_mode(uint8_t stream_mode);
+    uint8_t get_mode() const { return mode; }
+    // Sample coder for STREAM_MODE_COMPRESSED (sample_codec.h)
+    void set_coder(uint8_t sample_coder) { coder = sample_coder; }
+    uint8_t get_coder() const { return coder; }
+    // Samples averaged into each one sent, 1 for all of them
+    void set_decimation(uint8_t ecg_factor, uint8_t ppg_factor);
+    uint8_t ecg_decimation() const { return ecg_factor; }
+    uint8_t ppg_decimation() const { return ppg_factor; }
+
+    // Processing stage - each new sample as it is read
+    void ecg_sample(int16_t ecg, int16_t resp, uint8_t status);
+    void ppg_sample(int32_t ir, int32_t red);
+    // Latest slow values
+    void set_vitals(const vitals_payload *latest);
+    // Latest output stage counters for the status frame - the dropped
+    // count and the queue fields are filled in here
+    void set_link_status(const status_payload *latest);
+    // End of a processing pass - queues whatever frames are now due
+    void update(uint32_t now_ms, bool new_samples);
+    // Answer to a host command - false if the queue is full
+    bool queue_ack(const ack_payload *ack);
+
+    // Output stage - oldest queued frame, NULL if none, then sent()
+    serial_packet *next() { return queue.read_slot(); }
+    void sent() { queue.release(); }
+
+    // Frames waiting, queued and dropped because the queue was full
+    uint32_t waiting() const { return queue.size(); }
+    uint32_t frames() const { return queue.pushed(); }
+    uint32_t dropped() const { return queue.overruns() + waveform_dropped; }
+
+  private:
+    serial_packet *begin_frame(uint8_t type, uint16_t frame_size);
+    serial_packet *begin_waveform_frame(uint8_t type, uint16_t frame_size);
+    void commit();
+    bool queue_vitals();
+    bool queue_status();
+    bool vitals_due(uint32_t now_ms) const;
+    bool batching() const { return mode == STREAM_MODE_BATCHED || mode == STREAM_MODE_COMPRESSED; }
+    bool flush_batch(bool with_vitals);
+    uint16_t pack_batch(uint8_t *out, uint16_t max);
+    void queue_ecg(int16_t ecg, int16_t resp, uint8_t status);
+    void queue_ppg(int32_t ir, int32_t red);
+
+    uint8_t mode;
+    uint8_t coder;
+    int16_t last_ecg, last_resp;
+    int32_t last_ir, last_red;
+    vitals_payload vitals;
+    vitals_payload vitals_sent;
+    bool vitals_ever_sent;
+    uint32_t vitals_sent_ms;
+    uint32_t waveform_dropped;
+
+    // Decimation - sums of the samples since the last one sent
+    uint8_t ecg_factor, ppg_factor;
+    uint8_t ecg_summed, ppg_summed;
+    int32_t ecg_sum[2];
+    int32_t ppg_sum[2];
+
+    // Batch being gathered, one row per channel - ECG, resp / IR, RED
+    int32_t batch_ecg[2][BATCH_ECG_SAMPLES];
+    int32_t batch_ppg[2][BATCH_PPG_SAMPLES];
+    uint8_t batch_ecg_count;
+    uint8_t batch_ppg_count;
+    uint8_t batch_status;
+    uint16_t batch_sequence;
+
+    status_payload link;
+    uint32_t status_sent_ms;
+    uint32_t queue_peak;
+
+    spsc_ring<serial_packet, PACKET_QUEUE_SIZE> queue;
+};
+
+#endif
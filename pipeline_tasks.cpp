@@ -0,0 +1,120 @@
+/***************************************************************
+//   Task pipeline for the signal chain
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "pipeline_tasks.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct pipeline_Task{
+  pipeline_step step;
+  uint32_t idle_ms;
+  volatile bool run;
+  volatile bool stopped;
+#if defined(ARDUINO_ARCH_ESP32)
+  TaskHandle_t handle;
+#else
+  pthread_t thread;
+#endif
+}pipeline_task;
+
+static pipeline_task pipeline_tasks[PIPELINE_MAX_TASKS];
+static uint8_t pipeline_tasks_used = 0;
+
+static void pipeline_idle(uint32_t idle_ms)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  TickType_t ticks = pdMS_TO_TICKS(idle_ms);
+  vTaskDelay(ticks > 0 ? ticks : 1);
+#else
+  usleep(idle_ms > 0 ? idle_ms * 1000 : 100);
+#endif
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void pipeline_task_entry(void *param)
+#else
+static void *pipeline_task_entry(void *param)
+#endif
+{
+  pipeline_task *task = (pipeline_task *)param;
+  while (task->run)
+  {
+    if (!task->step())
+    {
+      pipeline_idle(task->idle_ms);
+    }
+  }
+  task->stopped = true;
+#if defined(ARDUINO_ARCH_ESP32)
+  vTaskDelete(NULL);
+#else
+  return NULL;
+#endif
+}
+
+bool pipeline_task_start(const char *name, pipeline_step step, uint32_t idle_ms,
+                         uint32_t stack_bytes, uint8_t priority, uint8_t core)
+{
+  if (pipeline_tasks_used >= PIPELINE_MAX_TASKS || step == NULL)
+  {
+    return false;
+  }
+  pipeline_task *task = &pipeline_tasks[pipeline_tasks_used];
+  task->step = step;
+  task->idle_ms = idle_ms;
+  task->run = true;
+  task->stopped = false;
+#if defined(ARDUINO_ARCH_ESP32)
+  if (xTaskCreatePinnedToCore(pipeline_task_entry, name, stack_bytes, task,
+                              priority, &task->handle, core) != pdPASS)
+  {
+    return false;
+  }
+#else
+  (void)name;
+  (void)stack_bytes;
+  (void)priority;
+  (void)core;
+  if (pthread_create(&task->thread, NULL, pipeline_task_entry, task) != 0)
+  {
+    return false;
+  }
+#endif
+  pipeline_tasks_used++;
+  return true;
+}
+
+void pipeline_task_stop_all()
+{
+  for (uint8_t i = 0; i < pipeline_tasks_used; i++)
+  {
+    pipeline_tasks[i].run = false;
+  }
+  for (uint8_t i = 0; i < pipeline_tasks_used; i++)
+  {
+#if defined(ARDUINO_ARCH_ESP32)
+    while (!pipeline_tasks[i].stopped)
+    {
+      vTaskDelay(1);
+    }
+#else
+    pthread_join(pipeline_tasks[i].thread, NULL);
+#endif
+  }
+  pipeline_tasks_used = 0;
+}
+
+uint8_t pipeline_task_count()
+{
+  return pipeline_tasks_used;
+}
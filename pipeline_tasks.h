@@ -0,0 +1,41 @@
+/***************************************************************
+//   Task pipeline for the signal chain
+//
+//   Acquisition (the SPI bus task in sensor_acquisition) runs on one
+//   ESP32 core; filtering, HR/SpO2/resp estimation and packet framing,
+//   and the serial output run as tasks on the other. Stages are joined
+//   by bounded spsc_rings, so a slow stage only ever delays the stages
+//   after it and never the sample timing.
+//
+//   A stage is a step function that does whatever work is waiting and
+//   returns true if it did any. Its task calls it again at once while
+//   it is busy and sleeps idle_ms when it is not. The same step
+//   functions can be called in turn from loop() instead.
+//
+//   On the host the tasks are pthreads, priority and core are ignored.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef pipeline_tasks_h
+#define pipeline_tasks_h
+
+#include "Arduino.h"
+
+// Core 0 is free with WiFi and Bluetooth off, Arduino's loop() is on core 1
+#define ACQ_TASK_CORE       0
+#define DSP_TASK_CORE       1
+
+#define PIPELINE_MAX_TASKS  4
+
+typedef bool (*pipeline_step)(void);
+
+// false if the task could not be created
+bool pipeline_task_start(const char *name, pipeline_step step, uint32_t idle_ms,
+                         uint32_t stack_bytes, uint8_t priority, uint8_t core);
+// Stop every task after its current step and wait for it to finish
+void pipeline_task_stop_all();
+uint8_t pipeline_task_count();
+
+#endif
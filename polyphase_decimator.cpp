@@ -0,0 +1,90 @@
+/***************************************************************
+//   Polyphase decimating FIR for the oximeter channels
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "polyphase_decimator.h"
+
+polyphase_decimator::polyphase_decimator() : coeffs(NULL), taps(0), factor(1), phase_taps(0),
+                                             phase(0), head(0), seeded(false)
+{
+}
+
+bool polyphase_decimator::init(const int16_t *coeff_table, uint16_t n_taps, uint8_t n_factor)
+{
+  if (coeff_table == NULL || n_factor == 0 || n_taps == 0 || (n_taps % n_factor) != 0 ||
+      (n_taps / n_factor) > DECIMATOR_MAX_PHASE_TAPS)
+  {
+    coeffs = NULL;
+    return false;
+  }
+  coeffs = coeff_table;
+  taps = n_taps;
+  factor = n_factor;
+  phase_taps = n_taps / n_factor;
+  reset();
+  return true;
+}
+
+void polyphase_decimator::reset()
+{
+  memset(acc, 0, sizeof(acc));
+  phase = 0;
+  head = 0;
+  seeded = false;
+}
+
+// Output y[m] = sum h[j] * x[n-j] completes at the last sample of its
+// block of factor inputs. A sample that arrives phase samples into a
+// block is j = factor-1-phase taps back from the end of this block,
+// factor more taps back from the end of the next, and so on.
+void polyphase_decimator::accumulate(int32_t sample)
+{
+  const int16_t *h = &coeffs[factor - 1 - phase];
+  uint8_t slot = head;
+  for (uint8_t q = 0; q < phase_taps; q++)
+  {
+    acc[slot] += (int64_t)(*h) * sample;
+    h += factor;
+    if (++slot == phase_taps)
+    {
+      slot = 0;
+    }
+  }
+}
+
+bool polyphase_decimator::push(int32_t sample, int32_t *out)
+{
+  if (coeffs == NULL)
+  {
+    return false;
+  }
+  // Start as if the input had always been at its first value, rather
+  // than ramping up from zero through a whole filter length
+  if (!seeded)
+  {
+    seeded = true;
+    for (uint16_t n = 0; n < taps; n++)
+    {
+      int32_t discard;
+      push(sample, &discard);
+    }
+  }
+
+  accumulate(sample);
+  if (++phase < factor)
+  {
+    return false;
+  }
+  phase = 0;
+  // Q15 coefficients
+  *out = (int32_t)(acc[head] >> 15);
+  acc[head] = 0;
+  if (++head == phase_taps)
+  {
+    head = 0;
+  }
+  return true;
+}
@@ -0,0 +1,53 @@
+/***************************************************************
+//   Polyphase decimating FIR for the oximeter channels
+//
+//   Low pass filters and downsamples by factor in one step, computing
+//   only the outputs that are kept. A taps long filter is split into
+//   factor phases of taps/factor coefficients. Each input sample is
+//   multiplied into the taps/factor outputs it belongs to and one
+//   finished output comes out every factor samples, so the work per
+//   input sample is taps/factor MACs with no sample history to keep.
+//
+//   Coefficients are Q15 with unity DC gain (sum 32768). Inputs are the
+//   22 bit AFE4490 values, accumulated in 64 bits. The table is not
+//   copied and must outlive the decimator.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef polyphase_decimator_h
+#define polyphase_decimator_h
+
+#include "Arduino.h"
+
+// Longest phase - taps / factor
+#define DECIMATOR_MAX_PHASE_TAPS  16
+
+class polyphase_decimator
+{
+  public:
+    polyphase_decimator();
+    // taps must be a multiple of factor, returns false otherwise
+    bool init(const int16_t *coeffs, uint16_t taps, uint8_t factor);
+    // Forget past input, the next sample seeds the filter
+    void reset();
+    // Add one input sample, true when *out holds a new decimated sample
+    bool push(int32_t sample, int32_t *out);
+
+  private:
+    void accumulate(int32_t sample);
+
+    const int16_t *coeffs;
+    uint16_t taps;
+    uint8_t factor;
+    uint8_t phase_taps;
+    // Input samples since the last output
+    uint8_t phase;
+    // Accumulator of the next output to complete
+    uint8_t head;
+    bool seeded;
+    int64_t acc[DECIMATOR_MAX_PHASE_TAPS];
+};
+
+#endif
@@ -0,0 +1,197 @@
+/***************************************************************
+//   Respiration rate from the oximeter waveform
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "ppg_resp_rate.h"
+
+#define RESP_SPS      ((double)RESP_INPUT_SPS / RESP_DECIMATE)
+#define RESP_BIN_HZ   (RESP_SPS / RESP_FFT_SIZE)
+// DC gain of the CIC, RESP_DECIMATE ^ RESP_CIC_ORDER
+#define RESP_CIC_GAIN (RESP_DECIMATE * RESP_DECIMATE * RESP_DECIMATE)
+
+ppg_resp_rate::ppg_resp_rate() : plan(FFT_WIN_TYP_BLACKMAN_HARRIS)
+{
+  reset();
+}
+
+void ppg_resp_rate::reset()
+{
+  rate = 0;
+  confidence = 0;
+  valid = false;
+  memset(integrator, 0, sizeof(integrator));
+  memset(comb, 0, sizeof(comb));
+  block_count = 0;
+  memset(history, 0, sizeof(history));
+  head = 0;
+  filled = 0;
+  since_analysis = 0;
+  step = 0;
+  analysis_heart_rate = 0;
+  memset(recent_power, 0, sizeof(recent_power));
+  memset(power, 0, sizeof(power));
+  analyses = 0;
+}
+
+bool ppg_resp_rate::push(int32_t ir, int16_t heart_rate)
+{
+  bool updated = false;
+  // One part of the analysis a sample
+  switch (step)
+  {
+    case 1:
+      load_window();
+      step = 2;
+      break;
+    case 2:
+      {
+        arduinoFFTFloat FFT(vReal, vImag, &plan, RESP_SPS);
+        FFT.ComputeReal(FFT_FORWARD);
+      }
+      step = 3;
+      break;
+    case 3:
+      average_power();
+      find_peak();
+      step = 0;
+      updated = true;
+      break;
+    default:
+      break;
+  }
+
+  uint32_t x = (uint32_t)ir;
+  for (int i = 0; i < RESP_CIC_ORDER; i++)
+  {
+    integrator[i] += x;
+    x = integrator[i];
+  }
+  if (++block_count < RESP_DECIMATE)
+  {
+    return updated;
+  }
+  block_count = 0;
+  for (int i = 0; i < RESP_CIC_ORDER; i++)
+  {
+    uint32_t delayed = comb[i];
+    comb[i] = x;
+    x -= delayed;
+  }
+  // IR_decimated is a 22 bit code - under 2^22 even at 1.46 times full
+  // scale, the most the decimator's negative taps can give - and the
+  // gain is 4^3, 6 bits, so the difference is under 2^28 and exact in
+  // 32 bits however the integrators wrap. The float keeps 24 bits of
+  // it, an error under 1/8 of an input count
+  history[head] = (float)(int32_t)x / RESP_CIC_GAIN;
+  head = (head + 1) % RESP_FFT_SIZE;
+  if (filled < RESP_FFT_SIZE)
+  {
+    filled++;
+  }
+  // The three steps take fewer samples than RESP_DECIMATE, so the last
+  // analysis is always done by the time the next one is due
+  if (filled == RESP_FFT_SIZE && ++since_analysis >= RESP_HOP && step == 0)
+  {
+    since_analysis = 0;
+    analysis_heart_rate = heart_rate;
+    step = 1;
+  }
+  return updated;
+}
+
+// The history, oldest first, less its straight line fit and windowed. A
+// drift over the 20 s would otherwise spread into the lowest bins
+void ppg_resp_rate::load_window()
+{
+  const float mid = (RESP_FFT_SIZE - 1) / 2.0f;
+  float mean = 0;
+  for (int i = 0; i < RESP_FFT_SIZE; i++)
+  {
+    mean += history[i];
+  }
+  mean /= RESP_FFT_SIZE;
+  float sxy = 0, sxx = 0;
+  for (int i = 0; i < RESP_FFT_SIZE; i++)
+  {
+    float y = history[(head + i) % RESP_FFT_SIZE] - mean;
+    sxy += (i - mid) * y;
+    sxx += (i - mid) * (i - mid);
+  }
+  float slope = sxy / sxx;
+  for (int i = 0; i < RESP_FFT_SIZE; i++)
+  {
+    vReal[i] = history[(head + i) % RESP_FFT_SIZE] - mean - slope * (i - mid);
+  }
+  arduinoFFTFloat FFT(vReal, vImag, &plan, RESP_SPS);
+  FFT.Windowing(FFT_WIN_TYP_BLACKMAN_HARRIS, FFT_FORWARD);
+}
+
+// Only the band and a bin either side are needed. Their power replaces
+// the oldest of the last RESP_AVERAGE analyses, and the mean of those is
+// searched. A plain mean rather than a decaying one: while the pulse is
+// in the band its bins are passed over but still hold its power, and
+// when the heart rate moves on that has to be gone within a few
+// analyses, not left to decay
+void ppg_resp_rate::average_power()
+{
+  float *latest = recent_power[analyses % RESP_AVERAGE];
+  for (int k = 0; k < RESP_BAND_BINS; k++)
+  {
+    latest[k] = vReal[k] * vReal[k] + vImag[k] * vImag[k];
+  }
+  analyses++;
+  int count = (analyses < RESP_AVERAGE) ? (int)analyses : RESP_AVERAGE;
+  for (int k = 0; k < RESP_BAND_BINS; k++)
+  {
+    float sum = 0;
+    for (int a = 0; a < count; a++)
+    {
+      sum += recent_power[a][k];
+    }
+    power[k] = sum / count;
+  }
+}
+
+void ppg_resp_rate::find_peak()
+{
+  int first = (int)(RESP_MIN_HZ / RESP_BIN_HZ + 0.5);
+  int last = RESP_BAND_BINS - 2;
+  int heart_bin = -1 - RESP_HR_GUARD_BINS;
+  if (analysis_heart_rate > 0)
+  {
+    heart_bin = (int)(analysis_heart_rate / 60.0 / RESP_BIN_HZ + 0.5);
+  }
+
+  float band_power = 0;
+  int peak = 0;
+  for (int k = first; k <= last; k++)
+  {
+    if (abs(k - heart_bin) <= RESP_HR_GUARD_BINS)
+    {
+      continue;
+    }
+    band_power += power[k];
+    if (power[k] > power[k - 1] && power[k] >= power[k + 1] && (peak == 0 || power[k] > power[peak]))
+    {
+      peak = k;
+    }
+  }
+  if (peak == 0 || band_power <= 0)
+  {
+    rate = 0;
+    confidence = 0;
+    valid = false;
+    return;
+  }
+
+  // Parabola through the peak and its neighbours
+  float a = power[peak - 1], b = power[peak], c = power[peak + 1];
+  float delta = 0.5f * (a - c) / (a - 2.0f * b + c);
+  float share = 100.0f * (a + b + c) / band_power;
+  confidence = (int16_t)(share > 100.0f ? 100.0f : share);
+  valid = confidence >= RESP_MIN_CONFIDENCE;
+  rate = valid ? (int16_t)((peak + delta) * RESP_BIN_HZ * 60.0 + 0.5) : 0;
+}
@@ -0,0 +1,111 @@
+/***************************************************************
+//   Respiration rate from the oximeter waveform
+//
+//   Breathing moves the PPG baseline up and down (venous return) and
+//   changes the size of the pulse, and with it the mean over a beat,
+//   both at the respiration rate. The decimated 25 SPS IR is taken down
+//   by RESP_DECIMATE to 6.25 SPS through three cascaded 4 sample
+//   averages (a CIC filter - a running sum and a difference a stage),
+//   and every RESP_HOP of those samples the last RESP_FFT_SIZE (20 s)
+//   are detrended, Blackman-Harris windowed and put through arduinoFFT.
+//   The power in each bin up to RESP_MAX_HZ is averaged over the last
+//   RESP_AVERAGE analyses, and the largest peak between RESP_MIN_HZ
+//   and RESP_MAX_HZ, interpolated between bins, is the rate.
+//
+//   The pulse is 10 to 30 times the size of the breathing, so it is
+//   kept out of the band three ways:
+//     the bins around the heart rate are passed over - at low heart
+//     rates the pulse itself falls in the band
+//     the window's sidelobes are over 90 dB down (Hann's are 31 dB, and
+//     the pulse leaking through them is the largest thing in the band
+//     when there is little breathing)
+//     the harmonics near 6.25 Hz, which fold down into the band (the
+//     fifth of 80 /min lands at 25 /min), are over 60 dB down after the
+//     three averages. Going down to 3.125 SPS instead would halve the
+//     FFT but fold in the strong second and third harmonics.
+//   Breathing faster than half the heart rate cannot be told from the
+//   pulse less the breathing, which the pulse height modulation puts in
+//   the band too.
+//
+//   confidence is the share of the band's power in the peak and its two
+//   neighbours, in percent. On one window noise alone can reach 85; with
+//   the average, where a breathing peak stays put and noise peaks move,
+//   it stays near 60 and a baseline swing half the sample noise reaches
+//   70, which is where RESP_MIN_CONFIDENCE is set. Below it, or before
+//   the first window is full, the rate is not valid and reads 0.
+//
+//   One analysis is spread over the next three decimated samples
+//   (window, FFT, peak search), so no push() takes more than a part of
+//   it and the processing task keeps up with the AFE4490 samples.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef ppg_resp_rate_h
+#define ppg_resp_rate_h
+
+#include "Arduino.h"
+#include "arduinoFFT.h"
+
+#define RESP_INPUT_SPS       25
+#define RESP_DECIMATE        4       // 25 -> 6.25 SPS
+#define RESP_CIC_ORDER       3
+#define RESP_FFT_SIZE        128     // 20.5 s, bins 0.049 Hz (2.9 /min) apart
+#define RESP_HOP             16      // a new estimate every 2.56 s
+#define RESP_MIN_HZ          0.1
+#define RESP_MAX_HZ          1.0
+#define RESP_BAND_BINS       22      // bins 0 to RESP_MAX_HZ and one more
+#define RESP_HR_GUARD_BINS   3       // passed over either side of the heart rate
+#define RESP_AVERAGE         4       // analyses the band power is averaged over
+#define RESP_MIN_CONFIDENCE  70
+
+class ppg_resp_rate
+{
+  public:
+    ppg_resp_rate();
+    // Forget all samples, as at power up
+    void reset();
+    // One decimated IR sample and the current heart rate (0 if not
+    // known) - true when a new estimate is out
+    bool push(int32_t ir, int16_t heart_rate);
+
+    // Breaths per minute, 0 while not valid
+    int16_t rate;
+    // Percent of the band's power in the peak
+    int16_t confidence;
+    bool valid;
+
+  private:
+    void load_window();
+    void average_power();
+    void find_peak();
+
+    // CIC integrators at 25 SPS and combs at 6.25 SPS - unsigned, as
+    // the integrators are meant to wrap
+    uint32_t integrator[RESP_CIC_ORDER];
+    uint32_t comb[RESP_CIC_ORDER];
+    uint8_t block_count;
+    // The last RESP_FFT_SIZE filtered samples, oldest at head
+    float history[RESP_FFT_SIZE];
+    uint8_t head;
+    uint16_t filled;
+    uint8_t since_analysis;
+    // Analysis step due on the next push, 0 when idle
+    uint8_t step;
+    int16_t analysis_heart_rate;
+
+    // Twiddles, bit reversal and window, worked out once rather than on
+    // every analysis. Single precision, which the ESP32 FPU does
+    arduinoFFTPlanN<RESP_FFT_SIZE, float> plan;
+    float vReal[RESP_FFT_SIZE];
+    // A real FFT - only the bins up to half the sample rate
+    float vImag[RESP_FFT_SIZE / 2 + 1];
+    // Power over the band and a bin either side in the last few analyses,
+    // and their mean
+    float recent_power[RESP_AVERAGE][RESP_BAND_BINS];
+    float power[RESP_BAND_BINS];
+    uint32_t analyses;
+};
+
+#endif
@@ -0,0 +1,333 @@
+/***************************************************************
+//   Lossless coding of a block of waveform samples
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "sample_codec.h"
+
+// The difference between neighbours, and a sample back from it, modulo
+// 2^32 - any two int32 values round trip, where a signed subtraction
+// could overflow
+static inline int32_t sample_delta(int32_t sample, int32_t previous)
+{
+  return (int32_t)((uint32_t)sample - (uint32_t)previous);
+}
+
+static inline int32_t sample_undelta(int32_t previous, int32_t delta)
+{
+  return (int32_t)((uint32_t)previous + (uint32_t)delta);
+}
+
+static size_t put_varint(uint32_t value, uint8_t *out, size_t max)
+{
+  size_t i = 0;
+  while (value >= 0x80)
+  {
+    if (i >= max)
+    {
+      return 0;
+    }
+    out[i++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  if (i >= max)
+  {
+    return 0;
+  }
+  out[i++] = (uint8_t)value;
+  return i;
+}
+
+static size_t get_varint(const uint8_t *in, size_t len, uint32_t *value)
+{
+  uint32_t result = 0;
+  for (size_t i = 0; i < len && i < 5; i++)
+  {
+    result |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+    if ((in[i] & 0x80) == 0)
+    {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Bit stream for the Rice coder, MSB first
+
+typedef struct bit_Writer{
+  uint8_t *out;
+  size_t max;
+  size_t bytes;
+  uint32_t acc;
+  uint8_t bits;
+  bool overflow;
+}bit_writer;
+
+static void put_bits(bit_writer *w, uint32_t value, uint8_t count)
+{
+  while (count > 0)
+  {
+    // At most 24 bits at a time so acc never overflows
+    uint8_t take = count > 24 ? 24 : count;
+    count -= take;
+    w->acc = (w->acc << take) | ((value >> count) & ((1UL << take) - 1));
+    w->bits += take;
+    while (w->bits >= 8)
+    {
+      w->bits -= 8;
+      if (w->bytes >= w->max)
+      {
+        w->overflow = true;
+        return;
+      }
+      w->out[w->bytes++] = (uint8_t)(w->acc >> w->bits);
+    }
+  }
+}
+
+static void put_ones(bit_writer *w, uint32_t count)
+{
+  while (count >= 24)
+  {
+    put_bits(w, 0xFFFFFF, 24);
+    count -= 24;
+  }
+  put_bits(w, (1UL << count) - 1, (uint8_t)count);
+}
+
+static void flush_bits(bit_writer *w)
+{
+  if (w->bits > 0)
+  {
+    put_bits(w, 0, 8 - w->bits);
+  }
+}
+
+typedef struct bit_Reader{
+  const uint8_t *in;
+  size_t len;
+  size_t pos;       // bit position
+}bit_reader;
+
+// A run of ones and the zero that ends it, a byte at a time - or limit
+// ones and no zero
+static bool get_unary(bit_reader *r, uint32_t limit, uint32_t *count)
+{
+  uint32_t q = 0;
+  for (;;)
+  {
+    if ((r->pos >> 3) >= r->len)
+    {
+      return false;
+    }
+    uint8_t offset = r->pos & 7;
+    uint32_t avail = 8 - offset;
+    uint32_t bits = (uint32_t)(uint8_t)(r->in[r->pos >> 3] << offset) << 24;
+    uint32_t ones = (uint32_t)__builtin_clz(~bits);
+    if (ones > avail)
+    {
+      ones = avail;
+    }
+    if (q + ones >= limit)
+    {
+      r->pos += limit - q;
+      *count = limit;
+      return true;
+    }
+    q += ones;
+    r->pos += ones;
+    if (ones < avail)
+    {
+      r->pos++;
+      *count = q;
+      return true;
+    }
+  }
+}
+
+static bool get_bits(bit_reader *r, uint8_t count, uint32_t *value)
+{
+  if (((r->pos + count + 7) >> 3) > r->len)
+  {
+    return false;
+  }
+  size_t at = r->pos >> 3;
+  if (count == 0)
+  {
+    *value = 0;
+    return true;
+  }
+  // Up to 24 bits from one 32 bit window, when the input runs that far
+  if (count <= 24 && at + 4 <= r->len)
+  {
+    uint32_t window = (uint32_t)r->in[at] << 24 | (uint32_t)r->in[at + 1] << 16
+                      | (uint32_t)r->in[at + 2] << 8 | r->in[at + 3];
+    *value = (window << (r->pos & 7)) >> (32 - count);
+    r->pos += count;
+    return true;
+  }
+  // Otherwise a byte at a time
+  uint32_t result = 0;
+  while (count > 0)
+  {
+    uint8_t offset = r->pos & 7;
+    uint8_t take = 8 - offset;
+    if (take > count)
+    {
+      take = count;
+    }
+    uint32_t byte = r->in[r->pos >> 3];
+    result = (result << take) | ((byte >> (8 - offset - take)) & ((1U << take) - 1));
+    r->pos += take;
+    count -= take;
+  }
+  *value = result;
+  return true;
+}
+
+// k near log2 of the mean value, which minimises the expected length
+static uint8_t rice_parameter(const int32_t *samples, uint16_t n)
+{
+  if (n < 2)
+  {
+    return 0;
+  }
+  uint64_t sum = 0;
+  for (uint16_t i = 1; i < n; i++)
+  {
+    sum += zigzag_encode(sample_delta(samples[i], samples[i - 1]));
+  }
+  uint32_t count = n - 1;
+  uint8_t k = 0;
+  while (k < 30 && ((uint64_t)count << (k + 1)) <= sum)
+  {
+    k++;
+  }
+  return k;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+size_t sample_encode(uint8_t coder, const int32_t *samples, uint16_t n, uint8_t *out, size_t max)
+{
+  if (n == 0)
+  {
+    return 0;
+  }
+  size_t used = put_varint(zigzag_encode(samples[0]), out, max);
+  if (used == 0)
+  {
+    return 0;
+  }
+
+  if (coder == SAMPLE_CODER_VARINT)
+  {
+    for (uint16_t i = 1; i < n; i++)
+    {
+      size_t bytes = put_varint(zigzag_encode(sample_delta(samples[i], samples[i - 1])), out + used, max - used);
+      if (bytes == 0)
+      {
+        return 0;
+      }
+      used += bytes;
+    }
+    return used;
+  }
+
+  if (coder != SAMPLE_CODER_RICE || used >= max)
+  {
+    return 0;
+  }
+  uint8_t k = rice_parameter(samples, n);
+  out[used++] = k;
+  bit_writer w = {out + used, max - used, 0, 0, 0, false};
+  for (uint16_t i = 1; i < n; i++)
+  {
+    uint32_t value = zigzag_encode(sample_delta(samples[i], samples[i - 1]));
+    uint32_t q = value >> k;
+    if (q < RICE_ESCAPE)
+    {
+      put_ones(&w, q);
+      put_bits(&w, 0, 1);
+      put_bits(&w, value, k);
+    }
+    else
+    {
+      put_ones(&w, RICE_ESCAPE);
+      put_bits(&w, value, 32);
+    }
+  }
+  flush_bits(&w);
+  return w.overflow ? 0 : used + w.bytes;
+}
+
+size_t sample_decode(uint8_t coder, const uint8_t *in, size_t len, int32_t *samples, uint16_t n)
+{
+  if (n == 0)
+  {
+    return 0;
+  }
+  uint32_t value;
+  size_t used = get_varint(in, len, &value);
+  if (used == 0)
+  {
+    return 0;
+  }
+  samples[0] = zigzag_decode(value);
+
+  if (coder == SAMPLE_CODER_VARINT)
+  {
+    for (uint16_t i = 1; i < n; i++)
+    {
+      size_t bytes = get_varint(in + used, len - used, &value);
+      if (bytes == 0)
+      {
+        return 0;
+      }
+      used += bytes;
+      samples[i] = sample_undelta(samples[i - 1], zigzag_decode(value));
+    }
+    return used;
+  }
+
+  if (coder != SAMPLE_CODER_RICE || used >= len)
+  {
+    return 0;
+  }
+  uint8_t k = in[used++];
+  if (k > 31)
+  {
+    return 0;
+  }
+  bit_reader r = {in + used, len - used, 0};
+  for (uint16_t i = 1; i < n; i++)
+  {
+    uint32_t q;
+    if (!get_unary(&r, RICE_ESCAPE, &q))
+    {
+      return 0;
+    }
+    if (q == RICE_ESCAPE)
+    {
+      if (!get_bits(&r, 32, &value))
+      {
+        return 0;
+      }
+    }
+    else
+    {
+      uint32_t low;
+      if (!get_bits(&r, k, &low))
+      {
+        return 0;
+      }
+      value = (q << k) | low;
+    }
+    samples[i] = sample_undelta(samples[i - 1], zigzag_decode(value));
+  }
+  return used + ((r.pos + 7) >> 3);
+}
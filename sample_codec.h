@@ -0,0 +1,60 @@
+/***************************************************************
+//   Lossless coding of a block of waveform samples
+//
+//   The ECG and PPG move only a little from one sample to the next, so
+//   each block is sent as its first value and then the differences
+//   between neighbours, zig-zag mapped (0, -1, 1, -2 ... -> 0, 1, 2,
+//   3 ...) so small changes of either sign become small numbers. Two
+//   ways of writing those numbers:
+//
+//   SAMPLE_CODER_VARINT - 7 bits per byte, top bit set while more
+//     follow. Byte aligned and cheap: a difference under 64 takes one
+//     byte, under 8192 two.
+//   SAMPLE_CODER_RICE - one k per block, chosen from the mean
+//     difference; each value is (value >> k) in unary then its low k
+//     bits. Tighter on noisy signals where the differences spread over
+//     a few bits, at some extra cost per bit. Values whose unary part
+//     would be RICE_ESCAPE or more are written as RICE_ESCAPE ones and
+//     then 32 raw bits.
+//
+//   A block is self contained - its first value is coded from zero -
+//   so a lost frame never breaks the one after it.
+//
+//   Varint block: first value, then n-1 differences, all varints
+//   Rice block:   first value as a varint, k (one byte), then n-1
+//                 differences as a bit stream, MSB first, padded to a
+//                 whole byte
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef sample_codec_h
+#define sample_codec_h
+
+#include "Arduino.h"
+
+#define SAMPLE_CODER_VARINT 0
+#define SAMPLE_CODER_RICE   1
+#define SAMPLE_CODER_COUNT  2
+
+#define RICE_ESCAPE 16
+
+// Code n samples into out - bytes written, or 0 if it would need more
+// than max bytes
+size_t sample_encode(uint8_t coder, const int32_t *samples, uint16_t n, uint8_t *out, size_t max);
+
+// Decode n samples from in - bytes used, or 0 if in is short or invalid
+size_t sample_decode(uint8_t coder, const uint8_t *in, size_t len, int32_t *samples, uint16_t n);
+
+inline uint32_t zigzag_encode(int32_t value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t zigzag_decode(uint32_t value)
+{
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+#endif
@@ -0,0 +1,503 @@
+/***************************************************************
+//   Interrupt driven SPI acquisition for the ADS1292R and AFE4490
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "sensor_acquisition.h"
+#include "ADS1292r.h"
+#include "myAFE4490_Oximeter.h"
+#include "pipeline_tasks.h"
+#include <SPI.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// VSPI - the bus SPI.begin() uses by default
+#define ACQ_SPI_HOST      VSPI_HOST
+#define ACQ_DMA_CHANNEL   1
+#define ACQ_PIN_SCK       18
+#define ACQ_PIN_MISO      19
+#define ACQ_PIN_MOSI      23
+#define ACQ_TASK_STACK    2048
+
+// Notification bits from the DRDY handlers to the bus task
+#define ACQ_NOTIFY_ECG    0x01
+#define ACQ_NOTIFY_PPG    0x02
+#define ACQ_NOTIFY_REG    0x04
+
+static spi_device_handle_t ads_device = NULL;
+static spi_device_handle_t afe_device = NULL;
+static TaskHandle_t bus_task_handle = NULL;
+static portMUX_TYPE acq_mux = portMUX_INITIALIZER_UNLOCKED;
+// DMA buffers, word aligned and a whole number of words
+static DMA_ATTR uint8_t ads_tx_buffer[12];
+static DMA_ATTR uint8_t ads_rx_buffer[12];
+static spi_transaction_t ads_trans;
+static spi_transaction_t afe_trans[3];
+// The ADS1292R chip select is driven in software, so that a command can
+// hold it low across bytes sent one at a time (ads_transfer). Frame
+// reads leave user NULL and have it dropped and raised around them
+#define ACQ_CS_HELD       ((void *)1)
+static int ads_select_pin = -1;
+
+static void IRAM_ATTR ads_select(spi_transaction_t *t)
+{
+  if (t->user != ACQ_CS_HELD)
+  {
+    gpio_set_level((gpio_num_t)ads_select_pin, 0);
+  }
+}
+
+static void IRAM_ATTR ads_deselect(spi_transaction_t *t)
+{
+  if (t->user != ACQ_CS_HELD)
+  {
+    gpio_set_level((gpio_num_t)ads_select_pin, 1);
+  }
+}
+#endif
+
+// Conversion stamped by a DRDY handler and not yet read off the chip
+static volatile bool ecg_pending = false, ppg_pending = false;
+static volatile uint32_t ecg_pending_us = 0, ppg_pending_us = 0;
+
+// Interrupt handlers are static - they find the instance here
+static sensor_acquisition *acquisition_instance = NULL;
+
+sensor_acquisition::sensor_acquisition()
+    : ads_cs(-1), ads_drdy(-1), afe_cs(-1), afe_drdy(-1), running(false),
+      ecg_missed(0), ppg_missed(0)
+{
+}
+
+bool sensor_acquisition::begin(const int ads_chip_select, const int ads_data_ready,
+                               const int afe_chip_select, const int afe_data_ready)
+{
+  if (running)
+  {
+    end();
+  }
+  ads_cs = ads_chip_select;
+  ads_drdy = ads_data_ready;
+  afe_cs = afe_chip_select;
+  afe_drdy = afe_data_ready;
+  ecg_ring.reset();
+  ppg_ring.reset();
+  reg_requests.reset();
+  reg_results.reset();
+  ecg_missed = ppg_missed = 0;
+  ecg_pending = ppg_pending = false;
+  acquisition_instance = this;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  // Hand the bus from the Arduino SPI class to the IDF driver
+  SPI.end();
+
+  spi_bus_config_t bus;
+  memset(&bus, 0, sizeof(bus));
+  bus.mosi_io_num = ACQ_PIN_MOSI;
+  bus.miso_io_num = ACQ_PIN_MISO;
+  bus.sclk_io_num = ACQ_PIN_SCK;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = sizeof(ads_rx_buffer);
+  if (spi_bus_initialize(ACQ_SPI_HOST, &bus, ACQ_DMA_CHANNEL) != ESP_OK)
+  {
+    return false;
+  }
+
+  spi_device_interface_config_t dev;
+  memset(&dev, 0, sizeof(dev));
+  dev.clock_speed_hz = ACQ_SPI_CLOCK_HZ;
+  dev.queue_size = 4;
+  dev.mode = 1;                       // ADS1292R
+  dev.spics_io_num = -1;
+  dev.pre_cb = ads_select;
+  dev.post_cb = ads_deselect;
+  ads_select_pin = ads_cs;
+  pinMode(ads_cs, OUTPUT);
+  digitalWrite(ads_cs, HIGH);
+  if (spi_bus_add_device(ACQ_SPI_HOST, &dev, &ads_device) != ESP_OK)
+  {
+    spi_bus_free(ACQ_SPI_HOST);
+    return false;
+  }
+  dev.mode = 0;                       // AFE4490
+  dev.spics_io_num = afe_cs;
+  dev.pre_cb = NULL;
+  dev.post_cb = NULL;
+  if (spi_bus_add_device(ACQ_SPI_HOST, &dev, &afe_device) != ESP_OK)
+  {
+    spi_bus_remove_device(ads_device);
+    spi_bus_free(ACQ_SPI_HOST);
+    return false;
+  }
+
+  // ADS1292R in RDATAC - clock out a frame with dummy bytes
+  memset(ads_tx_buffer, CONFIG_SPI_MASTER_DUMMY, sizeof(ads_tx_buffer));
+  memset(&ads_trans, 0, sizeof(ads_trans));
+  ads_trans.length = ADS1292R_FRAME_BYTES * 8;
+  ads_trans.tx_buffer = ads_tx_buffer;
+  ads_trans.rx_buffer = ads_rx_buffer;
+
+  // AFE4490 - enable register reads, then LED1VAL (IR) and LED2VAL (RED)
+  static const uint8_t afe_address[3] = { CONTROL0, LED1VAL, LED2VAL };
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    memset(&afe_trans[i], 0, sizeof(afe_trans[i]));
+    afe_trans[i].flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+    afe_trans[i].length = 32;
+    afe_trans[i].tx_data[0] = afe_address[i];
+  }
+  afe_trans[0].tx_data[3] = 0x01;     // SPI_READ
+
+  if (xTaskCreatePinnedToCore(bus_task, "sensor_spi", ACQ_TASK_STACK, this,
+                              configMAX_PRIORITIES - 1, &bus_task_handle, ACQ_TASK_CORE) != pdPASS)
+  {
+    spi_bus_remove_device(afe_device);
+    spi_bus_remove_device(ads_device);
+    spi_bus_free(ACQ_SPI_HOST);
+    return false;
+  }
+#endif
+
+  attachInterrupt(digitalPinToInterrupt(ads_drdy), ecg_data_ready_handler, FALLING);
+  attachInterrupt(digitalPinToInterrupt(afe_drdy), ppg_data_ready_handler, RISING);
+  running = true;
+  return true;
+}
+
+void sensor_acquisition::end()
+{
+  if (!running)
+  {
+    return;
+  }
+  detachInterrupt(digitalPinToInterrupt(ads_drdy));
+  detachInterrupt(digitalPinToInterrupt(afe_drdy));
+#if defined(ARDUINO_ARCH_ESP32)
+  vTaskDelete(bus_task_handle);
+  bus_task_handle = NULL;
+  spi_bus_remove_device(afe_device);
+  spi_bus_remove_device(ads_device);
+  spi_bus_free(ACQ_SPI_HOST);
+  // Give the bus back for register access
+  SPI.begin();
+#endif
+  running = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Data ready interrupts
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+void IRAM_ATTR sensor_acquisition::ecg_data_ready_handler(void)
+{
+  uint32_t now = micros();
+  portENTER_CRITICAL_ISR(&acq_mux);
+  if (ecg_pending)
+  {
+    acquisition_instance->ecg_missed++;
+  }
+  ecg_pending_us = now;
+  ecg_pending = true;
+  portEXIT_CRITICAL_ISR(&acq_mux);
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(bus_task_handle, ACQ_NOTIFY_ECG, eSetBits, &woken);
+  if (woken)
+  {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void IRAM_ATTR sensor_acquisition::ppg_data_ready_handler(void)
+{
+  uint32_t now = micros();
+  portENTER_CRITICAL_ISR(&acq_mux);
+  if (ppg_pending)
+  {
+    acquisition_instance->ppg_missed++;
+  }
+  ppg_pending_us = now;
+  ppg_pending = true;
+  portEXIT_CRITICAL_ISR(&acq_mux);
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(bus_task_handle, ACQ_NOTIFY_PPG, eSetBits, &woken);
+  if (woken)
+  {
+    portYIELD_FROM_ISR();
+  }
+}
+
+// Queues the reads for every conversion flagged since the last pass, so
+// an ECG and a PPG read go out back to back on the DMA queue
+void sensor_acquisition::bus_task(void *param)
+{
+  sensor_acquisition *acq = (sensor_acquisition *)param;
+  for (;;)
+  {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, 0xffffffff, &bits, portMAX_DELAY);
+
+    uint32_t ecg_us = 0, ppg_us = 0;
+    bool do_ecg = false, do_ppg = false;
+    portENTER_CRITICAL(&acq_mux);
+    if (ecg_pending)
+    {
+      ecg_us = ecg_pending_us;
+      ecg_pending = false;
+      do_ecg = true;
+    }
+    if (ppg_pending)
+    {
+      ppg_us = ppg_pending_us;
+      ppg_pending = false;
+      do_ppg = true;
+    }
+    portEXIT_CRITICAL(&acq_mux);
+
+    spi_transaction_t *done;
+    if (do_ecg)
+    {
+      spi_device_queue_trans(ads_device, &ads_trans, portMAX_DELAY);
+    }
+    if (do_ppg)
+    {
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        spi_device_queue_trans(afe_device, &afe_trans[i], portMAX_DELAY);
+      }
+    }
+    if (do_ecg)
+    {
+      spi_device_get_trans_result(ads_device, &done, portMAX_DELAY);
+      acq->complete_ecg(ecg_us, ads_rx_buffer);
+    }
+    if (do_ppg)
+    {
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        spi_device_get_trans_result(afe_device, &done, portMAX_DELAY);
+      }
+      acq->complete_ppg(ppg_us,
+                        ((uint32_t)afe_trans[1].rx_data[1] << 16) | ((uint32_t)afe_trans[1].rx_data[2] << 8) | afe_trans[1].rx_data[3],
+                        ((uint32_t)afe_trans[2].rx_data[1] << 16) | ((uint32_t)afe_trans[2].rx_data[2] << 8) | afe_trans[2].rx_data[3]);
+    }
+    // Nothing is left queued on either device, so register access can
+    // poll the bus
+    acq->run_register_ops();
+  }
+}
+
+uint32_t sensor_acquisition::afe_transfer(uint8_t address, uint32_t data)
+{
+  spi_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+  t.length = 32;
+  t.tx_data[0] = address;
+  t.tx_data[1] = (uint8_t)(data >> 16);
+  t.tx_data[2] = (uint8_t)(data >> 8);
+  t.tx_data[3] = (uint8_t)data;
+  spi_device_polling_transmit(afe_device, &t);
+  return ((uint32_t)t.rx_data[1] << 16) | ((uint32_t)t.rx_data[2] << 8) | t.rx_data[3];
+}
+
+// One command, a byte per transaction with CS held low - the ADS1292R
+// needs 4 tCLK to take in each byte before the next one starts, and
+// before CS goes high
+void sensor_acquisition::ads_transfer(const uint8_t *tx, uint8_t *rx, uint8_t bytes)
+{
+  digitalWrite(ads_cs, LOW);
+  for (uint8_t i = 0; i < bytes; i++)
+  {
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+    t.length = 8;
+    t.tx_data[0] = tx[i];
+    t.user = ACQ_CS_HELD;
+    spi_device_polling_transmit(ads_device, &t);
+    if (rx != NULL)
+    {
+      rx[i] = t.rx_data[0];
+    }
+    delayMicroseconds(ADS1292_DECODE_US);
+  }
+  digitalWrite(ads_cs, HIGH);
+}
+
+#else
+
+// Host - the transfer runs inside the handler on the simulated bus
+void sensor_acquisition::ecg_data_ready_handler(void)
+{
+  acquisition_instance->read_ecg_frame(micros());
+  acquisition_instance->run_register_ops();
+}
+
+void sensor_acquisition::ppg_data_ready_handler(void)
+{
+  acquisition_instance->read_ppg_frame(micros());
+  acquisition_instance->run_register_ops();
+}
+
+void sensor_acquisition::read_ecg_frame(uint32_t timestamp_us)
+{
+  uint8_t data[ADS1292R_FRAME_BYTES];
+  SPI.beginTransaction(SPISettings(ACQ_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE1));
+  digitalWrite(ads_cs, LOW);
+  for (uint8_t i = 0; i < ADS1292R_FRAME_BYTES; i++)
+  {
+    data[i] = SPI.transfer(CONFIG_SPI_MASTER_DUMMY);
+  }
+  digitalWrite(ads_cs, HIGH);
+  SPI.endTransaction();
+  complete_ecg(timestamp_us, data);
+}
+
+void sensor_acquisition::read_ppg_frame(uint32_t timestamp_us)
+{
+  static const uint8_t afe_address[3] = { CONTROL0, LED1VAL, LED2VAL };
+  uint32_t value[3];
+  SPI.beginTransaction(SPISettings(ACQ_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    digitalWrite(afe_cs, LOW);
+    SPI.transfer(afe_address[i]);
+    value[i] = (uint32_t)SPI.transfer(0) << 16;
+    value[i] |= (uint32_t)SPI.transfer(0) << 8;
+    value[i] |= SPI.transfer(i == 0 ? 0x01 : 0);      // SPI_READ in CONTROL0
+    digitalWrite(afe_cs, HIGH);
+  }
+  SPI.endTransaction();
+  complete_ppg(timestamp_us, value[1], value[2]);
+}
+
+uint32_t sensor_acquisition::afe_transfer(uint8_t address, uint32_t data)
+{
+  SPI.beginTransaction(SPISettings(ACQ_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+  digitalWrite(afe_cs, LOW);
+  SPI.transfer(address);
+  uint32_t value = (uint32_t)SPI.transfer((uint8_t)(data >> 16)) << 16;
+  value |= (uint32_t)SPI.transfer((uint8_t)(data >> 8)) << 8;
+  value |= SPI.transfer((uint8_t)data);
+  digitalWrite(afe_cs, HIGH);
+  SPI.endTransaction();
+  return value;
+}
+
+// One command, with the decode time after each byte as on the board
+void sensor_acquisition::ads_transfer(const uint8_t *tx, uint8_t *rx, uint8_t bytes)
+{
+  SPI.beginTransaction(SPISettings(ACQ_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE1));
+  digitalWrite(ads_cs, LOW);
+  for (uint8_t i = 0; i < bytes; i++)
+  {
+    uint8_t in = SPI.transfer(tx[i]);
+    if (rx != NULL)
+    {
+      rx[i] = in;
+    }
+    delayMicroseconds(ADS1292_DECODE_US);
+  }
+  digitalWrite(ads_cs, HIGH);
+  SPI.endTransaction();
+}
+
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Register access
+
+bool sensor_acquisition::request_register(const register_op *op)
+{
+  uint8_t last = op->target == ACQ_TARGET_AFE4490 ? ACQ_AFE_LAST_REG : ACQ_ADS_LAST_REG;
+  if (!running || op->target > ACQ_TARGET_AFE4490 || op->address > last)
+  {
+    return false;
+  }
+  if (!reg_requests.push(*op))
+  {
+    return false;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  xTaskNotify(bus_task_handle, ACQ_NOTIFY_REG, eSetBits);
+#endif
+  return true;
+}
+
+void sensor_acquisition::run_register_ops()
+{
+  register_op op;
+  while (reg_requests.pop(&op))
+  {
+    if (op.target == ACQ_TARGET_AFE4490)
+    {
+      // Writes only take with SPI_READ clear; the conversion reads set
+      // it again themselves
+      if (op.write)
+      {
+        afe_transfer(CONTROL0, 0x000000);
+        afe_transfer(op.address, op.value & 0xFFFFFF);
+      }
+      afe_transfer(CONTROL0, 0x000001);
+      op.value = afe_transfer(op.address, 0);
+    }
+    else
+    {
+      // Registers can only be reached out of RDATAC. Each command is
+      // its own CS low period with the decode gap after every byte
+      uint8_t command[3] = { SDATAC, 0, 0 };
+      uint8_t reply[3];
+      ads_transfer(command, NULL, 1);
+      if (op.write)
+      {
+        command[0] = WREG | op.address;
+        command[1] = 0;
+        command[2] = ads1292r::reg_value(op.address, (uint8_t)op.value);
+        ads_transfer(command, NULL, 3);
+      }
+      command[0] = RREG | op.address;
+      command[1] = 0;
+      command[2] = CONFIG_SPI_MASTER_DUMMY;
+      ads_transfer(command, reply, 3);
+      command[0] = RDATAC;
+      ads_transfer(command, NULL, 1);
+      op.value = reply[2];
+    }
+    op.ok = true;
+    reg_results.push(op);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Decode and hand over - the bus task or host handler is the only producer
+
+void sensor_acquisition::complete_ecg(uint32_t timestamp_us, const uint8_t *data)
+{
+  ads1292r_data decoded;
+  ads1292r::decode_frame(data, &decoded);
+  ecg_sample sample;
+  sample.timestamp_us = timestamp_us;
+  sample.ecg = (int32_t)decoded.raw_ecg;
+  sample.resp = (int32_t)decoded.raw_resp;
+  sample.lead_status = (uint8_t)decoded.status_reg;
+  ecg_ring.push(sample);
+}
+
+void sensor_acquisition::complete_ppg(uint32_t timestamp_us, uint32_t ir, uint32_t red)
+{
+  ppg_sample sample;
+  sample.timestamp_us = timestamp_us;
+  // 22 bit two's complement
+  sample.ir = (int32_t)(ir << 10) >> 10;
+  sample.red = (int32_t)(red << 10) >> 10;
+  ppg_ring.push(sample);
+}
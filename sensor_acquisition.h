@@ -0,0 +1,143 @@
+/***************************************************************
+//   Interrupt driven SPI acquisition for the ADS1292R and AFE4490
+//
+//   Once the front ends are configured, begin() takes over the SPI bus
+//   and both data ready lines. Each DRDY interrupt stamps the time and
+//   has the sensor's read queued on the bus; the completed frame is
+//   decoded into a timestamped sample and pushed onto a per-sensor
+//   spsc_ring that loop() drains with read_ecg() and read_ppg(), one at
+//   a time or in blocks. Samples keep arriving while loop() is busy with
+//   the serial port or the temperature sensor, up to the depth of the
+//   rings, and any lost beyond that are counted.
+//
+//   ESP32: the bus runs under the ESP-IDF SPI master driver with DMA,
+//   one device per sensor so chip select and SPI mode (ADS1292R mode 1,
+//   AFE4490 mode 0) are switched by the driver. spi_device_queue_trans()
+//   cannot be called from an interrupt, so the DRDY handlers notify a
+//   top priority task that queues the transactions on their behalf.
+//
+//   Host: the DRDY handlers run the same transactions straight through
+//   the simulated SPI bus (SPI.hostAttach devices), as if the DMA
+//   completed at once.
+//
+//   Register access while streaming goes through the same context:
+//   request_register() queues it, it runs on the bus between two
+//   conversions, and the value read back comes out of
+//   register_result(). An ADS1292R access leaves RDATAC for its length,
+//   so at most one ECG conversion is lost.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef sensor_acquisition_h
+#define sensor_acquisition_h
+
+#include "Arduino.h"
+#include "spsc_ring.h"
+
+// Status word + 2 channels of 24 bits in RDATAC mode
+#define ADS1292R_FRAME_BYTES  9
+
+// Ring depths - powers of 2, about half a second of each stream
+#define ACQ_ECG_RING_SIZE     64      // 125 SPS
+#define ACQ_PPG_RING_SIZE     256     // 500 SPS
+
+// SPI clock - as SPI_CLOCK_DIV16 from the 80 MHz APB clock
+#define ACQ_SPI_CLOCK_HZ      5000000
+
+// One ADS1292R conversion - 24 bit channels sign extended,
+// lead off bits from the status word as in ads1292r_data
+typedef struct ecg_Sample{
+  uint32_t timestamp_us;
+  int32_t ecg;
+  int32_t resp;
+  uint8_t lead_status;
+}ecg_sample;
+
+// One AFE4490 conversion - 22 bit LED1VAL (IR) and LED2VAL (RED)
+// sign extended
+typedef struct ppg_Sample{
+  uint32_t timestamp_us;
+  int32_t ir;
+  int32_t red;
+}ppg_sample;
+
+// Registers with an address above these are refused
+#define ACQ_ADS_LAST_REG      0x0B
+#define ACQ_AFE_LAST_REG      0x30
+
+#define ACQ_TARGET_ADS1292R   0
+#define ACQ_TARGET_AFE4490    1
+
+// One register read or write - value is written first, then replaced
+// by the value read back
+typedef struct register_Op{
+  uint8_t id;
+  uint8_t target;
+  uint8_t address;
+  bool write;
+  uint32_t value;
+  bool ok;
+}register_op;
+
+class sensor_acquisition
+{
+  public:
+    sensor_acquisition();
+    // Call after the front ends are initialised - returns false if the
+    // bus or the interrupts could not be set up
+    bool begin(const int ads_chip_select, const int ads_data_ready,
+               const int afe_chip_select, const int afe_data_ready);
+    void end();
+
+    // Oldest unread sample, false if the ring is empty
+    bool read_ecg(ecg_sample *sample) { return ecg_ring.pop(sample); }
+    bool read_ppg(ppg_sample *sample) { return ppg_ring.pop(sample); }
+    // Up to max of the oldest unread samples, returns how many
+    uint32_t read_ecg_block(ecg_sample *samples, uint32_t max) { return ecg_ring.pop_block(samples, max); }
+    uint32_t read_ppg_block(ppg_sample *samples, uint32_t max) { return ppg_ring.pop_block(samples, max); }
+
+    // Samples waiting to be read
+    uint32_t ecg_waiting() const { return ecg_ring.size(); }
+    uint32_t ppg_waiting() const { return ppg_ring.size(); }
+    // Samples captured
+    uint32_t ecg_frames() const { return ecg_ring.pushed(); }
+    uint32_t ppg_frames() const { return ppg_ring.pushed(); }
+    // Samples lost because the ring was full, or because a conversion
+    // came before the last one was read off the chip
+    uint32_t ecg_overruns() const { return ecg_ring.overruns() + ecg_missed; }
+    uint32_t ppg_overruns() const { return ppg_ring.overruns() + ppg_missed; }
+
+    // Register access from one other context - false if not running,
+    // the address is out of range or too many are waiting
+    bool request_register(const register_op *op);
+    // A finished request, false if none
+    bool register_result(register_op *op) { return reg_results.pop(op); }
+
+  private:
+    static void ecg_data_ready_handler(void);
+    static void ppg_data_ready_handler(void);
+    static void bus_task(void *param);
+    void read_ecg_frame(uint32_t timestamp_us);
+    void read_ppg_frame(uint32_t timestamp_us);
+    // Called once the transactions for a conversion have completed
+    void complete_ecg(uint32_t timestamp_us, const uint8_t *data);
+    void complete_ppg(uint32_t timestamp_us, uint32_t ir, uint32_t red);
+    // Register requests, run in the bus context
+    void run_register_ops();
+    uint32_t afe_transfer(uint8_t address, uint32_t data);
+    // One ADS1292R command, a byte at a time with the decode gap
+    void ads_transfer(const uint8_t *tx, uint8_t *rx, uint8_t bytes);
+
+    int ads_cs, ads_drdy, afe_cs, afe_drdy;
+    bool running;
+    volatile uint32_t ecg_missed, ppg_missed;
+
+    spsc_ring<ecg_sample, ACQ_ECG_RING_SIZE> ecg_ring;
+    spsc_ring<ppg_sample, ACQ_PPG_RING_SIZE> ppg_ring;
+    spsc_ring<register_op, 4> reg_requests;
+    spsc_ring<register_op, 4> reg_results;
+};
+
+#endif
@@ -0,0 +1,294 @@
+/***************************************************************
+//   Serial/USB data frames
+//
+//   Every frame is 0x0A 0xFA, payload length LSB/MSB, a type byte,
+//   the payload and 0x00 0x0B. Each type is a packed struct, so the
+//   processing stage fills the fields of a frame in place and the
+//   output stage hands the whole frame to Serial in one write.
+//
+//   CES_CMDIF_TYPE_DATA (0x02) - the original 27 byte frame, every
+//   value in every frame
+//    0  Start 0x0A                 13-16  RED LSB first
+//    1  Start 0xFA                 17-18  Temperature LSB first
+//    2  Data length LSB (20)              hundredths of a deg C + 100
+//    3  Data length MSB (0)           19  Resp rate/min
+//    4  Type 0x02                     20  SpO2 % saturation
+//    5-6  ECG LSB first               21  Heart rate BPM
+//    7-8  Resp LSB first              22  BP diastolic - not implemented
+//    9-12 IR LSB first                23  BP systolic - not implemented
+//                                     24  Lead status
+//                                  25-26  Stop 0x00 0x0B
+//
+//   With the packet scheduler the same values go out at their own rates:
+//   CES_CMDIF_TYPE_ECG (0x03)     ECG, resp, lead status - per ADS1292R sample
+//   CES_CMDIF_TYPE_PPG (0x04)     IR, RED - per AFE4490 sample
+//   CES_CMDIF_TYPE_VITALS (0x05)  temperature, resp rate, SpO2, heart rate,
+//                                 BP, lead status - once a second or on change
+//
+//   CES_CMDIF_TYPE_BATCH (0x06) carries a block of samples of each
+//   stream, with a sequence number so the receiver can count lost
+//   frames and a CRC so it can drop damaged ones. Payload, version 1:
+//    0     Version (BATCH_FRAME_VERSION)
+//    1-2   Sequence number LSB first, one more for every batch made
+//    3     Flags - BATCH_FLAG_VITALS if the vitals are included
+//    4     ECG sample count (E)
+//    5     PPG sample count (P)
+//    6     Lead status at the end of the batch
+//    7-    E x ECG, resp - int16 LSB first
+//          P x IR, RED - 24 bit two's complement LSB first
+//          Vitals - 8 bytes as in the 0x05 frame, if flagged
+//    last 2  CRC-16/CCITT-FALSE (crc16.h) of the payload before it, LSB first
+//   Samples within a batch are in order and evenly spaced at the
+//   stream's rate; a receiver that does not know the type skips it
+//   using the length bytes.
+//
+//   CES_CMDIF_TYPE_PACKED_BATCH (0x07) is the same batch with each
+//   channel compressed without loss (sample_codec.h). Payload, version 1:
+//    0-6   As the 0x06 frame
+//    7     Coder - SAMPLE_CODER_VARINT or SAMPLE_CODER_RICE
+//    8-    Four blocks, one per channel: E x ECG, E x resp, P x IR,
+//          P x RED, each coded on its own
+//          Vitals - 8 bytes as in the 0x05 frame, if flagged
+//    last 2  CRC-16/CCITT-FALSE of the payload before it, LSB first
+//   It shares the sequence numbers of the 0x06 frame, and a batch that
+//   would not come out smaller than the raw one is sent as 0x06.
+//
+//   CES_CMDIF_TYPE_STATUS (0x08) - serial link counters, once a second:
+//    0-3   Baud rate
+//    4-7   Bytes written to the UART
+//    8-11  Frames written
+//    12-15 Frames dropped because the queue was full
+//    16-19 Output passes that found the UART TX FIFO full
+//    20    Most frames waiting at once since the last status frame
+//    21    Queue size
+//    22    ECG stream decimation - samples averaged into each one sent
+//    23    PPG stream decimation
+//
+//   CES_CMDIF_TYPE_BAUD (0x09) - baud rate change, 4 byte rate. The host
+//   sends one with the rate it wants; the device answers, still at the
+//   old rate, with the rate it will use - the one asked for if it
+//   supports it, else the current one - and switches as soon as the
+//   answer has left the UART. The host switches when it sees the answer.
+//
+//   CES_CMDIF_TYPE_COMMAND (0x0C) - host to device, one request
+//   (command_channel.h):
+//    0     Command - COMMAND_*
+//    1     Tag, chosen by the host and returned in the answer
+//    2     Target - COMMAND_TARGET_* for register access, else 0
+//    3     Register address, or the coder for COMMAND_STREAM_MODE
+//    4-7   Value - to write, the stream mode, or ECG decimation in
+//          byte 4 and PPG decimation in byte 5
+//    8-9   CRC-16/CCITT-FALSE of bytes 0-7, LSB first
+//   CES_CMDIF_TYPE_ACK (0x0D) - device to host, one per command:
+//    0     Command, as received
+//    1     Tag, as received
+//    2     Result - COMMAND_OK or COMMAND_ERROR_*
+//    3-6   Value - the register read back, the protocol version for
+//          COMMAND_PING, else the setting now in use
+//    7-8   CRC-16/CCITT-FALSE of bytes 0-6, LSB first
+//   The answer goes out in order with the stream, so frames before it
+//   are in the old settings and frames after it in the new.
+//
+//   Multi-byte fields are stored as the CPU holds them, which is the
+//   LSB first order of the frame on the ESP32 (and on x86/ARM hosts).
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef serial_frame_h
+#define serial_frame_h
+
+#include "Arduino.h"
+
+// Packet setup
+// defines start/stop and length Bytes
+#define CES_CMDIF_PKT_START_1 0x0A
+#define CES_CMDIF_PKT_START_2 0xFA
+#define DATA_LENGTH 20
+#define CES_CMDIF_DATA_LEN_LSB 20   // 20 bytes of actual data
+#define CES_CMDIF_DATA_LEN_MSB 0
+#define CES_CMDIF_TYPE_DATA 0x02
+#define CES_CMDIF_TYPE_ECG 0x03
+#define CES_CMDIF_TYPE_PPG 0x04
+#define CES_CMDIF_TYPE_VITALS 0x05
+#define CES_CMDIF_TYPE_BATCH 0x06
+#define CES_CMDIF_TYPE_PACKED_BATCH 0x07
+#define CES_CMDIF_TYPE_STATUS 0x08
+#define CES_CMDIF_TYPE_BAUD 0x09
+#define CES_CMDIF_TYPE_COMMAND 0x0C
+#define CES_CMDIF_TYPE_ACK 0x0D
+#define CES_CMDIF_PKT_STOP_1 0x00
+#define CES_CMDIF_PKT_STOP_2 0x0B
+
+typedef struct __attribute__((packed)) frame_Header{
+  uint8_t start_1;
+  uint8_t start_2;
+  uint8_t length_lsb;
+  uint8_t length_msb;
+  uint8_t type;
+}frame_header;
+
+typedef struct __attribute__((packed)) frame_Footer{
+  uint8_t stop_1;
+  uint8_t stop_2;
+}frame_footer;
+
+// Slow values, in the order the 0x02 frame carries them
+typedef struct __attribute__((packed)) vitals_Payload{
+  int16_t temperature;
+  uint8_t resp_rate;
+  uint8_t spo2;
+  uint8_t heart_rate;
+  uint8_t bp_diastolic;
+  uint8_t bp_systolic;
+  uint8_t status;
+}vitals_payload;
+
+typedef struct __attribute__((packed)) data_Frame{
+  frame_header header;
+  // Payload - DATA_LENGTH bytes
+  int16_t ecg;
+  int16_t resp;
+  int32_t ir;
+  int32_t red;
+  vitals_payload vitals;
+  frame_footer footer;
+}data_frame;
+
+typedef struct __attribute__((packed)) ecg_Frame{
+  frame_header header;
+  int16_t ecg;
+  int16_t resp;
+  uint8_t status;
+  frame_footer footer;
+}ecg_frame;
+
+typedef struct __attribute__((packed)) ppg_Frame{
+  frame_header header;
+  int32_t ir;
+  int32_t red;
+  frame_footer footer;
+}ppg_frame;
+
+typedef struct __attribute__((packed)) vitals_Frame{
+  frame_header header;
+  vitals_payload vitals;
+  frame_footer footer;
+}vitals_frame;
+
+typedef struct __attribute__((packed)) status_Payload{
+  uint32_t baud;
+  uint32_t bytes_sent;
+  uint32_t frames_sent;
+  uint32_t frames_dropped;
+  uint32_t tx_full;
+  uint8_t queue_peak;
+  uint8_t queue_size;
+  uint8_t ecg_decimation;
+  uint8_t ppg_decimation;
+}status_payload;
+
+typedef struct __attribute__((packed)) status_Frame{
+  frame_header header;
+  status_payload status;
+  frame_footer footer;
+}status_frame;
+
+typedef struct __attribute__((packed)) baud_Frame{
+  frame_header header;
+  uint32_t baud;
+  frame_footer footer;
+}baud_frame;
+
+// Command channel
+#define COMMAND_PROTOCOL_VERSION  1
+#define COMMAND_PING              0x01
+#define COMMAND_READ_REGISTER     0x02
+#define COMMAND_WRITE_REGISTER    0x03
+#define COMMAND_STREAM_MODE       0x04
+#define COMMAND_DECIMATION        0x05
+#define COMMAND_TARGET_ADS1292R   0
+#define COMMAND_TARGET_AFE4490    1
+#define COMMAND_OK                0
+#define COMMAND_ERROR_DAMAGED     1   // bad length or CRC
+#define COMMAND_ERROR_UNKNOWN     2   // no such command
+#define COMMAND_ERROR_ARGUMENT    3   // target, register or value out of range
+#define COMMAND_ERROR_BUSY        4   // too many commands waiting
+#define COMMAND_ERROR_FAILED      5   // the register access did not happen
+
+typedef struct __attribute__((packed)) command_Payload{
+  uint8_t command;
+  uint8_t tag;
+  uint8_t target;
+  uint8_t address;
+  uint32_t value;
+  uint16_t crc;
+}command_payload;
+
+typedef struct __attribute__((packed)) ack_Payload{
+  uint8_t command;
+  uint8_t tag;
+  uint8_t result;
+  uint32_t value;
+  uint16_t crc;
+}ack_payload;
+
+typedef struct __attribute__((packed)) ack_Frame{
+  frame_header header;
+  ack_payload ack;
+  frame_footer footer;
+}ack_frame;
+
+#define SERIAL_FRAME_OVERHEAD (sizeof(frame_header) + sizeof(frame_footer))
+
+// Batch frame
+#define BATCH_FRAME_VERSION     1
+#define BATCH_FLAG_VITALS       0x01
+#define BATCH_HEADER_BYTES      7
+#define PACKED_BATCH_HEADER_BYTES 8
+#define BATCH_ECG_SAMPLE_BYTES  4
+#define BATCH_PPG_SAMPLE_BYTES  6
+#define BATCH_CRC_BYTES         2
+// Samples per batch - 40 ms of each stream
+#define BATCH_ECG_SAMPLES       5
+#define BATCH_PPG_SAMPLES       20
+#define BATCH_FRAME_MAX (SERIAL_FRAME_OVERHEAD + BATCH_HEADER_BYTES \
+                         + BATCH_ECG_SAMPLES * BATCH_ECG_SAMPLE_BYTES \
+                         + BATCH_PPG_SAMPLES * BATCH_PPG_SAMPLE_BYTES \
+                         + sizeof(vitals_payload) + BATCH_CRC_BYTES)
+
+static_assert(sizeof(data_frame) == SERIAL_FRAME_OVERHEAD + DATA_LENGTH, "data_frame must match the 27 byte packet");
+
+// Any one frame, as queued for the serial port
+typedef struct serial_Packet{
+  uint16_t length;
+  union{
+    uint8_t bytes[BATCH_FRAME_MAX];
+    frame_header header;
+    data_frame data;
+    ecg_frame ecg;
+    ppg_frame ppg;
+    vitals_frame vitals;
+    status_frame status;
+    ack_frame ack;
+  };
+}serial_packet;
+
+// Header and footer bytes of a frame about to be filled
+// frame_size is the whole frame, header and footer included
+inline void serial_frame_init(serial_packet *packet, uint8_t type, uint16_t frame_size)
+{
+  uint16_t payload_length = frame_size - SERIAL_FRAME_OVERHEAD;
+  packet->length = frame_size;
+  packet->header.start_1 = CES_CMDIF_PKT_START_1;
+  packet->header.start_2 = CES_CMDIF_PKT_START_2;
+  packet->header.length_lsb = (uint8_t)payload_length;
+  packet->header.length_msb = (uint8_t)(payload_length >> 8);
+  packet->header.type = type;
+  frame_footer *footer = (frame_footer *)&packet->bytes[frame_size - sizeof(frame_footer)];
+  footer->stop_1 = CES_CMDIF_PKT_STOP_1;
+  footer->stop_2 = CES_CMDIF_PKT_STOP_2;
+}
+
+#endif
@@ -0,0 +1,225 @@
+/***************************************************************
+//   Serial transport - the output stage's side of the UART
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "serial_transport.h"
+#include "command_channel.h"
+
+// Rates the host may ask for. The CP2102N USB bridge and the ESP32 UART
+// both run to 3 Mbaud, but the output stage tops out at about 1.27 Mbaud
+// (serial_transport.h), so faster rates are refused rather than left to
+// run below their line rate
+static const uint32_t serial_baud_rates[] = {
+  115200, 230400, 460800, 921600, 1000000
+};
+
+enum
+{
+  RX_START_1,
+  RX_START_2,
+  RX_LEN_LSB,
+  RX_LEN_MSB,
+  RX_TYPE,
+  RX_PAYLOAD,
+  RX_STOP_1,
+  RX_STOP_2
+};
+
+serial_transport::serial_transport()
+  : bytes_sent(0), frames_sent(0), tx_full(0), baud_changes(0), current_baud(0), commands(NULL),
+    tx_bytes(NULL), tx_length(0), tx_offset(0), tx_from_queue(false),
+    answer_due(false), switch_baud(0),
+    rx_state(RX_START_1), rx_type(0), rx_length(0), rx_index(0)
+{
+  memset(&baud_answer, 0, sizeof(baud_answer));
+}
+
+void serial_transport::begin(unsigned long baud)
+{
+  current_baud = baud;
+  Serial.begin(baud);
+}
+
+void serial_transport::link_status(status_payload *out) const
+{
+  memset(out, 0, sizeof(*out));
+  out->baud = current_baud;
+  out->bytes_sent = bytes_sent;
+  out->frames_sent = frames_sent;
+  out->tx_full = tx_full;
+}
+
+// Host to device frames, in the same framing as the stream
+void serial_transport::receive()
+{
+  while (Serial.available() > 0)
+  {
+    uint8_t c = (uint8_t)Serial.read();
+    switch (rx_state)
+    {
+    case RX_START_1:
+      rx_state = (c == CES_CMDIF_PKT_START_1) ? RX_START_2 : RX_START_1;
+      break;
+    case RX_START_2:
+      rx_state = (c == CES_CMDIF_PKT_START_2) ? RX_LEN_LSB : RX_START_1;
+      break;
+    case RX_LEN_LSB:
+      rx_length = c;
+      rx_state = RX_LEN_MSB;
+      break;
+    case RX_LEN_MSB:
+      rx_length |= (uint16_t)c << 8;
+      rx_state = RX_TYPE;
+      break;
+    case RX_TYPE:
+      rx_type = c;
+      rx_index = 0;
+      rx_state = (rx_length > 0) ? RX_PAYLOAD : RX_STOP_1;
+      break;
+    case RX_PAYLOAD:
+      // Longer payloads are read past and never acted on
+      if (rx_index < SERIAL_RX_PAYLOAD_MAX)
+      {
+        rx_payload[rx_index] = c;
+      }
+      if (++rx_index == rx_length)
+      {
+        rx_state = RX_STOP_1;
+      }
+      break;
+    case RX_STOP_1:
+      rx_state = (c == CES_CMDIF_PKT_STOP_1) ? RX_STOP_2 : RX_START_1;
+      break;
+    case RX_STOP_2:
+      rx_state = RX_START_1;
+      if (c != CES_CMDIF_PKT_STOP_2)
+      {
+        break;
+      }
+      if (rx_type == CES_CMDIF_TYPE_BAUD && rx_length == 4)
+      {
+        request_baud((uint32_t)rx_payload[0] | (uint32_t)rx_payload[1] << 8
+                     | (uint32_t)rx_payload[2] << 16 | (uint32_t)rx_payload[3] << 24);
+      }
+      else if (rx_type == CES_CMDIF_TYPE_COMMAND && commands != NULL)
+      {
+        commands->receive(rx_payload, rx_length < SERIAL_RX_PAYLOAD_MAX ? rx_length : SERIAL_RX_PAYLOAD_MAX);
+      }
+      break;
+    }
+  }
+}
+
+// Answer with the rate that will be used; service() sends it next
+// A request while the last change is still going out is ignored
+void serial_transport::request_baud(uint32_t baud)
+{
+  if (switch_baud != 0 || (tx_bytes != NULL && !tx_from_queue))
+  {
+    return;
+  }
+  uint32_t answer = current_baud;
+  for (uint8_t i = 0; i < sizeof(serial_baud_rates) / sizeof(serial_baud_rates[0]); i++)
+  {
+    if (serial_baud_rates[i] == baud)
+    {
+      answer = baud;
+    }
+  }
+  baud_answer.header.start_1 = CES_CMDIF_PKT_START_1;
+  baud_answer.header.start_2 = CES_CMDIF_PKT_START_2;
+  baud_answer.header.length_lsb = sizeof(baud_answer.baud);
+  baud_answer.header.length_msb = 0;
+  baud_answer.header.type = CES_CMDIF_TYPE_BAUD;
+  baud_answer.baud = answer;
+  baud_answer.footer.stop_1 = CES_CMDIF_PKT_STOP_1;
+  baud_answer.footer.stop_2 = CES_CMDIF_PKT_STOP_2;
+  answer_due = true;
+}
+
+// After the answer, nothing more is written until the FIFO is empty,
+// then the last byte is given time to leave the shift register - also
+// when the rate stays the same, so the host can treat every answer alike
+bool serial_transport::switch_when_drained()
+{
+  if (Serial.availableForWrite() < SERIAL_TX_FIFO_FREE)
+  {
+    return false;
+  }
+  delayMicroseconds(10000000UL / current_baud + 1);
+  Serial.updateBaudRate(switch_baud);
+  current_baud = switch_baud;
+  switch_baud = 0;
+  baud_changes++;
+  return true;
+}
+
+bool serial_transport::service(packet_scheduler *scheduler)
+{
+  receive();
+  bool wrote = false;
+  for (;;)
+  {
+    if (tx_bytes == NULL)
+    {
+      if (switch_baud != 0 && !switch_when_drained())
+      {
+        break;
+      }
+      if (answer_due)
+      {
+        answer_due = false;
+        tx_bytes = (const uint8_t *)&baud_answer;
+        tx_length = sizeof(baud_answer);
+        tx_from_queue = false;
+      }
+      else
+      {
+        serial_packet *packet = scheduler->next();
+        if (packet == NULL)
+        {
+          break;
+        }
+        tx_bytes = packet->bytes;
+        tx_length = packet->length;
+        tx_from_queue = true;
+      }
+      tx_offset = 0;
+    }
+
+    int room = Serial.availableForWrite();
+    if (room <= 0)
+    {
+      tx_full++;
+      break;
+    }
+    uint16_t count = tx_length - tx_offset;
+    if (count > (uint16_t)room)
+    {
+      count = room;
+    }
+    Serial.write(tx_bytes + tx_offset, count);
+    tx_offset += count;
+    bytes_sent += count;
+    wrote = true;
+    if (tx_offset < tx_length)
+    {
+      continue;
+    }
+
+    if (tx_from_queue)
+    {
+      scheduler->sent();
+      frames_sent++;
+    }
+    else
+    {
+      switch_baud = baud_answer.baud;
+    }
+    tx_bytes = NULL;
+  }
+  return wrote;
+}
@@ -0,0 +1,98 @@
+/***************************************************************
+//   Serial transport - the output stage's side of the UART
+//
+//   service() hands queued frames to the UART no faster than its TX
+//   FIFO takes them: it writes what Serial.availableForWrite() says
+//   will fit, keeps its place in a frame that did not fit, and returns
+//   so the caller is never held up waiting for the line. While it waits
+//   the frames build up in the packet scheduler's queue, which drops
+//   (and counts) waveform frames when that fills.
+//
+//   The port opens at the rate begin() is given. The host can then ask
+//   for any rate in the table in serial_transport.cpp, up to 1 Mbaud,
+//   with a CES_CMDIF_TYPE_BAUD frame (serial_frame.h). The answer goes
+//   out in place of the next frame, and the rate changes once the TX
+//   FIFO has emptied, so no frame straddles the change. A rate not in
+//   the table is answered with the current one.
+//
+//   The ESP32 Arduino core 1.0.6 UART has no TX buffer beyond the 128
+//   byte FIFO, so a service() pass moves at most 127 bytes. The output
+//   task sleeps OUTPUT_TASK_IDLE_MS (one tick) when a pass found the
+//   FIFO full, which caps the sustained rate at about 127 kB/s - the
+//   line rate of 1.27 Mbaud. That is why the table stops at 1 Mbaud,
+//   which the stage keeps full; 1.5 Mbaud and up would run at 85% of
+//   the line or less.
+//
+//   CES_CMDIF_TYPE_COMMAND frames are passed to the command_channel
+//   given to attach(), which answers them from the processing stage.
+//
+//   Counters are written only by the output stage; other stages read
+//   them through link_status().
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef serial_transport_h
+#define serial_transport_h
+
+#include "Arduino.h"
+#include "serial_frame.h"
+#include "packet_scheduler.h"
+
+class command_channel;
+
+// availableForWrite() with the TX FIFO empty on the ESP32
+#define SERIAL_TX_FIFO_FREE   127
+// Bytes of a host to device frame kept while it is read
+#define SERIAL_RX_PAYLOAD_MAX 16
+
+class serial_transport
+{
+  public:
+    serial_transport();
+    void begin(unsigned long baud);
+    // Where host commands go - none are acted on until this is called
+    void attach(command_channel *channel) { commands = channel; }
+
+    // Output stage - read any request from the host, then write as much
+    // of the queued frames as the TX FIFO will take. True if it wrote.
+    bool service(packet_scheduler *scheduler);
+
+    unsigned long baud() const { return current_baud; }
+    // Counters for the status frame
+    void link_status(status_payload *out) const;
+
+    uint32_t bytes_sent;
+    uint32_t frames_sent;
+    uint32_t tx_full;         // passes that stopped on a full FIFO
+    uint32_t baud_changes;    // answers acted on
+
+  private:
+    void receive();
+    void request_baud(uint32_t baud);
+    bool switch_when_drained();
+
+    unsigned long current_baud;
+    command_channel *commands;
+
+    // Frame being written, and how much of it has gone
+    const uint8_t *tx_bytes;
+    uint16_t tx_length;
+    uint16_t tx_offset;
+    bool tx_from_queue;
+
+    // Baud change - the answer, then the switch once it has drained
+    baud_frame baud_answer;
+    bool answer_due;
+    unsigned long switch_baud;
+
+    // Host to device frame being read
+    uint8_t rx_state;
+    uint8_t rx_type;
+    uint16_t rx_length;
+    uint16_t rx_index;
+    uint8_t rx_payload[SERIAL_RX_PAYLOAD_MAX];
+};
+
+#endif
@@ -0,0 +1,204 @@
+/***************************************************************
+//   Sliding DFT over a band of bins
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "sliding_dft.h"
+
+#define SDFT_DECAY  (1.0 - 1.0 / 1048576.0)
+
+sliding_dft::sliding_dft()
+{
+  output_sps = 1;
+  decimate = 1;
+  length = 0;
+  first_bin = 0;
+  state_bins = 0;
+  decay = 1;
+  decay_length = 1;
+  reset();
+}
+
+bool sliding_dft::init(float input_sps, uint8_t decimate, uint16_t length, float lo_hz, float hi_hz)
+{
+  if (decimate == 0 || length < 4 || length > SDFT_MAX_LENGTH)
+  {
+    return false;
+  }
+  float sps = input_sps / decimate;
+  float bin_hz = sps / length;
+  int lo = (int)(lo_hz / bin_hz);
+  int hi = (int)(hi_hz / bin_hz + 0.999f);
+  // The band's neighbours are in the state too, and the one below must
+  // not be 0 Hz - the Hann window would bring the DC into the band
+  if (lo < 2 || hi < lo || hi >= length / 2 || hi - lo + 3 > SDFT_MAX_BINS)
+  {
+    return false;
+  }
+  this->output_sps = sps;
+  this->decimate = decimate;
+  this->length = length;
+  first_bin = lo - 1;
+  state_bins = hi - lo + 3;
+  decay = SDFT_DECAY;
+  decay_length = pow(SDFT_DECAY, length);
+  // Rotations worked out in double, once
+  for (int j = 0; j < state_bins; j++)
+  {
+    double phase = 2.0 * PI * (first_bin + j) / length;
+    rotate_re[j] = cos(phase);
+    rotate_im[j] = sin(phase);
+  }
+  reset();
+  return true;
+}
+
+void sliding_dft::reset()
+{
+  memset(integrator, 0, sizeof(integrator));
+  memset(comb, 0, sizeof(comb));
+  block_count = 0;
+  memset(history, 0, sizeof(history));
+  head = 0;
+  filled = 0;
+  memset(bin_re, 0, sizeof(bin_re));
+  memset(bin_im, 0, sizeof(bin_im));
+}
+
+bool sliding_dft::push(int32_t sample)
+{
+  if (length == 0)
+  {
+    return false;
+  }
+  uint32_t x = (uint32_t)sample;
+  for (int i = 0; i < SDFT_CIC_ORDER; i++)
+  {
+    integrator[i] += x;
+    x = integrator[i];
+  }
+  if (++block_count < decimate)
+  {
+    return false;
+  }
+  block_count = 0;
+  for (int i = 0; i < SDFT_CIC_ORDER; i++)
+  {
+    uint32_t delayed = comb[i];
+    comb[i] = x;
+    x -= delayed;
+  }
+  float in = (float)(int32_t)x / ((float)decimate * decimate);
+
+  // The sample leaving the window - 0 until it is full
+  float out = history[head];
+  history[head] = in;
+  head = (head + 1 == length) ? 0 : head + 1;
+  if (filled < length)
+  {
+    filled++;
+  }
+  float change = in - decay_length * out;
+  for (int j = 0; j < state_bins; j++)
+  {
+    float re = decay * bin_re[j] + change;
+    float im = decay * bin_im[j];
+    bin_re[j] = re * rotate_re[j] - im * rotate_im[j];
+    bin_im[j] = re * rotate_im[j] + im * rotate_re[j];
+  }
+  return true;
+}
+
+bool sliding_dft::full() const
+{
+  return length > 0 && filled >= length;
+}
+
+uint8_t sliding_dft::bins() const
+{
+  return state_bins > 2 ? state_bins - 2 : 0;
+}
+
+float sliding_dft::frequency(uint8_t i) const
+{
+  return (first_bin + 1 + i) * output_sps / length;
+}
+
+void sliding_dft::windowed(uint8_t j, float *re, float *im) const
+{
+  *re = 0.5f * bin_re[j] - 0.25f * (bin_re[j - 1] + bin_re[j + 1]);
+  *im = 0.5f * bin_im[j] - 0.25f * (bin_im[j - 1] + bin_im[j + 1]);
+}
+
+float sliding_dft::power(uint8_t i) const
+{
+  float re, im;
+  windowed(i + 1, &re, &im);
+  return re * re + im * im;
+}
+
+float sliding_dft::peak(int16_t *share, float *amplitude) const
+{
+  uint8_t count = bins();
+  float band_power = 0;
+  int peak_bin = 0;
+  for (int i = 0; i < count; i++)
+  {
+    band_power += power(i);
+  }
+  // Only inside the band, where both neighbours are known
+  for (int i = 1; i + 1 < count; i++)
+  {
+    float p = power(i);
+    if (p > power(i - 1) && p >= power(i + 1) && (peak_bin == 0 || p > power(peak_bin)))
+    {
+      peak_bin = i;
+    }
+  }
+  if (peak_bin == 0 || band_power <= 0)
+  {
+    if (share != NULL)
+    {
+      *share = 0;
+    }
+    if (amplitude != NULL)
+    {
+      *amplitude = 0;
+    }
+    return 0;
+  }
+  // Parabola through the peak and its neighbours
+  float a = power(peak_bin - 1), b = power(peak_bin), c = power(peak_bin + 1);
+  float delta = 0.5f * (a - c) / (a - 2.0f * b + c);
+  if (share != NULL)
+  {
+    float s = 100.0f * (a + b + c) / band_power;
+    *share = (int16_t)(s > 100.0f ? 100.0f : s);
+  }
+  // A sine wave of amplitude A on a bin gives the Hann windowed bin
+  // A length / 4 and each neighbour half that, 1.5 (A length / 4)^2 in
+  // all, and about the same between bins
+  if (amplitude != NULL)
+  {
+    *amplitude = 4.0f * sqrtf((a + b + c) / 1.5f) / length;
+  }
+  return frequency(peak_bin) + delta * output_sps / length;
+}
+
+int16_t sliding_dft::rate(int16_t min_share, float min_amplitude) const
+{
+  if (!full())
+  {
+    return 0;
+  }
+  int16_t share;
+  float amplitude;
+  float hz = peak(&share, &amplitude);
+  if (share < min_share || amplitude < min_amplitude)
+  {
+    return 0;
+  }
+  return (int16_t)(hz * 60.0f + 0.5f);
+}
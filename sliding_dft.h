@@ -0,0 +1,95 @@
+/***************************************************************
+//   Sliding DFT over a band of bins
+//
+//   Keeps the DFT of the last length samples up to date one sample at a
+//   time, for only the bins of a band - the heart rate or respiration
+//   band is a few dozen bins of a spectrum of hundreds. Each new sample
+//   x[n] moves bin k on by
+//     X[k] = e^(j 2 pi k / length) (r X[k] + x[n] - r^length x[n - length])
+//   a complex multiply and two adds a bin, so the spectrum is there at
+//   any time with no batch transform, at a small fixed cost a sample.
+//   r is a hair under 1 (1 - 2^-20): with r = 1 a float rounding error
+//   would stay in a bin for ever, with r below 1 it dies away over about
+//   a million samples. It weights the window by r^age, under 0.03% over
+//   a window, which the spectrum does not notice.
+//
+//   power() and peak() are Hann windowed, from a bin and its neighbours
+//   (0.5 X[k] - 0.25 (X[k-1] + X[k+1])), so one bin either side of the
+//   band is kept too. The input can be brought down first by decimate
+//   through a two stage CIC (two cascaded decimate sample averages), so
+//   a window of tens of seconds of a fast input fits in SDFT_MAX_LENGTH.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef sliding_dft_h
+#define sliding_dft_h
+
+#include "Arduino.h"
+
+#define SDFT_MAX_LENGTH   256
+#define SDFT_MAX_BINS     40      // the band and one bin either side
+#define SDFT_CIC_ORDER    2
+
+class sliding_dft
+{
+  public:
+    sliding_dft();
+    // A window of length samples (at most SDFT_MAX_LENGTH) at
+    // input_sps / decimate, and the bins from lo_hz to hi_hz. false if
+    // that does not fit, or the band starts within two bins of 0 Hz
+    bool init(float input_sps, uint8_t decimate, uint16_t length, float lo_hz, float hi_hz);
+    // Forget all samples, as after init
+    void reset();
+    // One input sample - true when the spectrum moved on, every
+    // decimate samples
+    bool push(int32_t sample);
+
+    // A whole window is in - before that the spectrum is of fewer samples
+    bool full() const;
+    // Bins in the band
+    uint8_t bins() const;
+    // Frequency of band bin i, Hz
+    float frequency(uint8_t i) const;
+    // Hann windowed power of band bin i
+    float power(uint8_t i) const;
+    // The largest local peak inside the band (not its end bins),
+    // interpolated between bins, in Hz - 0 if there is none. share, if
+    // not NULL, is the percent of the band's power in the peak and its
+    // two neighbours, and amplitude, if not NULL, the amplitude in input
+    // counts of a sine wave that would give them that power
+    float peak(int16_t *share, float *amplitude = NULL) const;
+    // The peak in cycles a minute, rounded - 0 until a whole window is
+    // in, or if the peak holds under min_share percent of the band or
+    // is of a sine wave under min_amplitude counts
+    int16_t rate(int16_t min_share, float min_amplitude = 0) const;
+
+  private:
+    // Hann windowed bin j of the state (band bin j - 1)
+    void windowed(uint8_t j, float *re, float *im) const;
+
+    float output_sps;
+    uint8_t decimate;
+    uint16_t length;
+    // Bin number of state bin 0, one below the band
+    uint16_t first_bin;
+    // State bins, the band and one either side
+    uint8_t state_bins;
+    float decay, decay_length;
+
+    // CIC integrators at the input rate and combs at the output rate -
+    // unsigned, as the integrators are meant to wrap
+    uint32_t integrator[SDFT_CIC_ORDER];
+    uint32_t comb[SDFT_CIC_ORDER];
+    uint8_t block_count;
+    // The last length decimated samples, oldest at head
+    float history[SDFT_MAX_LENGTH];
+    uint16_t head;
+    uint16_t filled;
+
+    float rotate_re[SDFT_MAX_BINS], rotate_im[SDFT_MAX_BINS];
+    float bin_re[SDFT_MAX_BINS], bin_im[SDFT_MAX_BINS];
+};
+
+#endif
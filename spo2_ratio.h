@@ -0,0 +1,31 @@
+/***************************************************************
+//   The ratio of ratios R of one cardiac cycle, as estimate_spo2 and
+//   spo2_stream hold it
+//
+//   SPO2_FIXED_POINT 1 keeps R as a Q15 int32 and works SpO2 and heart
+//   rate out in integers only, leaving the FPU to the FFT; 0 keeps R*100
+//   in a float as the original code did. See myoximeter_algorithm.h
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef spo2_ratio_h
+#define spo2_ratio_h
+
+#include "Arduino.h"
+
+#ifndef SPO2_FIXED_POINT
+#define SPO2_FIXED_POINT 1
+#endif
+
+// Fraction bits of the fixed point R
+#define SPO2_R_SHIFT     15
+
+#if SPO2_FIXED_POINT
+typedef int32_t spo2_ratio;     // R in Q15
+#else
+typedef float spo2_ratio;       // R*100
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/***************************************************************
+//   Streaming SpO2 and heart rate from the decimated oximeter samples
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#include "spo2_stream.h"
+#include "myAFE4490_Oximeter.h"
+#include "myoximeter_algorithm.h"
+
+#define SPO2_STREAM_MASK      (SPO2_STREAM_WINDOW - 1)
+#define SPO2_STREAM_BEAT_MASK (SPO2_STREAM_BEATS - 1)
+
+spo2_stream::spo2_stream()
+{
+  reset();
+}
+
+void spo2_stream::reset()
+{
+  heart_rate = 0;
+  spo2 = 0;
+  hr_valid = false;
+  spo2_valid = false;
+  sample_max = 0;
+  sample_min = 0;
+  threshold = 0;
+  count = 0;
+  max_head = max_tail = min_head = min_tail = 0;
+  memset(ma, 0, sizeof(ma));
+  ma_sum = 0;
+  // The first sample is not a crossing - the signal has to fall below first
+  above = true;
+  beat_head = beat_tail = 0;
+  cycle_open = false;
+  cycle_min_ir = cycle_max_ir = 0;
+  cycle_min_red = cycle_max_red = 0;
+}
+
+// The front of each deque leaves once it is out of the window, then
+// newest sample count - 1 joins the back after the samples it outdoes
+// leave. Expiring first keeps a deque to SPO2_STREAM_WINDOW entries, so
+// the new one never lands on the front. The fronts are then the window's
+// maximum and minimum
+void spo2_stream::track_extremes(uint16_t ir)
+{
+  uint32_t n = count - 1;
+  if (max_tail != max_head && n - max_deque[max_head & SPO2_STREAM_MASK] >= SPO2_STREAM_WINDOW)
+  {
+    max_head++;
+  }
+  if (min_tail != min_head && n - min_deque[min_head & SPO2_STREAM_MASK] >= SPO2_STREAM_WINDOW)
+  {
+    min_head++;
+  }
+  while (max_tail != max_head && ir_window[max_deque[(max_tail - 1) & SPO2_STREAM_MASK] & SPO2_STREAM_MASK] <= ir)
+  {
+    max_tail--;
+  }
+  max_deque[max_tail++ & SPO2_STREAM_MASK] = n;
+  while (min_tail != min_head && ir_window[min_deque[(min_tail - 1) & SPO2_STREAM_MASK] & SPO2_STREAM_MASK] >= ir)
+  {
+    min_tail--;
+  }
+  min_deque[min_tail++ & SPO2_STREAM_MASK] = n;
+
+  sample_max = ir_window[max_deque[max_head & SPO2_STREAM_MASK] & SPO2_STREAM_MASK];
+  sample_min = ir_window[min_deque[min_head & SPO2_STREAM_MASK] & SPO2_STREAM_MASK];
+  // right shift to divide by 2
+  threshold = (uint16_t)((sample_max - sample_min) >> 1);
+}
+
+bool spo2_stream::push(uint16_t ir, uint16_t red)
+{
+  uint32_t n = count++;
+  ir_window[n & SPO2_STREAM_MASK] = ir;
+  track_extremes(ir);
+
+  // Beats that have left the window no longer count towards the rate
+  while (beat_head != beat_tail && n - beats[beat_head & SPO2_STREAM_BEAT_MASK] >= SPO2_STREAM_WINDOW)
+  {
+    beat_head++;
+  }
+
+  // 4 pt Moving Average - noise reduction
+  ma_sum -= ma[n % SPO2_STREAM_MA_SIZE];
+  ma[n % SPO2_STREAM_MA_SIZE] = ir;
+  ma_sum += ir;
+
+  bool updated = false;
+  bool crossed = false;
+  if (count >= SPO2_STREAM_MA_SIZE)
+  {
+    uint16_t smoothed = (uint16_t)(ma_sum / SPO2_STREAM_MA_SIZE);
+    bool now_above = smoothed >= (uint16_t)(sample_min + threshold);
+    crossed = now_above && !above;
+    above = now_above;
+  }
+  if (crossed)
+  {
+    updated = beat();
+    // The crossing sample starts the next cycle
+    cycle_open = true;
+    cycle_min_ir = cycle_max_ir = ir;
+    cycle_min_red = cycle_max_red = red;
+  }
+  else if (cycle_open)
+  {
+    if (ir < cycle_min_ir)
+    {
+      cycle_min_ir = ir;
+      cycle_min_red = red;
+    }
+    if (ir > cycle_max_ir)
+    {
+      cycle_max_ir = ir;
+      cycle_max_red = red;
+    }
+  }
+
+  if (!updated && beat_head == beat_tail && count >= SPO2_STREAM_WINDOW && (hr_valid || spo2_valid))
+  {
+    beats_stopped();
+    updated = true;
+  }
+  return updated;
+}
+
+// A beat at sample count - 1 - true if the estimate is published
+bool spo2_stream::beat()
+{
+  uint32_t n = count - 1;
+  if (beat_tail - beat_head == SPO2_STREAM_BEATS)
+  {
+    beat_head++;
+  }
+  beats[beat_tail & SPO2_STREAM_BEAT_MASK] = n;
+  // R = (ACred/DCred)/(ACir/DCir) over the cycle this beat closes
+  ratios[beat_tail & SPO2_STREAM_BEAT_MASK] = cycle_open
+      ? spo2_algorithm::cycle_ratio(cycle_max_ir - cycle_min_ir, cycle_min_ir,
+                                    cycle_max_red - cycle_min_red, cycle_min_red)
+      : -1;
+  beat_tail++;
+  if (count < SPO2_STREAM_WINDOW)
+  {
+    return false;
+  }
+
+  // Average distance between the beats in the window
+  uint32_t n_beats = beat_tail - beat_head;
+  if (n_beats >= SPO2_STREAM_MIN_BEATS && n_beats <= SPO2_STREAM_MAX_BEATS)
+  {
+    uint32_t span = n - beats[beat_head & SPO2_STREAM_BEAT_MASK];
+    heart_rate = (int16_t)((SPO2_STREAM_SPS * 60 * (n_beats - 1)) / span);
+    hr_valid = true;
+  }
+  else
+  {
+    heart_rate = 0;
+    hr_valid = false;
+  }
+
+  // R of the last few cycles in the window, combined as estimate_spo2
+  // does - the minimum is taken as DC
+  int lookup = SPO2_TABLE_SIZE;
+  spo2_ratio window_ratios[SPO2_STREAM_RATIO_CYCLES];
+  int n_ratios = 0;
+  uint32_t first = (n_beats > SPO2_STREAM_RATIO_CYCLES) ? beat_tail - SPO2_STREAM_RATIO_CYCLES : beat_head;
+  for (uint32_t b = first; b != beat_tail; b++)
+  {
+    if (ratios[b & SPO2_STREAM_BEAT_MASK] >= 0)
+    {
+      window_ratios[n_ratios++] = ratios[b & SPO2_STREAM_BEAT_MASK];
+    }
+  }
+  spo2_ratio R = spo2_algorithm::combine_ratios(window_ratios, n_ratios);
+  if (R >= 0)
+  {
+    lookup = spo2_algorithm::ratio_index(R);
+  }
+  if (lookup > 1 && lookup < SPO2_TABLE_SIZE)
+  {
+    spo2 = spo2_algorithm::uch_spo2_table[lookup];
+    spo2_valid = true;
+  }
+  else
+  {
+    spo2 = 0;
+    spo2_valid = false;
+  }
+  return true;
+}
+
+void spo2_stream::beats_stopped()
+{
+  heart_rate = 0;
+  spo2 = 0;
+  hr_valid = false;
+  spo2_valid = false;
+}
@@ -0,0 +1,98 @@
+/***************************************************************
+//   Streaming SpO2 and heart rate from the decimated oximeter samples
+//
+//   The same estimate as spo2_algorithm::estimate_spo2, kept up to date
+//   one 25 SPS sample at a time rather than recomputed over a whole
+//   buffer every 5 s. For the last SPO2_STREAM_WINDOW IR samples it
+//   holds:
+//     the minimum and maximum, in two monotonic deques of sample
+//     numbers - each sample goes in and out once, so constant time
+//     per sample however the signal moves
+//     a 4 point moving average from a running sum
+//     the sample numbers of the rising crossings of the moving average
+//     through halfway between the minimum and maximum (the beats)
+//   and, since the last beat, the IR minimum and maximum with the RED
+//   values at the same samples.
+//
+//   At each beat the heart rate is worked out from the beats in the
+//   window (at least 4, as estimate_spo2), and SpO2 from the ratio of
+//   ratios of the last SPO2_STREAM_RATIO_CYCLES cycles in the window -
+//   the mean of those near their median, as estimate_spo2 - through the
+//   same lookup table. push() returns true then. One odd cycle is
+//   outvoted, and a real desaturation shows once it has lasted 3 beats
+//   rather than after up to 5 s. If no beat comes for a whole window
+//   both go invalid. Nothing is published until the first window is
+//   full.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef spo2_stream_h
+#define spo2_stream_h
+
+#include "Arduino.h"
+#include "spo2_ratio.h"
+
+// Samples the minimum, maximum and heart rate look back over - about
+// 5 s at 25 SPS, as the batch buffer. A power of 2
+#define SPO2_STREAM_WINDOW      128
+#define SPO2_STREAM_SPS         25
+#define SPO2_STREAM_MA_SIZE     4
+// Beats kept - more than estimate_spo2 accepts in a window
+#define SPO2_STREAM_BEATS       16
+#define SPO2_STREAM_MIN_BEATS   4
+#define SPO2_STREAM_MAX_BEATS   14
+// Cycles whose R values are combined - the median of 5 moves after 3
+#define SPO2_STREAM_RATIO_CYCLES 5
+
+class spo2_stream
+{
+  public:
+    spo2_stream();
+    // Forget all samples, as at power up
+    void reset();
+    // Add one decimated IR/RED pair - true when the estimate below has
+    // changed (a beat, or the beats stopping)
+    bool push(uint16_t ir, uint16_t red);
+
+    // Latest estimate - 0 while not valid
+    int16_t heart_rate;
+    int16_t spo2;
+    bool hr_valid;
+    bool spo2_valid;
+    // IR over the window, as estimate_spo2 reports them
+    uint16_t sample_max;
+    uint16_t sample_min;
+    uint16_t threshold;
+
+  private:
+    void track_extremes(uint16_t ir);
+    bool beat();
+    void beats_stopped();
+
+    // Samples pushed since reset - sample numbers count from 0
+    uint32_t count;
+    uint16_t ir_window[SPO2_STREAM_WINDOW];
+    // Sample numbers with falling (max) and rising (min) IR values
+    uint32_t max_deque[SPO2_STREAM_WINDOW];
+    uint32_t min_deque[SPO2_STREAM_WINDOW];
+    uint32_t max_head, max_tail, min_head, min_tail;
+
+    uint16_t ma[SPO2_STREAM_MA_SIZE];
+    uint32_t ma_sum;
+    bool above;
+
+    // Sample numbers of the beats, oldest at beat_head, and R*100 of the
+    // cycle each one closed (-1 if there was none or it had no AC)
+    uint32_t beats[SPO2_STREAM_BEATS];
+    spo2_ratio ratios[SPO2_STREAM_BEATS];
+    uint32_t beat_head, beat_tail;
+
+    // The cycle since the last beat
+    bool cycle_open;
+    uint16_t cycle_min_ir, cycle_max_ir;
+    uint16_t cycle_min_red, cycle_max_red;
+};
+
+#endif
@@ -0,0 +1,159 @@
+/***************************************************************
+//   Single producer / single consumer ring buffer
+//
+//   One context pushes (an interrupt, the SPI bus task), one other
+//   context pops (loop() or a processing task), and neither ever waits
+//   or takes a lock. The head index is written only by the producer and
+//   the tail only by the consumer; release/acquire ordering on them
+//   makes an item visible before the index that publishes it.
+//
+//   - N is a power of two. The indices run freely and are masked on
+//     use, so all N slots hold data and full/empty need no spare slot.
+//   - Head and tail sit on separate cache lines so the two sides do not
+//     keep taking the line from each other.
+//   - A push to a full ring is refused and counted in overruns(), so a
+//     consumer that falls behind loses the newest samples visibly
+//     rather than silently.
+//   - write_slot()/commit() and read_slot()/release() fill and use an
+//     item where it sits in the ring, so it is built once and never
+//     copied in or out.
+//
+//   This software is licensed under the MIT License(http://opensource.org/licenses/MIT).
+//
+/////////////////////////////////////////////////////////////////////////////////////*/
+
+#ifndef spsc_ring_h
+#define spsc_ring_h
+
+#include "Arduino.h"
+#include <atomic>
+
+// The ESP32 caches are 32 byte lines, hosts 64
+#if defined(ARDUINO_ARCH_ESP32)
+#define SPSC_CACHE_LINE 32
+#else
+#define SPSC_CACHE_LINE 64
+#endif
+
+template <typename T, uint32_t N>
+class spsc_ring
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "spsc_ring size must be a power of two");
+
+  public:
+    spsc_ring() : head(0), pushed_count(0), overrun_count(0), tail(0)
+    {
+    }
+
+    // Producer side - false (and an overrun) if the ring is full
+    bool push(const T &item)
+    {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == N)
+      {
+        overrun_count.store(overrun_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+      items[h & (N - 1)] = item;
+      head.store(h + 1, std::memory_order_release);
+      pushed_count.store(pushed_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    // Consumer side - false if the ring is empty
+    bool pop(T *item)
+    {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t)
+      {
+        return false;
+      }
+      *item = items[t & (N - 1)];
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side - up to max items in one go, returns how many
+    uint32_t pop_block(T *out, uint32_t max)
+    {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      uint32_t count = head.load(std::memory_order_acquire) - t;
+      if (count > max)
+      {
+        count = max;
+      }
+      for (uint32_t i = 0; i < count; i++)
+      {
+        out[i] = items[(t + i) & (N - 1)];
+      }
+      tail.store(t + count, std::memory_order_release);
+      return count;
+    }
+
+    // Producer side, in place - the next free slot to fill, then commit()
+    // to publish it. NULL (and an overrun) if the ring is full
+    T *write_slot()
+    {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == N)
+      {
+        overrun_count.store(overrun_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return NULL;
+      }
+      return &items[h & (N - 1)];
+    }
+    void commit()
+    {
+      head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      pushed_count.store(pushed_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Consumer side, in place - the oldest item, then release() once it
+    // is no longer needed. NULL if the ring is empty
+    T *read_slot()
+    {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t)
+      {
+        return NULL;
+      }
+      return &items[t & (N - 1)];
+    }
+    void release()
+    {
+      tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Items waiting - exact from the consumer, a snapshot from elsewhere
+    uint32_t size() const
+    {
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() == N; }
+    static uint32_t capacity() { return N; }
+
+    // Items accepted and refused since the last reset
+    uint32_t pushed() const { return pushed_count.load(std::memory_order_relaxed); }
+    uint32_t overruns() const { return overrun_count.load(std::memory_order_relaxed); }
+
+    // Only while neither side is running
+    void reset()
+    {
+      head.store(0, std::memory_order_relaxed);
+      tail.store(0, std::memory_order_relaxed);
+      pushed_count.store(0, std::memory_order_relaxed);
+      overrun_count.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    // Producer's line
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> head;
+    std::atomic<uint32_t> pushed_count;
+    std::atomic<uint32_t> overrun_count;
+    // Consumer's line
+    alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> tail;
+    alignas(SPSC_CACHE_LINE) T items[N];
+};
+
+#endif